@@ -0,0 +1,79 @@
+//
+//   Transfer benchmark -
+//   Sketch times a full array transfer (xfer_array) using each of the two
+//   transfer methods the library offers:
+//   1. digitalWrite - each data/clock pin write is made by digitalWrite
+//   2. fast I/O     - each data/clock pin write is made directly to the pin's
+//                     port register, resolved when the bank was created
+//
+//   For each method the sketch reports the time taken per transfer, the number
+//   of pin writes a transfer makes, as calculated from the array's size rather
+//   than counted, and the equivalent number of processor cycles per SIPO byte
+//   transferred. The host benchmark in extras/host counts the pin and port
+//   register writes and edges each method makes, and checks both send the same
+//   bits.
+//
+//   Fast I/O is available if the library is compiled with SIPO8_FAST_IO
+//   (the default on AVR, SAM and SAMD boards), otherwise both results will be
+//   for digitalWrite.
+//
+//   The SIPOs need not be connected to run this sketch.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs     32  // one bank of 32 x SIPOs, 256 output pins
+#define Max_timers     0  // no timers required
+#define num_xfers    100  // transfers timed for each method
+
+#define data_pin       8
+#define clock_pin     10
+#define latch_pin      9
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;
+
+// time num_xfers full array transfers and report the results
+void benchmark(bool fast_io) {
+  my_SIPOs.use_fast_io(fast_io);
+  uint32_t start = micros();
+  for (uint16_t xfer = 0; xfer < num_xfers; xfer++) {
+    my_SIPOs.xfer_array(MSBFIRST);
+  }
+  uint32_t duration = micros() - start;
+  // 3 pin writes per bit (data, clock high, clock low) plus 2 per bank for the latch
+  uint32_t pin_writes = 3UL * my_SIPOs.num_active_pins + 2UL * my_SIPOs.num_banks;
+  float us_per_xfer = (float)duration / num_xfers;
+  float cycles_per_byte = us_per_xfer * (F_CPU / 1000000UL) / my_SIPOs.bank_SIPO_count;
+  Serial.print(fast_io ? F("fast I/O     : ") : F("digitalWrite : "));
+  Serial.print(us_per_xfer);
+  Serial.print(F(" us/transfer, "));
+  Serial.print(pin_writes);
+  Serial.print(F(" pin writes/transfer (calculated), "));
+  Serial.print(cycles_per_byte);
+  Serial.println(F(" cycles/byte"));
+  Serial.flush();
+}
+
+void setup() {
+  Serial.begin(9600);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.set_all_array_pins(HIGH);
+  Serial.println(F("\nxfer_array benchmark:"));
+  benchmark(false);
+  benchmark(true);
+}
+
+void loop() {
+}
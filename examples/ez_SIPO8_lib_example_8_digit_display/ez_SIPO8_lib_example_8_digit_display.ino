@@ -0,0 +1,99 @@
+//
+//   8 Digit Display -
+//   Sketch drives an 8 digit, common anode, 7 segment LED display using two SIPOs:
+//   one SIPO drives the 8 digit anodes (via PNP/high side drivers, active LOW) and
+//   the other the 8 segment cathodes, a-g and DP (active LOW).
+//   The digits are multiplexed - lit one at a time, in turn - by the SIPO8_matrix
+//   driver, with scan_tick called from a 1kHz timer interrupt. Each digit is then
+//   refreshed 125 times a second, flicker free.
+//
+//   The two SIPOs share the same clock and latch pins, each on its own data pin,
+//   so form a bank group - a digit and its segments are changed by a single
+//   transfer, latched together, with no ghosting between digits.
+//
+//   loop() shows a running count of seconds, with a decimal point flashing
+//   each second, followed by the scan frame count.
+//
+//   The timer set up is for ATmega328P/2560 based boards (eg UNO, Nano, MEGA)
+//   using Timer1. For other boards, call scan_tick() from any periodic timer
+//   interrupt.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_matrix.h>
+
+#define Max_SIPOs        2  // one for the digits, one for the segments
+#define Max_timers       1
+
+#define digit_data_pin   8
+#define segment_data_pin 7
+#define clock_pin       10  // shared by both SIPOs
+#define latch_pin        9  // ...
+
+#define num_digits       8
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int digit_bank;
+int segment_bank;
+
+// digits are selected LOW and segments lit LOW, both banks created in setup
+SIPO8_matrix display(my_SIPOs, 0, 1, LOW, LOW);
+
+// Timer1 compare match interrupt, 1kHz - light the next digit
+ISR(TIMER1_COMPA_vect) {
+  display.scan_tick();
+}
+
+void setup() {
+  Serial.begin(9600);
+  digit_bank   = my_SIPOs.create_bank(digit_data_pin, clock_pin, latch_pin, 1);
+  segment_bank = my_SIPOs.create_bank(segment_data_pin, clock_pin, latch_pin, 1);
+  if (digit_bank == create_bank_failure || segment_bank == create_bank_failure) {
+    Serial.println(F("\nfailed to create banks, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  if (!display.begin(num_digits, MSBFIRST)) {
+    Serial.println(F("\nfailed to begin display, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  // Timer1, CTC mode, prescaler 64, compare match every 1ms
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = bit(WGM12) | bit(CS11) | bit(CS10);
+  OCR1A  = (F_CPU / 64 / 1000) - 1;
+  TIMSK1 = bit(OCIE1A);
+  interrupts();
+  my_SIPOs.SIPO8_start_timer(timer0);
+}
+
+void loop() {
+  static uint32_t seconds = 0;
+  static bool     dp      = false;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, 500) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    dp = !dp;
+    if (dp) seconds++;
+    // seconds in the left 4 digits, as "SSSS", then "-" and the scan frame
+    // count modulo 1000 in the right 3
+    uint32_t value = seconds;
+    for (int8_t digit = 3; digit >= 0; digit--) {
+      display.print_digit(digit, '0' + value % 10, digit == 3 && dp);
+      value = value / 10;
+    }
+    display.print_digit(4, '-', false);
+    value = display.num_scan_frames;
+    for (int8_t digit = 7; digit >= 5; digit--) {
+      display.print_digit(digit, '0' + value % 10, false);
+      value = value / 10;
+    }
+    display.show();  // post the new digits for display
+  }
+}
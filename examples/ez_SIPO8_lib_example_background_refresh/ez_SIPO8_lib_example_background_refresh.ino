@@ -0,0 +1,78 @@
+//
+//   Background refresh -
+//   Sketch drives a chaser across a bank of 4 SIPOs (32 LEDs) without making
+//   any transfers itself. Instead, the library's background refresh engine is
+//   driven from a 1kHz timer interrupt, transferring one SIPO each tick, so
+//   loop() is never held up by SIPO I/O.
+//
+//   loop() updates the pin statuses as normal and then posts them as the next
+//   refresh frame with refresh_frame(). The engine swaps to a newly posted frame
+//   only between complete refresh passes, so a partly updated frame is never
+//   shown.
+//
+//   The timer set up is for ATmega328P/2560 based boards (eg UNO, Nano, MEGA)
+//   using Timer1. For other boards, call refresh_tick() from any periodic timer
+//   interrupt.
+//
+//   This example uses relative bank addressing.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        4  // 4 x SIPOs - provides 32 output pins
+#define Max_timers       1
+
+#define data_pin         8
+#define clock_pin       10
+#define latch_pin        9
+
+#define chase_interval  50  // milli seconds between chaser steps
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;
+
+// Timer1 compare match interrupt, 1kHz - transfer the next SIPO
+ISR(TIMER1_COMPA_vect) {
+  my_SIPOs.refresh_tick();
+}
+
+void setup() {
+  Serial.begin(9600);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  if (!my_SIPOs.start_refresh(MSBFIRST, refresh_by_SIPO)) {
+    Serial.println(F("\nno memory for refresh buffers, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  // Timer1, CTC mode, prescaler 64, compare match every 1ms
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = bit(WGM12) | bit(CS11) | bit(CS10);
+  OCR1A  = (F_CPU / 64 / 1000) - 1;
+  TIMSK1 = bit(OCIE1A);
+  interrupts();
+  my_SIPOs.SIPO8_start_timer(timer0);
+}
+
+void loop() {
+  static uint16_t pin = 0;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, chase_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.set_bank_pin(bank_id, pin, LOW);
+    pin = (pin + 1) % my_SIPOs.num_pins_in_bank(bank_id);
+    my_SIPOs.set_bank_pin(bank_id, pin, HIGH);
+    my_SIPOs.refresh_frame();  // post the updated pin statuses for display
+  }
+  // ...loop() is free to do other work here
+}
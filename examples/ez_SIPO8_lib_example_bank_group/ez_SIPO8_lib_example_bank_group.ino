@@ -0,0 +1,55 @@
+//
+//   Bank group -
+//   Four banks share the same clock and latch pins, each with its own data pin,
+//   so forming a bank group. The banks of a group are shifted out in parallel,
+//   each clock pulse moving one bit into every bank, so the group takes as long to
+//   transfer as its longest bank rather than as long as all four banks together.
+//
+//   banks 0-3 - 2 x SIPOs each, 16 LEDs per bank, each bank runs a chaser
+//
+//   The data pins chosen (2-5) are all on the one port of an UNO/Nano, so with
+//   SIPO8_FAST_IO a single port write sets all four data lines for each clock pulse.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        8
+#define Max_timers       1
+
+#define clock_pin       10
+#define latch_pin        9
+
+#define chase_interval  50  // milli seconds between chaser steps
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+void setup() {
+  Serial.begin(9600);
+  for (uint8_t data_pin = 2; data_pin <= 5; data_pin++) {
+    if (my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, 2) == create_bank_failure) {
+      Serial.println(F("\nfailed to create bank, terminated"));
+      Serial.flush();
+      exit(0);
+    }
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.SIPO8_start_timer(timer0);
+}
+
+void loop() {
+  static uint8_t step = 0;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, chase_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.set_all_array_pins(LOW);
+    for (uint8_t bank = 0; bank < my_SIPOs.num_banks; bank++) {
+      // each bank's chaser is a quarter of a cycle behind the previous bank's
+      my_SIPOs.set_bank_pin(bank, (step + bank * 4) % 16, HIGH);
+    }
+    step = (step + 1) % 16;
+    my_SIPOs.xfer_array(MSBFIRST);  // all four banks in one group transfer
+  }
+}
@@ -0,0 +1,104 @@
+//
+//   Batch -
+//   Sketch takes pin updates typed into the serial monitor, collects them into a
+//   batch and applies the whole batch, with a single transfer, when an empty
+//   line is entered. Each line is one command:
+//     s bank pin   - set a bank pin HIGH
+//     c bank pin   - clear a bank pin (LOW)
+//     i bank pin   - invert a bank pin
+//     w bank SIPO value - set a bank SIPO to value (0-255)
+//     b bank value - set every SIPO of a bank to value (0-255)
+//   For example, "s 0 3", "i 1 12", "w 0 1 170" then an empty line.
+//
+//   A batch validates each bank once for a run of commands on it and merges
+//   commands on the same SIPO into one update, so suits bulk updates from a
+//   control protocol better than a call per pin.
+//
+//   Set the serial monitor's line ending to "Newline".
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        4  // 4 x SIPOs - provides 32 output pins
+#define Max_timers       0
+#define max_commands    32  // commands held in a batch
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+SIPO8::batch_command batch[max_commands];
+uint8_t num_commands = 0;
+
+void setup() {
+  Serial.begin(9600);
+  // two banks of 2 SIPOs, params are data pin, clock pin, latch pin, number of SIPOs
+  int bank0 = my_SIPOs.create_bank(8, 10, 9, 2);
+  int bank1 = my_SIPOs.create_bank(8, 10, 7, 2);
+  if (bank0 == create_bank_failure || bank1 == create_bank_failure) {
+    Serial.println(F("\nfailed to create banks, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.set_all_array_pins(LOW);
+  my_SIPOs.xfer_array(MSBFIRST);
+}
+
+// adds the command in the given line to the batch
+void add_command(char * line) {
+  int bank = 0, index = 0, value = 0;
+  SIPO8::batch_command & command = batch[num_commands];
+  switch (line[0]) {
+    case 's': command.command_op = batch_set_pin;    break;
+    case 'c': command.command_op = batch_clear_pin;  break;
+    case 'i': command.command_op = batch_invert_pin; break;
+    case 'w': command.command_op = batch_write_SIPO; break;
+    case 'b': command.command_op = batch_write_bank; break;
+    default:
+      Serial.println(F("unknown command"));
+      return;
+  }
+  if (line[0] == 'w') {
+    sscanf(line + 1, "%d %d %d", &bank, &index, &value);
+  } else if (line[0] == 'b') {
+    sscanf(line + 1, "%d %d", &bank, &value);
+  } else {
+    sscanf(line + 1, "%d %d", &bank, &index);
+  }
+  command.command_bank  = bank;
+  command.command_index = index;
+  command.command_value = value;
+  num_commands++;
+}
+
+void loop() {
+  static char line[24];
+  static uint8_t line_length = 0;
+  while (Serial.available() > 0) {
+    char next_char = Serial.read();
+    if (next_char == '\r') continue;
+    if (next_char != '\n') {
+      if (line_length < sizeof(line) - 1) line[line_length++] = next_char;
+      continue;
+    }
+    line[line_length] = '\0';
+    if (line_length == 0) {
+      // empty line - apply the batch and transfer the banks it changed
+      uint16_t num_applied = my_SIPOs.xfer_batch(batch, num_commands, MSBFIRST);
+      Serial.print(num_applied);
+      Serial.print(F(" of "));
+      Serial.print(num_commands);
+      Serial.println(F(" commands applied"));
+      num_commands = 0;
+      my_SIPOs.print_pin_statuses();
+    } else if (num_commands == max_commands) {
+      Serial.println(F("batch full, enter an empty line to apply it"));
+    } else {
+      add_command(line);
+    }
+    line_length = 0;
+  }
+}
@@ -0,0 +1,83 @@
+//
+//   Brightness -
+//   Sketch runs a brightness wave along a bank of 8 SIPOs (64 LEDs), each LED
+//   having 32 levels of brightness, using the library's binary code modulation
+//   (BCM) driven from a 4kHz timer interrupt.
+//
+//   With 5 bits of brightness a BCM cycle is 31 ticks, so at 4kHz the LEDs are
+//   refreshed 129 times a second, flicker free. Each cycle makes just 5 transfers,
+//   one per bit plane, rather than 31.
+//
+//   loop() sets each LED's brightness level and then posts the levels as the next
+//   BCM frame with bcm_frame(). A newly posted frame is shown only from the start
+//   of a complete cycle.
+//
+//   The timer set up is for ATmega328P/2560 based boards (eg UNO, Nano, MEGA)
+//   using Timer1. For other boards, call bcm_tick() from any periodic timer
+//   interrupt.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        8  // 8 x SIPOs - provides 64 output pins
+#define Max_timers       1
+
+#define data_pin         8
+#define clock_pin       10
+#define latch_pin        9
+
+#define brightness_bits  5  // 32 levels, 0-31
+#define wave_interval   30  // milli seconds between wave steps
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;
+
+// Timer1 compare match interrupt, 4kHz - continue the BCM cycle
+ISR(TIMER1_COMPA_vect) {
+  my_SIPOs.bcm_tick();
+}
+
+void setup() {
+  Serial.begin(9600);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  if (!my_SIPOs.start_bcm(brightness_bits, MSBFIRST)) {
+    Serial.println(F("\nno memory for brightness planes, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  // Timer1, CTC mode, prescaler 8, compare match every 250us
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = bit(WGM12) | bit(CS11);
+  OCR1A  = (F_CPU / 8 / 4000) - 1;
+  TIMSK1 = bit(OCIE1A);
+  interrupts();
+  my_SIPOs.SIPO8_start_timer(timer0);
+}
+
+void loop() {
+  static uint8_t phase = 0;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, wave_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    uint16_t num_pins = my_SIPOs.num_pins_in_bank(bank_id);
+    for (uint16_t pin = 0; pin < num_pins; pin++) {
+      // triangle wave, 0 up to 31 and back down over 64 steps
+      uint8_t step  = (pin + phase) % 64;
+      uint8_t level = step < 32 ? step : 63 - step;
+      my_SIPOs.set_pin_brightness(pin, level);
+    }
+    phase++;
+    my_SIPOs.bcm_frame();  // post the new levels for display
+  }
+}
@@ -0,0 +1,99 @@
+//
+//   Chain check -
+//   Sketch checks a long daisy chain of 16 SIPOs for a broken or miswired link,
+//   which otherwise silently shifts every byte beyond it to the wrong SIPO.
+//
+//   The serial output of the last SIPO of the chain (QH' of a 74HC595) is wired
+//   back to the input pin loopback_pin. At start up verify_bank shifts test bits
+//   through the chain and reports the chain length it detected and the first test
+//   byte read back changed. Then, whilst a chaser runs along the chain, loop()
+//   calls spot_check when it is otherwise idle, continuing a rolling check of the
+//   chain a few bits at a time, and runs verify_bank again if a fault is found.
+//
+//   Neither check sets the latch, so the SIPO outputs are unchanged by them.
+//
+//   This example uses relative bank addressing.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs       16  // 16 x SIPOs - provides 128 output pins
+#define Max_timers       1
+
+#define data_pin         8
+#define clock_pin       10
+#define latch_pin        9
+#define loopback_pin    11  // wired to QH' of the last SIPO of the chain
+
+#define spot_bits       16  // most test bits shifted in by each spot_check call
+#define chase_interval  50  // milli seconds between chaser steps
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;
+
+void print_chain_report(SIPO8::chain_report & report) {
+  Serial.print(F("\nchain "));
+  switch (report.chain_status) {
+    case chain_ok:
+      Serial.print(F("ok"));
+      break;
+    case chain_broken:
+      Serial.print(F("broken - no test bit read back"));
+      break;
+    case chain_wrong_length:
+      Serial.print(F("of the wrong length"));
+      break;
+    case chain_bad_data:
+      Serial.print(F("changes test bits"));
+      break;
+  }
+  Serial.print(F(", length detected (SIPOs) = "));
+  Serial.print(report.chain_SIPOs);
+  if (report.first_bad_byte != SIPO8_max_index) {
+    Serial.print(F(", first test byte read back changed = "));
+    Serial.print(report.first_bad_byte);
+  }
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(115200);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.set_bank_loopback(bank_id, loopback_pin);
+  my_SIPOs.print_SIPO_data();
+  SIPO8::chain_report report;
+  my_SIPOs.verify_bank(bank_id, report);
+  print_chain_report(report);
+  my_SIPOs.SIPO8_start_timer(timer0);  // chaser
+}
+
+void loop() {
+  static uint16_t pin = 0;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, chase_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.set_bank_pin(bank_id, pin, LOW);
+    pin = (pin + 1) % my_SIPOs.num_pins_in_bank(bank_id);
+    my_SIPOs.set_bank_pin(bank_id, pin, HIGH);
+    my_SIPOs.xfer_bank(bank_id, MSBFIRST);
+  } else {
+    // idle - continue the spot check
+    int faulty_bank = my_SIPOs.spot_check(spot_bits);
+    if (faulty_bank >= 0) {
+      Serial.print(F("\nspot check found a fault, bank "));
+      Serial.println(faulty_bank);
+      SIPO8::chain_report report;
+      my_SIPOs.verify_bank(faulty_bank, report);
+      print_chain_report(report);
+    }
+  }
+}
@@ -0,0 +1,80 @@
+//
+//   Chunked transfer -
+//   Sketch drives a chaser across a long chain of 32 SIPOs (256 LEDs) whilst
+//   echoing characters received on the serial port, without the transfers
+//   holding up the serial reads.
+//
+//   A full xfer_bank of 32 SIPOs takes some milliseconds with digitalWrite, long
+//   enough for bytes received to back up. Instead each chaser step starts a
+//   chunked transfer with xfer_begin, which loop() then advances with xfer_step,
+//   shifting out at most step_bits bits a call before getting on with its other
+//   work. The latch is only set once the whole bank has been shifted out, so the
+//   LEDs change together, as with xfer_bank.
+//
+//   The longest xfer_step call is measured and reported, as the worst case delay
+//   the transfers add to loop().
+//
+//   This example uses relative bank addressing.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs       32  // 32 x SIPOs - provides 256 output pins
+#define Max_timers       2
+
+#define data_pin         8
+#define clock_pin       10
+#define latch_pin        9
+
+#define step_bits       32  // most bits shifted out by each xfer_step call
+#define chase_interval  20  // milli seconds between chaser steps
+#define report_interval 5000
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;
+uint32_t longest_step_us = 0;
+
+void setup() {
+  Serial.begin(115200);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.SIPO8_start_timer(timer0);  // chaser
+  my_SIPOs.SIPO8_start_timer(timer1);  // report
+}
+
+void loop() {
+  static uint16_t pin = 0;
+  static bool transferring = false;
+  if (!transferring && my_SIPOs.SIPO8_timer_elapsed(timer0, chase_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.set_bank_pin(bank_id, pin, LOW);
+    pin = (pin + 1) % my_SIPOs.num_pins_in_bank(bank_id);
+    my_SIPOs.set_bank_pin(bank_id, pin, HIGH);
+    transferring = my_SIPOs.xfer_begin(bank_id, bank_id, MSBFIRST);
+  }
+  if (transferring) {
+    uint32_t start_us = micros();
+    transferring = !my_SIPOs.xfer_step(step_bits);
+    uint32_t step_us = micros() - start_us;
+    if (step_us > longest_step_us) longest_step_us = step_us;
+  }
+  // ...loop() is free to do other work here, eg
+  while (Serial.available() > 0) {
+    Serial.write(Serial.read());
+  }
+  if (my_SIPOs.SIPO8_timer_elapsed(timer1, report_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer1);
+    Serial.print(F("\nlongest xfer_step (us) = "));
+    Serial.println(longest_step_us);
+  }
+}
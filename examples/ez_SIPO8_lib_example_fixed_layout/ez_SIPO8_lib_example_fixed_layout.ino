@@ -0,0 +1,61 @@
+//
+//   Fixed layout -
+//   Sketch declares its SIPO banks at compile time with SIPO8_layout, rather than
+//   creating them at run time with create_bank, and names the pins it uses as
+//   compile time pin handles.
+//
+//   Two banks share the same data and clock pins, each with its own latch pin:
+//   bank 0 - 2 x SIPOs, 16 LEDs run as a chaser
+//   bank 1 - 1 x SIPO,  8 LEDs, of which pin 0 is a 'heart beat'
+//
+//   Because each pin handle's status byte and bit are resolved by the compiler,
+//   set_pin, invert_pin and read_pin need no run time bank/pin look ups or range
+//   checks, and a pin outside its bank is reported as a compile error.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        3
+#define Max_timers       2
+
+#define chase_interval  40  // milli seconds between chaser steps
+#define beat_interval  500  // milli seconds between heart beat changes
+
+// data pin, clock pin, latch pin, number of SIPOs - for each bank in turn
+typedef SIPO8_layout<SIPO8_bank<8, 10, 9, 2>,
+                     SIPO8_bank<8, 10, 7, 1> > my_layout;
+
+typedef my_layout::pin<1, 0> heart_beat;  // bank 1, pin 0
+
+// initiate the class for max SIPOs/timers required
+SIPO8Static<Max_SIPOs, Max_timers> my_SIPOs;
+
+void setup() {
+  Serial.begin(9600);
+  if (!my_layout::create_banks(my_SIPOs)) {
+    Serial.println(F("\nfailed to create banks, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.SIPO8_start_timer(timer0);
+  my_SIPOs.SIPO8_start_timer(timer1);
+}
+
+void loop() {
+  static uint8_t step = 0;
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, chase_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.set_bank(0, LOW);
+    my_SIPOs.set_bank_pin(0, step, HIGH);
+    step = (step + 1) % 16;
+  }
+  if (my_SIPOs.SIPO8_timer_elapsed(timer1, beat_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer1);
+    my_SIPOs.invert_pin(heart_beat());
+  }
+  my_SIPOs.xfer_dirty(MSBFIRST);  // only banks changed are transferred
+}
@@ -0,0 +1,69 @@
+//
+//   Input Bank -
+//   Sketch reads 16 push switches wired to two cascaded 74HC165 parallel in/serial
+//   out ICs (PISOs), created as an input bank, and toggles one of 16 LEDs, driven
+//   by two SIPOs, each time its switch is pressed.
+//
+//   The switches are scanned every 5 milli seconds by scan_inputs, which shifts
+//   in all PISOs in one pass and debounces every switch together - a switch must
+//   hold its new level for 4 consecutive scans (20 milli seconds) to be taken as
+//   changed. Rather than reading each switch in turn, the sketch asks only for
+//   the switches that have changed, 8 at a time, as bit masks.
+//
+//   Switches connect their PISO input to ground, with a pull up resistor, so
+//   read LOW when pressed.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        2  // 2 x SIPOs - provides 16 LEDs
+#define Max_timers       1
+#define num_PISOs        2  // 2 x PISOs - provides 16 switches
+
+#define scan_interval    5  // milli seconds between switch scans
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int LED_bank;
+int switch_bank;
+
+void setup() {
+  Serial.begin(9600);
+  // params are data pin, clock pin, latch pin, number of SIPOs
+  LED_bank = my_SIPOs.create_bank(8, 10, 9, Max_SIPOs);
+  // params are data (QH) pin, clock pin, shift/load pin, number of PISOs
+  switch_bank = my_SIPOs.create_input_bank(4, 5, 6, num_PISOs);
+  if (LED_bank == create_bank_failure || switch_bank == create_bank_failure) {
+    Serial.println(F("\nfailed to create banks, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  my_SIPOs.set_all_array_pins(LOW);
+  my_SIPOs.xfer_array(MSBFIRST);
+  my_SIPOs.scan_inputs();  // sets the switches' starting statuses
+  my_SIPOs.SIPO8_start_timer(timer0);
+}
+
+void loop() {
+  if (my_SIPOs.SIPO8_timer_elapsed(timer0, scan_interval) == elapsed) {
+    my_SIPOs.SIPO8_start_timer(timer0);
+    my_SIPOs.scan_inputs();
+    if (my_SIPOs.inputs_changed()) {
+      for (uint8_t PISO = 0; PISO < num_PISOs; PISO++) {
+        uint8_t changed = my_SIPOs.read_input_changes(switch_bank, PISO);
+        uint8_t pressed = changed & ~my_SIPOs.read_input_bank_PISO(switch_bank, PISO);
+        if (pressed) {
+          // toggle the LEDs of the switches just pressed, all 8 at once
+          uint8_t LEDs = my_SIPOs.read_bank_SIPO(LED_bank, PISO);
+          my_SIPOs.set_bank_SIPO(LED_bank, PISO, LEDs ^ pressed);
+        }
+      }
+      my_SIPOs.xfer_dirty(MSBFIRST);
+    }
+  }
+}
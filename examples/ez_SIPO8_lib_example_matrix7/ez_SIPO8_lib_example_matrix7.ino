@@ -5,13 +5,12 @@
 //
 //   This sketch drives a single 7 segment LED matrix, displaying digits
 //   from 0 to hex F, in two repeating cycles:
-//   1. cycle 1 - shifting out the most significant bit first (MSBFIRST), with each
-//      character appended with the DP character ".", eg "3."
-//   2. cycle 2 - shifting out the least significant bit first (LSBFIRST), without the DP
-//      character appended.
+//   1. cycle 1 - with each character appended with the DP character ".", eg "3."
+//   2. cycle 2 - without the DP character appended.
 //
-//   The sketch offers two methods for updating a 7 Segment LED Matrix, choice
-//   is a simple matter a preference/familiarity.
+//   The bank is created with its bit order fixed as MSBFIRST, to match the table
+//   of characters. Where a matrix's segments are not wired to the SIPO outputs in
+//   order, a wiring map given to create_bank would allow the same table to be kept.
 //
 //   This example uses relative bank addressing.
 //
@@ -33,21 +32,16 @@ SIPO8 my_SIPOs(max_SIPOs, max_timers);
 int my_matrix7;  // used to keep the SIPO bank id
 
 #define num_digits   16
-uint8_t LSB_matrix_chars[num_digits] = {
-  252, 96, 218, 242, 102, 182, 190, 224, 254, 246, 238, 62, 156, 122, 158, 142
-};
-#define LSB_DP_char 0b00000001  // "." value for LSBFIRST shiftout
-
-uint8_t MSB_matrix_chars[num_digits] = {
+uint8_t matrix_chars[num_digits] = {
   63, 6, 91, 79, 102, 109, 125, 7, 127, 111, 119, 124, 57, 94, 121, 113
 };
-#define MSB_DP_char 0b10000000  // "." value for MSBFIRST shiftout
+#define DP_char 0b10000000  // "." value
 
 void setup() {
   Serial.begin(9600);
   // create a bank of 1 SIPO using create_bank function:
-  // data pin, clock pin, latch pin, number of SIPO this bank
-  my_matrix7 = my_SIPOs.create_bank(8, 10, 9, 1); // data pin, clock pin, latch pin, number of SIPO this bank
+  // data pin, clock pin, latch pin, number of SIPO this bank, bit order
+  my_matrix7 = my_SIPOs.create_bank(8, 10, 9, 1, MSBFIRST);
   if (my_matrix7 == create_bank_failure) {
     Serial.println(F("\nfailed to create bank"));
     Serial.flush();
@@ -59,26 +53,26 @@ void setup() {
 
 void loop() {
   // keep running through the digits 0 to hex F, as defined by the
-  // bit patterns in the preset array MSB_/LSB_matrix_chars
+  // bit patterns in the preset array matrix_chars
   do {
-    // cycle 1 - MSBFIRST, with appended DP character "."
+    // cycle 1 - with appended DP character "."
     my_SIPOs.set_bank_SIPO(my_matrix7, 0, 0b00000000);  // reset all LEDs in the matrix to off/LOW
     my_SIPOs.xfer_bank(my_matrix7, MSBFIRST);
     delay(50);
     for (uint8_t digit = 0; digit < num_digits; digit++) {
-      my_SIPOs.set_bank_SIPO(my_matrix7, 0, MSB_matrix_chars[digit] + MSB_DP_char); // append "."
+      my_SIPOs.set_bank_SIPO(my_matrix7, 0, matrix_chars[digit] + DP_char); // append "."
       my_SIPOs.xfer_bank(my_matrix7, MSBFIRST);
       delay(500);
     }
-    // cycle 2 - LSBFIRST, no appended DP character
+    // cycle 2 - no appended DP character
     my_SIPOs.set_bank_SIPO(my_matrix7, 0, 0b00000000);  // reset all LEDs in the matrix to off/LOW
-    my_SIPOs.xfer_bank(my_matrix7, LSBFIRST);
+    my_SIPOs.xfer_bank(my_matrix7, MSBFIRST);
     delay(50);
     for (uint8_t digit = 0; digit < num_digits; digit++) {
-      // if DP char "." required to be appended to a char, then add 'LSB_DP_char'
-      // to the 'LSB_matrix_chars[digit]' parameter
-      my_SIPOs.set_bank_SIPO(my_matrix7, 0, LSB_matrix_chars[digit]);
-      my_SIPOs.xfer_bank(my_matrix7, LSBFIRST);
+      // if DP char "." required to be appended to a char, then add 'DP_char'
+      // to the 'matrix_chars[digit]' parameter
+      my_SIPOs.set_bank_SIPO(my_matrix7, 0, matrix_chars[digit]);
+      my_SIPOs.xfer_bank(my_matrix7, MSBFIRST);
       delay(500);
     }
   } while (true);
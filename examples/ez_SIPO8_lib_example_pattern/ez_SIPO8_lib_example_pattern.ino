@@ -0,0 +1,93 @@
+//
+//   Pattern -
+//   Sketch plays a light pattern on a bank of 2 SIPOs (16 LEDs) using the
+//   SIPO8_player. The pattern - a single LED scanning from one end of the bank
+//   to the other and back, followed by three strobe flashes of all the LEDs - is
+//   held in flash (PROGMEM) and played from there, frame by frame, so uses no RAM
+//   however long it is.
+//
+//   Each frame has its own duration. The first frame is a full frame, giving
+//   every pin status byte of the pattern. The scan frames are delta frames,
+//   giving only the bytes that differ from the frame before.
+//
+//   loop() need only call update(), which shows each frame when it is due and
+//   transfers just the SIPOs changed.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_pattern.h>
+
+#define Max_SIPOs        2  // 2 x SIPOs - provides 16 output pins
+#define Max_timers       0
+
+#define scan_ms         40  // milli seconds per scan step
+#define strobe_ms       60  // milli seconds per strobe on/off
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+SIPO8_player my_player(my_SIPOs);
+
+const uint8_t scan_and_strobe[] PROGMEM = {
+  pattern_version, 2, pattern_uint16(36),  // 2 pin status bytes, 36 frames
+  pattern_full_frame,  pattern_uint16(scan_ms), 0x01, 0x00,  // LED 0
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x02,  // LED 1
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x04,  // LED 2
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x08,  // LED 3
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x10,  // LED 4
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x20,  // LED 5
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x40,  // LED 6
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x80,  // LED 7
+  pattern_delta_frame, pattern_uint16(scan_ms), 2, 0, 0x00, 1, 0x01,  // LED 8
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x02,  // LED 9
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x04,  // LED 10
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x08,  // LED 11
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x10,  // LED 12
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x20,  // LED 13
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x40,  // LED 14
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x80,  // LED 15
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x40,  // LED 14
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x20,  // LED 13
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x10,  // LED 12
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x08,  // LED 11
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x04,  // LED 10
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x02,  // LED 9
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 1, 0x01,  // LED 8
+  pattern_delta_frame, pattern_uint16(scan_ms), 2, 0, 0x80, 1, 0x00,  // LED 7
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x40,  // LED 6
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x20,  // LED 5
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x10,  // LED 4
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x08,  // LED 3
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x04,  // LED 2
+  pattern_delta_frame, pattern_uint16(scan_ms), 1, 0, 0x02,  // LED 1
+  pattern_full_frame,  pattern_uint16(strobe_ms), 0xFF, 0xFF,  // strobe 1
+  pattern_full_frame,  pattern_uint16(strobe_ms), 0x00, 0x00,
+  pattern_full_frame,  pattern_uint16(strobe_ms), 0xFF, 0xFF,  // strobe 2
+  pattern_full_frame,  pattern_uint16(strobe_ms), 0x00, 0x00,
+  pattern_full_frame,  pattern_uint16(strobe_ms), 0xFF, 0xFF,  // strobe 3
+  pattern_full_frame,  pattern_uint16(strobe_ms * 4), 0x00, 0x00
+};
+
+void setup() {
+  Serial.begin(9600);
+  // params are data pin, clock pin, latch pin, number of SIPOs
+  int bank_id = my_SIPOs.create_bank(8, 10, 9, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  my_SIPOs.print_SIPO_data();
+  if (!my_player.play(scan_and_strobe, pattern_in_flash, play_repeat, MSBFIRST)) {
+    Serial.println(F("\npattern not valid for the banks, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+}
+
+void loop() {
+  my_player.update();
+}
@@ -0,0 +1,46 @@
+//
+//   Remote -
+//   Sketch hands its SIPO array to a host PC, which drives it over the serial
+//   link by the SIPO8_remote binary protocol - writing status bytes, filling and
+//   inverting banks, transferring and reading back - while the sketch only keeps
+//   calling update(). See ez_SIPO8_remote.h for the protocol and
+//   extras/host/SIPO8_remote_client.h for a host client.
+//
+//   A request frame is checked by CRC before it is acted on, and requests are
+//   applied once each, in order, however often the host resends them, so a
+//   corrupted or lost byte costs a resend rather than a wrong pin.
+//
+//   The serial monitor must be closed - the link carries binary frames.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_remote.h>
+
+#define Max_SIPOs        8  // 8 x SIPOs - provides 64 output pins
+#define Max_timers       0
+#define buffer_size    300  // receive buffer, holds the longest request frame (261)
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+SIPO8_remote remote(my_SIPOs, Serial);
+
+void setup() {
+  Serial.begin(1000000);
+  // two banks of 4 SIPOs, params are data pin, clock pin, latch pin, number of SIPOs
+  int bank0 = my_SIPOs.create_bank(8, 10, 9, 4);
+  int bank1 = my_SIPOs.create_bank(8, 10, 7, 4);
+  if (bank0 == create_bank_failure || bank1 == create_bank_failure ||
+      !remote.begin(buffer_size)) {
+    exit(0);  // the host finds no remote
+  }
+  my_SIPOs.set_all_array_pins(LOW);
+  my_SIPOs.xfer_array(MSBFIRST);
+}
+
+void loop() {
+  remote.update();
+}
@@ -0,0 +1,65 @@
+//
+//   Scheduler -
+//   Blinks, strobes and flashes LEDs on a bank of 2 SIPOs using scheduled timers
+//   rather than polled timers. Each timer is scheduled once in setup, and loop
+//   need only call SIPO8_service, which performs the action of each timer as it
+//   expires, then transfer any changes.
+//
+//   bank pins 0-7  - each blinks at its own rate, a periodic invert_bank_pin timer each
+//   bank pins 8-15 - a chaser, stepped by a periodic timer calling chase_step
+//   timer 9        - a one shot timer, inverts the whole bank once after 10 seconds
+//
+//   Periodic timers are rescheduled from their previous expiry, not from when they
+//   were serviced, so the blink rates do not drift however busy loop is.
+//
+//   This example and code is in the public domain and
+//   may be used without restriction and without warranty.
+//
+
+#include <ez_SIPO8_lib.h>
+
+#define Max_SIPOs        2
+#define Max_timers      10
+
+#define data_pin         8
+#define clock_pin       10
+#define latch_pin        9
+
+#define chase_timer      8
+#define invert_timer     9
+
+// initiate the class for max SIPOs/timers required
+SIPO8 my_SIPOs(Max_SIPOs, Max_timers);
+
+int bank_id;  // used to keep the SIPO bank id
+
+// called by SIPO8_service each time the chase timer expires
+void chase_step(SIPO8 & SIPOs, uint8_t timer) {
+  static uint8_t step = 0;
+  SIPOs.set_bank_pin(bank_id, 8 + step, LOW);
+  step = (step + 1) % 8;
+  SIPOs.set_bank_pin(bank_id, 8 + step, HIGH);
+}
+
+void setup() {
+  Serial.begin(9600);
+  bank_id = my_SIPOs.create_bank(data_pin, clock_pin, latch_pin, Max_SIPOs);
+  if (bank_id == create_bank_failure) {
+    Serial.println(F("\nfailed to create bank, terminated"));
+    Serial.flush();
+    exit(0);
+  }
+  // pins 0-7 blink every 100, 150, 200... milli seconds
+  for (uint8_t pin = 0; pin < 8; pin++) {
+    my_SIPOs.SIPO8_schedule_invert_bank_pin(pin, 100 + pin * 50, periodic, bank_id, pin);
+  }
+  my_SIPOs.SIPO8_schedule_timer(chase_timer, 75, periodic, chase_step);
+  my_SIPOs.SIPO8_schedule_invert_bank(invert_timer, 10000, one_shot, bank_id);
+  my_SIPOs.print_SIPO_data();
+}
+
+void loop() {
+  if (my_SIPOs.SIPO8_service() > 0) {
+    my_SIPOs.xfer_dirty(MSBFIRST);  // only if a timer changed any pins
+  }
+}
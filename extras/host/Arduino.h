@@ -0,0 +1,122 @@
+/*
+   SIPO8 host build support
+
+   Minimal stand in for the Arduino core, sufficient to compile the SIPO8 library
+   and its host tools on a desktop machine (Linux, macOS, etc). Pin and clock
+   access is provided by the SIPO8 simulation backend, see SIPO8_sim.h, and the
+   library must be compiled with SIPO8_CUSTOM_IO defined. Port registers are
+   emulated too, so the library may also be compiled with SIPO8_FAST_IO 1.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_host_Arduino_h
+#define SIPO8_host_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define LSBFIRST      0
+#define MSBFIRST      1
+
+#define bit(b)              (1UL << (b))
+#define bitRead(value, b)   (((value) >> (b)) & 0x01)
+#define bitSet(value, b)    ((value) |= (1UL << (b)))
+#define bitClear(value, b)  ((value) &= ~(1UL << (b)))
+#define bitWrite(value, b, bitvalue) ((bitvalue) ? bitSet(value, b) : bitClear(value, b))
+
+// flash memory is ordinary memory on the host
+#define PROGMEM
+#define pgm_read_byte(address)  (*(const uint8_t  *)(address))
+#define pgm_read_word(address)  (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address)   (*(const void * const *)(address))
+#define memcpy_P                memcpy
+#define F(string_literal)       (string_literal)
+
+// pin and clock functions, provided by the simulation backend
+void     pinMode(uint8_t pin, uint8_t mode);
+void     digitalWrite(uint8_t pin, uint8_t level);
+int      digitalRead(uint8_t pin);
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+inline void noInterrupts() {}
+inline void interrupts()   {}
+
+// port registers, for the library's SIPO8_FAST_IO transfers - as on AVR boards, pin
+// n is bit n % 8 of port n / 8. Emulated by the simulation backend, a register
+// write sets each of its pins' levels as digitalWrite would, in bit order, and a
+// read of an output register returns its pins' levels, of an input register what
+// digitalRead would
+#define SIPO8_host_num_ports 32
+#define NOT_A_PORT           0xFF
+class SIPO8_custom_port_reg {
+  public:
+    operator uint8_t() const;
+    SIPO8_custom_port_reg & operator=(uint8_t bits);
+    SIPO8_custom_port_reg & operator|=(uint8_t bits) { return *this = (uint8_t)(*this | bits); }
+    SIPO8_custom_port_reg & operator&=(uint8_t bits) { return *this = (uint8_t)(*this & bits); }
+};
+typedef uint8_t SIPO8_custom_port_mask;
+
+uint8_t                 digitalPinToPort(uint8_t pin);
+uint8_t                 digitalPinToBitMask(uint8_t pin);
+SIPO8_custom_port_reg * portOutputRegister(uint8_t port);  // NULL if NOT_A_PORT
+SIPO8_custom_port_reg * portInputRegister(uint8_t port);
+
+// Stream, the Arduino core's byte stream interface, as far as the library uses it
+class Stream {
+  public:
+    virtual ~Stream() {}
+    virtual int    available() = 0;
+    virtual int    read() = 0;
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t * buffer, size_t size) {
+      size_t written = 0;
+      while (written < size && write(buffer[written]) == 1) written++;
+      return written;
+    }
+};
+
+// Serial, written to stdout/read from stdin
+class HostSerial : public Stream {
+  public:
+    void   begin(unsigned long) {}
+    void   end() {}
+    void   flush() { fflush(stdout); }
+    int    available() { return 0; }
+    int    read() { return -1; }
+    size_t write(uint8_t value) { return fwrite(&value, 1, 1, stdout); }
+    size_t write(const uint8_t * buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+    void print(const char * value)    { fputs(value, stdout); }
+    void print(char value)            { fputc(value, stdout); }
+    void print(int value)             { printf("%d", value); }
+    void print(unsigned int value)    { printf("%u", value); }
+    void print(long value)            { printf("%ld", value); }
+    void print(unsigned long value)   { printf("%lu", value); }
+    void print(double value)          { printf("%.2f", value); }
+    void print(uint8_t value)         { printf("%u", value); }
+    void print(unsigned long value, int base) {
+      if (base == 16) printf("%lX", value); else printf("%lu", value);
+    }
+    void println() { fputc('\n', stdout); }
+    template <class T> void println(T value) { print(value); println(); }
+};
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,1265 @@
+/*
+   SIPO8 host benchmark
+
+   Runs the SIPO8 transfer, pin set/invert and timer functions over a range of
+   SIPO configurations, from 1 to 255 SIPOs - and to 1280 SIPOs (10240 pins) if
+   built with SIPO8_INDEX_BITS above 8 - using the host simulation backend, and
+   reports for each:
+     writes/op  - pin writes made per operation, or port register writes
+     edges/op   - pin level changes per operation
+     sim_us/op  - simulated microcontroller time per operation, at the given
+                  cost per pin write (--gpio-ns, default 3400ns, about that of
+                  digitalWrite on a 16MHz AVR) and per port register read or
+                  write (--port-ns, default 125ns, 2 cycles at 16MHz)
+     host_ns/op - host time per operation
+
+   The writes/op and edges/op columns are exact and so suit regression checks
+   in CI, host_ns/op is indicative only.
+
+   Built with SIPO8_STATS 1 it also reports, from the library's own counters,
+   transfers, bytes shifted and clock pulses per operation and the longest
+   xfer_banks call in simulated microseconds - exact, so also suited to
+   regression checks - and checks dump_stats against read_stats.
+
+   It first checks the bits wired banks clock out against a model, for every
+   byte value, then that chunked transfers (xfer_begin/xfer_step), in steps of a
+   range of sizes, clock out the same edges as xfer_banks, to banks with and
+   without groups, fixed bit orders and wiring maps, and record what they shifted
+   out as committed when pin statuses change part way, exiting with status 1 if not.
+   Then it checks chain verification (verify_bank and spot_check) against modelled
+   loopback chains, intact and with faults injected, and that a group's SIPOs are
+   restored after, exiting with status 1 if any fault is missed or misreported.
+   Then it checks brightness modulation (start_bcm/bcm_tick) against a per-pin
+   model - the bit planes transferred and each pin's on time over a cycle -
+   exiting with status 1 if they differ, and input debouncing (scan_inputs) with
+   bouncing and stable input levels, exiting with status 1 if a change is reported
+   other than after 4 consecutive scans at the new level. Then it checks scheduled
+   timers (SIPO8_service) across inserts and cancels, in virtual time, exiting
+   with status 1 if a timer is called other than when due, in order of expiry.
+   Last it checks copy_array_range and invert_array_range over pseudo random,
+   overlapping and unaligned ranges against a bit by bit model, exiting with
+   status 1 if they differ.
+
+   Built with SIPO8_INDEX_BITS above 8 it also checks the pin, bank, batch and
+   transfer functions against a model over an array of more than 10k pins and
+   255 banks, exiting with status 1 if any check fails.
+
+   Built with SIPO8_FAST_IO 1 every check is run with transfers made by the
+   emulated port registers, and the configurations' rows are still of transfers
+   made by digitalWrite. It then checks that both send the same bits to solo
+   banks, to groups with their data pins on one port and on several, and read
+   the same bits from input banks, exiting with status 1 if not, and adds rows
+   for transfers and input scans made each way, counting digitalWrite calls or
+   port register writes and the edges each makes.
+
+   See README.md in this directory for how to build, then run as:
+     ./SIPO8_bench [--gpio-ns N] [--port-ns N] [--iterations N] [--csv]
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+#include <SIPO8_sim.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static uint32_t gpio_ns    = 3400;
+static uint32_t port_ns    = 125;
+static uint32_t iterations = 200;
+static bool     csv        = false;
+
+struct bench_result {
+  double writes_per_op;
+  double edges_per_op;
+  double sim_us_per_op;
+  double host_ns_per_op;
+#if SIPO8_STATS
+  double xfers_per_op;
+  double bytes_per_op;
+  double bits_per_op;
+  uint32_t xfer_us_max;
+#endif
+};
+
+#if SIPO8_STATS
+// the SIPO8 object being benchmarked, whose counters are reported...
+static SIPO8 * bench_SIPOs = NULL;
+// ...totalled over the operations timed
+static SIPO8::stats_snapshot op_stats;
+
+static void start_op_stats() {
+  bench_SIPOs->clear_stats();
+}
+
+static void end_op_stats() {
+  SIPO8::stats_snapshot stats;
+  bench_SIPOs->read_stats(stats);
+  op_stats.num_xfers         = op_stats.num_xfers + stats.num_xfers;
+  op_stats.num_bytes_shifted = op_stats.num_bytes_shifted + stats.num_bytes_shifted;
+  op_stats.num_bits_clocked  = op_stats.num_bits_clocked + stats.num_bits_clocked;
+  if (stats.xfer_us_max > op_stats.xfer_us_max) op_stats.xfer_us_max = stats.xfer_us_max;
+}
+#endif
+
+static uint32_t pseudo_random_state = 12345;
+static uint32_t pseudo_random() {
+  pseudo_random_state = pseudo_random_state * 1103515245 + 12345;
+  return pseudo_random_state >> 8;
+}
+
+static bench_result results(uint32_t num_ops, uint64_t writes, uint64_t edges, uint64_t sim_ns,
+                            std::chrono::steady_clock::duration host_time) {
+  bench_result result;
+  result.writes_per_op  = (double)writes / num_ops;
+  result.edges_per_op   = (double)edges / num_ops;
+  result.sim_us_per_op  = (double)sim_ns / num_ops / 1000.0;
+  result.host_ns_per_op =
+    (double)std::chrono::duration_cast<std::chrono::nanoseconds>(host_time).count() / num_ops;
+#if SIPO8_STATS
+  result.xfers_per_op = (double)op_stats.num_xfers / num_ops;
+  result.bytes_per_op = (double)op_stats.num_bytes_shifted / num_ops;
+  result.bits_per_op  = (double)op_stats.num_bits_clocked / num_ops;
+  result.xfer_us_max  = op_stats.xfer_us_max;
+#endif
+  return result;
+}
+
+// time num_ops calls of op(), as a single batch
+template <class Op>
+static bench_result run(uint32_t num_ops, Op op) {
+#if SIPO8_STATS
+  op_stats = SIPO8::stats_snapshot();
+  start_op_stats();
+#endif
+  SIPO8_sim::clear_counts();
+  uint64_t sim_start = SIPO8_sim::now_ns();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < num_ops; i++) {
+    op(i);
+  }
+  std::chrono::steady_clock::duration host_time = std::chrono::steady_clock::now() - start;
+#if SIPO8_STATS
+  end_op_stats();
+#endif
+  return results(num_ops, SIPO8_sim::num_writes() + SIPO8_sim::num_port_writes(),
+                 SIPO8_sim::num_edges(), SIPO8_sim::now_ns() - sim_start, host_time);
+}
+
+// time num_ops calls of op(), each preceded by an untimed call of prepare()
+template <class Prepare, class Op>
+static bench_result run(uint32_t num_ops, Prepare prepare, Op op) {
+  uint64_t writes = 0, edges = 0, sim_ns = 0;
+  std::chrono::steady_clock::duration host_time(0);
+#if SIPO8_STATS
+  op_stats = SIPO8::stats_snapshot();
+#endif
+  for (uint32_t i = 0; i < num_ops; i++) {
+    prepare(i);
+#if SIPO8_STATS
+    start_op_stats();
+#endif
+    SIPO8_sim::clear_counts();
+    uint64_t sim_start = SIPO8_sim::now_ns();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    op(i);
+    host_time += std::chrono::steady_clock::now() - start;
+#if SIPO8_STATS
+    end_op_stats();
+#endif
+    sim_ns = sim_ns + SIPO8_sim::now_ns() - sim_start;
+    writes = writes + SIPO8_sim::num_writes() + SIPO8_sim::num_port_writes();
+    edges  = edges + SIPO8_sim::num_edges();
+  }
+  return results(num_ops, writes, edges, sim_ns, host_time);
+}
+
+// the linear scan get_bank_from_pin once used, kept as a reference point
+static volatile int bank_found;
+static int linear_bank_from_pin(SIPO8 & SIPOs, SIPO8_pin pin) {
+  for (SIPO8_index bank = 0; bank < SIPOs.num_banks; bank++) {
+    if (SIPOs.SIPO_banks[bank].bank_low_pin <= pin &&
+        pin <= SIPOs.SIPO_banks[bank].bank_high_pin) return bank;
+  }
+  return bank_not_found;
+}
+
+static void report(const char * config, const char * op, const bench_result & result) {
+  if (csv) {
+    printf("%s,%s,%.1f,%.1f,%.2f,%.1f", config, op, result.writes_per_op,
+           result.edges_per_op, result.sim_us_per_op, result.host_ns_per_op);
+#if SIPO8_STATS
+    printf(",%.1f,%.1f,%.1f,%u", result.xfers_per_op, result.bytes_per_op, result.bits_per_op,
+           result.xfer_us_max);
+#endif
+  } else {
+    printf("%-22s %-26s %10.1f %10.1f %12.2f %12.1f", config, op, result.writes_per_op,
+           result.edges_per_op, result.sim_us_per_op, result.host_ns_per_op);
+#if SIPO8_STATS
+    printf(" %10.1f %10.1f %10.1f %12u", result.xfers_per_op, result.bytes_per_op,
+           result.bits_per_op, result.xfer_us_max);
+#endif
+  }
+  printf("\n");
+}
+
+#if SIPO8_STATS
+// collects the bytes written to it
+class memory_stream : public Stream {
+  public:
+    std::vector<uint8_t> bytes;
+    int    available() { return 0; }
+    int    read() { return -1; }
+    size_t write(uint8_t value) { bytes.push_back(value); return 1; }
+};
+
+static uint32_t dump_word(const std::vector<uint8_t> & bytes, size_t offset) {
+  return bytes[offset] | bytes[offset + 1] << 8 | bytes[offset + 2] << 16 |
+         (uint32_t)bytes[offset + 3] << 24;
+}
+
+// checks dump_stats writes the counters read_stats gives, and each bank's
+// transfers, returning false if not
+static bool check_stats_dump(SIPO8 & SIPOs) {
+  SIPO8::stats_snapshot stats;
+  SIPOs.read_stats(stats);
+  uint32_t counters[sizeof(stats) / sizeof(uint32_t)];
+  memcpy(counters, &stats, sizeof(counters));
+  memory_stream stream;
+  size_t written = SIPOs.dump_stats(stream);
+  size_t num_counters = sizeof(counters) / sizeof(uint32_t);
+  bool valid = written == stream.bytes.size() &&
+               written == 2 + 4 * (num_counters + 1 + SIPOs.num_banks) &&
+               stream.bytes[0] == stats_dump_version && stream.bytes[1] == num_counters &&
+               dump_word(stream.bytes, 2 + 4 * num_counters) == SIPOs.num_banks;
+  for (size_t counter = 0; valid && counter < num_counters; counter++) {
+    valid = dump_word(stream.bytes, 2 + 4 * counter) == counters[counter];
+  }
+  for (SIPO8_index bank = 0; valid && bank < SIPOs.num_banks; bank++) {
+    valid = dump_word(stream.bytes, 2 + 4 * (num_counters + 1 + bank)) ==
+            SIPOs.SIPO_banks[bank].bank_xfers;
+  }
+  if (!valid) fprintf(stderr, "dump_stats record differs from read_stats\n");
+  return valid;
+}
+#endif
+
+// benchmark a SIPO8 object with num_SIPOs arranged as num_banks equal(ish) banks,
+// returning false if a check fails
+static bool bench_config(SIPO8_index num_SIPOs, SIPO8_index num_banks) {
+  char config[32];
+  snprintf(config, sizeof(config), "%u SIPOs/%u banks", (unsigned)num_SIPOs, (unsigned)num_banks);
+  SIPO8_sim::reset();
+  SIPO8_sim::set_gpio_cost_ns(gpio_ns);
+  SIPO8 SIPOs(num_SIPOs, 1);
+#if SIPO8_STATS
+  bench_SIPOs = &SIPOs;
+#endif
+#if SIPO8_FAST_IO
+  SIPOs.use_fast_io(false);  // as every build, see bench_fast_io
+#endif
+  SIPO8_index SIPOs_left = num_SIPOs;
+  for (SIPO8_index bank = 0; bank < num_banks; bank++) {
+    SIPO8_index bank_SIPOs = SIPOs_left / (num_banks - bank);
+    // banks share data and clock pins, each has its own latch pin
+    SIPOs.create_bank(2, 3, 4 + bank % 200, bank_SIPOs);
+    SIPOs_left = SIPOs_left - bank_SIPOs;
+  }
+  SIPO8_pin num_pins = SIPOs.num_active_pins;
+  for (SIPO8_pin pin = 0; pin < num_pins; pin++) {
+    SIPOs.set_array_pin(pin, pseudo_random() & 1);
+  }
+
+  report(config, "xfer_array", run(iterations,
+         [&](uint32_t) { SIPOs.xfer_array(MSBFIRST); }));
+  // a step of a chunked transfer, the transfer restarted as each completes
+  SIPOs.xfer_begin(MSBFIRST);
+  report(config, "xfer_step (64 bits)", run(iterations,
+         [&](uint32_t) { if (SIPOs.xfer_step(64)) SIPOs.xfer_begin(MSBFIRST); }));
+  while (!SIPOs.xfer_step(64));
+  report(config, "xfer_dirty (1 pin changed)", run(iterations,
+         [&](uint32_t i) { SIPOs.invert_array_pin(i % num_pins); },
+         [&](uint32_t) { SIPOs.xfer_dirty(MSBFIRST); }));
+  report(config, "commit_banks (no change)", run(iterations,
+         [&](uint32_t i) { SIPOs.invert_array_pin(i % num_pins); SIPOs.invert_array_pin(i % num_pins); },
+         [&](uint32_t) { SIPOs.commit_banks(MSBFIRST); }));
+  uint32_t many = iterations * 100;
+  report(config, "set_array_pin", run(many,
+         [&](uint32_t i) { SIPOs.set_array_pin(i % num_pins, i & 1); }));
+  report(config, "set_bank_pin", run(many,
+         [&](uint32_t i) { SIPOs.set_bank_pin(i % num_banks, i % 8, i & 1); }));
+  // the same 8 pin updates of a bank's first SIPO, one by one and as a batch
+  report(config, "set_bank_pin x8", run(many,
+         [&](uint32_t i) {
+           for (uint8_t pin = 0; pin < 8; pin++) SIPOs.set_bank_pin(i % num_banks, pin, (i >> pin) & 1);
+         }));
+  SIPO8::batch_command commands[8];
+  report(config, "submit_batch (8 pins)", run(many,
+         [&](uint32_t i) {
+           for (uint8_t pin = 0; pin < 8; pin++) {
+             commands[pin].command_op    = (i >> pin) & 1 ? batch_set_pin : batch_clear_pin;
+             commands[pin].command_bank  = i % num_banks;
+             commands[pin].command_index = pin;
+           }
+           SIPOs.submit_batch(commands, 8);
+         }));
+  report(config, "invert_bank", run(many,
+         [&](uint32_t i) { SIPOs.invert_bank(i % num_banks); }));
+  report(config, "set_all_array_pins", run(many,
+         [&](uint32_t i) { SIPOs.set_all_array_pins(i & 1); }));
+  report(config, "set_array_range", run(many,
+         [&](uint32_t i) { SIPOs.set_array_range(3, num_pins - 4, i & 1); }));
+  report(config, "invert_array_range", run(many,
+         [&](uint32_t) { SIPOs.invert_array_range(3, num_pins - 4); }));
+  report(config, "copy_array_range", run(many,
+         [&](uint32_t) { SIPOs.copy_array_range(0, 3, num_pins - 3); }));
+  report(config, "bank from pin, linear scan", run(many,
+         [&](uint32_t i) { bank_found = linear_bank_from_pin(SIPOs, i % num_pins); }));
+  report(config, "get_bank_from_pin", run(many,
+         [&](uint32_t i) { bank_found = SIPOs.get_bank_from_pin(i % num_pins); }));
+  SIPOs.use_bank_map();
+  report(config, "get_bank_from_pin, map", run(many,
+         [&](uint32_t i) { bank_found = SIPOs.get_bank_from_pin(i % num_pins); }));
+  // an input bank of as many PISOs as SIPOs
+  SIPOs.create_input_bank(250, 251, 252, num_SIPOs);
+  report(config, "scan_inputs", run(iterations,
+         [&](uint32_t) { SIPOs.scan_inputs(); }));
+  report(config, "inputs_changed", run(many,
+         [&](uint32_t) { bank_found = SIPOs.inputs_changed(); }));
+  SIPOs.SIPO8_start_timer(timer0);
+  report(config, "SIPO8_timer_elapsed", run(many,
+         [&](uint32_t) { SIPOs.SIPO8_timer_elapsed(timer0, 1000); }));
+#if SIPO8_STATS
+  SIPOs.xfer_array(MSBFIRST);
+  if (!check_stats_dump(SIPOs)) return false;
+#endif
+  return true;
+}
+
+// what the SIPOs saw of the edges recorded since levels were taken - at each
+// rising edge of a clock or latch pin, the pin and the levels of the pins (0-15)
+// it samples, sampled_pins[pin]
+static std::vector<uint32_t> clocked_levels(uint16_t levels, uint16_t clock_pins,
+                                            const uint16_t * sampled_pins) {
+  std::vector<uint32_t> clocked;
+  for (const SIPO8_sim::edge_record & edge : SIPO8_sim::edges()) {
+    levels = edge.level ? levels | 1 << edge.pin : levels & ~(1 << edge.pin);
+    if (edge.level && (clock_pins >> edge.pin & 1)) {
+      clocked.push_back((uint32_t)edge.pin << 16 | (levels & sampled_pins[edge.pin]));
+    }
+  }
+  return clocked;
+}
+
+static uint16_t pin_levels() {
+  uint16_t levels = 0;
+  for (uint8_t pin = 0; pin < 16; pin++) levels = levels | SIPO8_sim::pin_level(pin) << pin;
+  return levels;
+}
+
+// checks chunked transfers of bank ranges in steps of several sizes against
+// xfer_banks, returning false if the bits clocked out or bytes committed differ
+static bool check_chunked_xfer() {
+  const uint16_t clock_pins = 1 << 3 | 1 << 4 | 1 << 7 | 1 << 8 | 1 << 10 | 1 << 11;
+  static const uint16_t sampled_pins[16] = {0, 0, 0, 1 << 2 | 1 << 5, 0, 0, 0, 1 << 6,
+                                            0, 0, 1 << 9 | 1 << 12};
+  static const uint8_t reversed[8] = {7, 6, 5, 4, 3, 2, 1, 0};
+  static const uint8_t swapped[8]  = {1, 0, 3, 2, 5, 4, 7, 6};
+  static const uint16_t step_bits[] = {1, 3, 8, 13, 64, 1000};
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(12, 0);
+  SIPOs.create_bank(2, 3, 4, 3);                       // bank 0, a group with bank 1
+  SIPOs.create_bank(5, 3, 4, 1, LSBFIRST);             // bank 1
+  SIPOs.create_bank(6, 7, 8, 2, order_by_xfer, reversed);
+  SIPOs.create_bank(9, 10, 11, 1);                     // bank 3, a group with bank 4
+  SIPOs.create_bank(12, 10, 11, 5, MSBFIRST, swapped); // bank 4
+  for (SIPO8_index SIPO = 0; SIPO < SIPOs.bank_SIPO_count; SIPO++) {
+    SIPOs.set_array_SIPO(SIPO, SIPO * 37 + 11);
+  }
+  for (uint8_t order = 0; order < 2; order++) {
+    bool msb_or_lsb = order ? MSBFIRST : LSBFIRST;
+    for (SIPO8_index from_bank = 0; from_bank < SIPOs.num_banks; from_bank++) {
+      for (SIPO8_index to_bank = from_bank; to_bank < SIPOs.num_banks; to_bank++) {
+        uint8_t * committed_bytes = SIPOs.committed_status_bytes;
+        SIPO8_index num_bytes = SIPOs.num_pin_status_bytes;
+        memset(committed_bytes, 0, num_bytes);
+        SIPO8_sim::clear_counts();
+        SIPO8_sim::record_edges(true);
+        uint16_t levels = pin_levels();
+        SIPOs.xfer_banks(from_bank, to_bank, msb_or_lsb);
+        std::vector<uint32_t> expected = clocked_levels(levels, clock_pins, sampled_pins);
+        std::vector<uint8_t>  committed(committed_bytes, committed_bytes + num_bytes);
+        for (uint8_t step = 0; step < sizeof(step_bits) / sizeof(step_bits[0]); step++) {
+          memset(committed_bytes, 0, num_bytes);
+          SIPO8_sim::clear_counts();
+          levels = pin_levels();
+          bool complete = !SIPOs.xfer_begin(from_bank, to_bank, msb_or_lsb);
+          uint32_t num_steps = 0;
+          while (!complete) {
+            complete = SIPOs.xfer_step(step_bits[step]);
+            num_steps++;
+          }
+          if (clocked_levels(levels, clock_pins, sampled_pins) != expected || num_steps == 0 ||
+              memcmp(committed_bytes, &committed[0], num_bytes) != 0) {
+            fprintf(stderr, "chunked transfer of banks %u-%u, %s, in steps of %u bits differs\n",
+                    (unsigned)from_bank, (unsigned)to_bank, order ? "MSBFIRST" : "LSBFIRST",
+                    step_bits[step]);
+            return false;
+          }
+        }
+      }
+    }
+  }
+  // pin statuses changed whilst a bank is part shifted - SIPO 3 after it is shifted
+  // out, SIPO 2 part way through and SIPO 0 before - are shifted out as they were
+  // when each SIPO's first bit was, recorded as committed and left dirty if changed
+  static const uint16_t bank_sampled_pins[16] = {0, 0, 0, 1 << 2};
+  const uint16_t bank_clock_pins = 1 << 3 | 1 << 4;
+  static const uint8_t shifted[4]   = {0x55, 0x00, 0x00, 0xAA};
+  static const uint8_t changed[4]   = {0x55, 0x00, 0x0F, 0xFF};
+  for (uint8_t step = 0; step < sizeof(step_bits) / sizeof(step_bits[0]); step++) {
+    SIPO8_sim::reset();
+    SIPO8 expected_SIPOs(4, 0);
+    SIPO8 bank_SIPOs(4, 0);
+    expected_SIPOs.create_bank(2, 3, 4, 4);
+    bank_SIPOs.create_bank(2, 3, 4, 4);
+    for (SIPO8_index SIPO = 0; SIPO < 4; SIPO++) expected_SIPOs.set_array_SIPO(SIPO, shifted[SIPO]);
+    SIPO8_sim::record_edges(true);
+    uint16_t levels = pin_levels();
+    expected_SIPOs.xfer_bank(0, MSBFIRST);
+    std::vector<uint32_t> expected = clocked_levels(levels, bank_clock_pins, bank_sampled_pins);
+    SIPO8_sim::clear_counts();
+    levels = pin_levels();
+    bank_SIPOs.set_array_SIPO(3, 0xAA);
+    bank_SIPOs.xfer_begin(0, 0, MSBFIRST);
+    bank_SIPOs.xfer_step(8);   // SIPO 3, shifted out first
+    bank_SIPOs.xfer_step(3);   // part of SIPO 2
+    bank_SIPOs.set_array_SIPO(3, changed[3]);
+    bank_SIPOs.set_array_SIPO(2, changed[2]);
+    bank_SIPOs.set_array_SIPO(0, changed[0]);
+    while (!bank_SIPOs.xfer_step(step_bits[step]));
+    bool shifted_ok = clocked_levels(levels, bank_clock_pins, bank_sampled_pins) == expected;
+    bool committed_ok = true;
+    for (SIPO8_index SIPO = 0; SIPO < 4; SIPO++) {
+      committed_ok = committed_ok && bank_SIPOs.read_committed_bank_SIPO(0, SIPO) == shifted[SIPO];
+    }
+    bool dirty = bank_SIPOs.bank_is_dirty(0);
+    bank_SIPOs.xfer_dirty(MSBFIRST);
+    for (SIPO8_index SIPO = 0; SIPO < 4; SIPO++) {
+      committed_ok = committed_ok && bank_SIPOs.read_committed_bank_SIPO(0, SIPO) == changed[SIPO];
+    }
+    if (!shifted_ok || !committed_ok || !dirty || bank_SIPOs.bank_is_dirty(0)) {
+      fprintf(stderr, "chunked transfer with pin statuses changed part way, in steps of %u bits, "
+              "%s\n", step_bits[step], !shifted_ok ? "shifts out the wrong bits" :
+              !dirty ? "leaves the bank clean" : "records the wrong committed statuses");
+      return false;
+    }
+  }
+  SIPO8_sim::record_edges(false);
+  return true;
+}
+
+// checks the bits clocked out of wired banks against a model that moves each bit
+// as its wiring lists, for every byte value, solo and as members of a group (so
+// with padding) of differing bit orders and wiring, returning false if any differ
+static bool check_wiring() {
+  static const uint16_t sampled_pins[16] = {0, 0, 0, 1 << 2 | 1 << 5, 0, 0, 0, 1 << 8};
+  static const uint8_t wiring[2][8] = {{3, 0, 7, 5, 1, 6, 2, 4}, {6, 2, 0, 7, 4, 1, 5, 3}};
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(5, 0);
+  SIPOs.create_bank(2, 3, 4, 1, MSBFIRST, wiring[0]);  // bank 0, a group with bank 1
+  SIPOs.create_bank(5, 3, 4, 2, LSBFIRST, wiring[1]);  // bank 1
+  SIPOs.create_bank(8, 7, 6, 2, MSBFIRST, wiring[0]);  // bank 2, shares bank 0's table
+  for (uint16_t value = 0; value < 256; value++) {
+    uint8_t bytes[5] = {(uint8_t)value, (uint8_t)(value * 37 + 11), (uint8_t)~value,
+                        (uint8_t)(value ^ 0x5A), (uint8_t)(value * 73)};
+    // each data pin's levels in clock order - padding first, then the bank's SIPOs
+    // from its last (MSBFIRST) or first (LSBFIRST)
+    std::vector<uint32_t> expected;
+    for (SIPO8_index shifted = 0; shifted < 2; shifted++) {
+      for (uint8_t bit = 0; bit < 8; bit++) {
+        uint16_t levels = 0;
+        for (SIPO8_index bank = 0; bank < 3; bank++) {
+          static const uint8_t data_pins[3] = {2, 5, 8};
+          static const uint8_t first_bytes[3] = {0, 1, 3};
+          static const SIPO8_index bank_SIPOs[3] = {1, 2, 2};
+          const uint8_t * bank_wiring = wiring[bank == 1];
+          bool msb_first = bank != 1;
+          SIPO8_index padding = 2 - bank_SIPOs[bank];
+          if (shifted < padding) continue;                 // LOW
+          SIPO8_index SIPO = msb_first ? bank_SIPOs[bank] - 1 - (shifted - padding) : shifted - padding;
+          uint8_t byte = bytes[first_bytes[bank] + SIPO];
+          uint8_t output = msb_first ? 7 - bit : bit;
+          for (uint8_t pin = 0; pin < 8; pin++) {
+            if (bank_wiring[pin] == output && (byte >> pin & 1)) levels |= 1 << data_pins[bank];
+          }
+        }
+        expected.push_back(3UL << 16 | (levels & sampled_pins[3]));
+        expected.push_back(7UL << 16 | (levels & sampled_pins[7]));
+      }
+    }
+    for (SIPO8_index SIPO = 0; SIPO < 5; SIPO++) SIPOs.set_array_SIPO(SIPO, bytes[SIPO]);
+    SIPO8_sim::clear_counts();
+    SIPO8_sim::record_edges(true);
+    uint16_t levels = pin_levels();
+    SIPOs.xfer_array(MSBFIRST);
+    std::vector<uint32_t> clocked = clocked_levels(levels, 1 << 3 | 1 << 7, sampled_pins);
+    // bank 2's clock pulses follow all of the group's, so compare each clock's
+    std::vector<uint32_t> group_clocked, bank_clocked, group_expected, bank_expected;
+    for (uint32_t level : clocked) (level >> 16 == 3 ? group_clocked : bank_clocked).push_back(level);
+    for (uint32_t level : expected) (level >> 16 == 3 ? group_expected : bank_expected).push_back(level);
+    if (group_clocked != group_expected || bank_clocked != bank_expected) {
+      fprintf(stderr, "wired banks shift out the wrong bits for byte %u\n", value);
+      return false;
+    }
+  }
+  SIPO8_sim::record_edges(false);
+  return true;
+}
+
+// creates banks 0 and 1, a group, with loopback pins 13 and 14 and modelled
+// chains, bank 0's of the given length, then bank 2 with no loopback pin
+static void create_chain_banks(SIPO8 & SIPOs, uint16_t chain_bits) {
+  SIPO8_sim::reset();
+  SIPOs.create_bank(2, 3, 4, 3);  // bank 0, a group with bank 1
+  SIPOs.create_bank(5, 3, 4, 1);  // bank 1
+  SIPOs.create_bank(6, 7, 8, 2);  // bank 2
+  SIPO8_sim::add_chain(2, 3, 13, chain_bits);
+  SIPO8_sim::add_chain(5, 3, 14, 8);
+  SIPOs.set_bank_loopback(0, 13);
+  SIPOs.set_bank_loopback(1, 14);
+}
+
+static bool chain_reported(SIPO8 & SIPOs, SIPO8_index bank, const char * chain,
+                           uint8_t status, SIPO8_pin chain_bits, SIPO8_index first_bad_byte) {
+  SIPO8::chain_report report;
+  int result = SIPOs.verify_bank(bank, report);
+  if (result != status || report.chain_status != status || report.chain_bits != chain_bits ||
+      report.chain_SIPOs != chain_bits / 8 || report.first_bad_byte != first_bad_byte) {
+    fprintf(stderr, "verify_bank of bank %u, %s, returned %d - status %u, %u bits, %u SIPOs, "
+            "first bad byte %u\n", (unsigned)bank, chain, result, report.chain_status,
+            (unsigned)report.chain_bits, (unsigned)report.chain_SIPOs,
+            (unsigned)report.first_bad_byte);
+    return false;
+  }
+  return true;
+}
+
+// calls spot_check up to max_calls times, returning the first bank found faulty,
+// or no_chain_fault
+static int spot_check_fault(SIPO8 & SIPOs, uint16_t max_bits, uint32_t max_calls) {
+  for (uint32_t call = 0; call < max_calls; call++) {
+    SIPO8_result bank = SIPOs.spot_check(max_bits);
+    if (bank != no_chain_fault) return bank;
+  }
+  return no_chain_fault;
+}
+
+// checks verify_bank and spot_check against modelled chains, returning false if a
+// fault is missed or misreported, or the SIPO outputs are latched
+static bool check_chain_verify() {
+  const SIPO8_index none = SIPO8_max_index;
+  {
+    SIPO8 SIPOs(8, 0);
+    create_chain_banks(SIPOs, 24);
+    SIPO8_sim::record_edges(true);
+    if (!chain_reported(SIPOs, 0, "intact", chain_ok, 24, none) ||
+        !chain_reported(SIPOs, 1, "intact", chain_ok, 8, none)) return false;
+    // each pass, banks 0 and 1 in turn, shifts in twice the bank's length of bits,
+    // then restores the group's 24 bits
+    uint64_t clocks = SIPO8_sim::chain_clocks(0);
+    for (uint32_t call = 0; call < 10; call++) {
+      if (SIPOs.spot_check(1000) != no_chain_fault) {
+        fprintf(stderr, "spot_check found a fault in an intact chain\n");
+        return false;
+      }
+    }
+    for (const SIPO8_sim::edge_record & edge : SIPO8_sim::edges()) {
+      if (edge.pin == 4) {
+        fprintf(stderr, "chain verification set the latch\n");
+        return false;
+      }
+    }
+    SIPO8_sim::record_edges(false);
+    clocks = SIPO8_sim::chain_clocks(0) - clocks;
+    if (SIPOs.num_spot_checks != 10 || SIPOs.num_chain_faults != 0 || clocks != 5 * (48 + 16) + 10 * 24) {
+      fprintf(stderr, "spot_check passed %u banks of 10, in %u clocks\n",
+              (unsigned)SIPOs.num_spot_checks, (unsigned)clocks);
+      return false;
+    }
+    // transfers between spot check steps restart the check, but find no fault
+    for (uint32_t call = 0; call < 1000; call++) {
+      if (call % 13 == 0) SIPOs.xfer_banks(MSBFIRST);
+      if (SIPOs.spot_check(7) != no_chain_fault) {
+        fprintf(stderr, "spot_check found a fault in an intact chain, with transfers\n");
+        return false;
+      }
+    }
+    SIPO8::chain_report report;
+    bool failures_ok = SIPOs.verify_bank(2, report) == verify_failure &&
+                       SIPOs.verify_bank(3, report) == verify_failure &&
+                       !SIPOs.set_bank_loopback(3, 15) &&
+                       SIPOs.xfer_begin(MSBFIRST) &&
+                       SIPOs.verify_bank(0, report) == verify_failure &&
+                       SIPOs.spot_check(8) == spot_check_failure;
+    while (!SIPOs.xfer_step(8));
+    SIPOs.set_bank_loopback(0, no_loopback);
+    SIPOs.set_bank_loopback(1, no_loopback);
+    failures_ok = failures_ok && SIPOs.verify_bank(0, report) == verify_failure &&
+                  SIPOs.spot_check(8) == spot_check_failure;
+    if (!failures_ok) {
+      fprintf(stderr, "chain verification without a loopback pin, or whilst transferring, did not fail\n");
+      return false;
+    }
+  }
+  {
+    // the group's SIPOs hold their committed statuses again once a check of either
+    // bank completes, in the bit order of the group's last transfer
+    SIPO8 SIPOs(8, 0);
+    create_chain_banks(SIPOs, 24);
+    for (SIPO8_index SIPO = 0; SIPO < 4; SIPO++) SIPOs.set_array_SIPO(SIPO, SIPO * 37 + 11);
+    SIPOs.xfer_banks(LSBFIRST);
+    auto held = [] {
+      std::vector<uint8_t> levels;
+      for (uint16_t stage = 0; stage < 24; stage++) levels.push_back(SIPO8_sim::chain_stage(0, stage));
+      for (uint16_t stage = 0; stage < 8; stage++) levels.push_back(SIPO8_sim::chain_stage(1, stage));
+      return levels;
+    };
+    std::vector<uint8_t> transferred = held();
+    bool verify_ok = chain_reported(SIPOs, 1, "intact", chain_ok, 8, none);
+    bool restored  = held() == transferred;
+    verify_ok = verify_ok && chain_reported(SIPOs, 0, "intact", chain_ok, 24, none);
+    restored  = restored && held() == transferred;
+    for (uint8_t bank = 0; bank < 2; bank++) {
+      verify_ok = verify_ok && SIPOs.spot_check(1000) == no_chain_fault;
+      restored  = restored && held() == transferred;
+    }
+    if (!verify_ok || !restored || SIPOs.num_spot_checks != 2) {
+      fprintf(stderr, "chain verification of a group %s\n",
+              verify_ok ? "does not restore the group's SIPOs" : "found a fault in an intact chain");
+      return false;
+    }
+  }
+  static const uint16_t wrong_lengths[] = {16, 32, 60};
+  for (uint8_t length = 0; length < 3; length++) {
+    SIPO8 SIPOs(8, 0);
+    uint16_t chain_bits = wrong_lengths[length];
+    create_chain_banks(SIPOs, chain_bits);
+    // longer than twice the bank's length is not found
+    bool found = chain_bits <= 48;
+    if (!chain_reported(SIPOs, 0, "of the wrong length", found ? chain_wrong_length : chain_broken,
+                        found ? chain_bits : 0, none) ||
+        spot_check_fault(SIPOs, 7, 100) != 0) {
+      fprintf(stderr, "a chain of %u bits for 24 is not reported\n", chain_bits);
+      return false;
+    }
+  }
+  for (uint8_t level = LOW; level <= HIGH; level++) {
+    SIPO8 SIPOs(8, 0);
+    create_chain_banks(SIPOs, 24);
+    SIPO8_sim::set_chain_fault(0, SIPO8_sim::fault_stuck, 8 + level * 7, level);
+    if (!chain_reported(SIPOs, 0, "broken", chain_broken, 0, none) ||
+        !chain_reported(SIPOs, 1, "intact", chain_ok, 8, none) ||
+        spot_check_fault(SIPOs, 7, 100) != 0) {
+      fprintf(stderr, "a chain stuck %s is not reported\n", level ? "HIGH" : "LOW");
+      return false;
+    }
+  }
+  // a single bit glitch, at each stage and test bit in turn - the test bits are
+  // shifted in after 48 clearing bits and the 24 timing the HIGH bit
+  for (uint16_t stage = 0; stage < 24; stage++) {
+    for (uint16_t test_bit = 0; test_bit < 24; test_bit++) {
+      SIPO8 SIPOs(8, 0);
+      create_chain_banks(SIPOs, 24);
+      SIPO8_sim::set_chain_fault(0, SIPO8_sim::fault_glitch, stage, 48 + 24 + test_bit + 1 + stage);
+      if (!chain_reported(SIPOs, 0, "with a glitch", chain_bad_data, 24, test_bit / 8)) {
+        fprintf(stderr, "a glitch at stage %u of test bit %u is not reported\n", stage, test_bit);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// checks brightness modulation against a per-pin model - each plane transferred,
+// read from a modelled chain as it is latched, must hold bit k of each pin's level
+// for plane k, and each pin must be on for its level of the ticks of one cycle -
+// for several level widths, returning false if not. The pseudo random sequence is
+// restored, so that the benchmark's pin data is unchanged.
+static bool check_bcm() {
+  uint32_t random_state = pseudo_random_state;
+  static const uint8_t widths[] = {1, 3, 6, 8};
+  for (uint8_t width = 0; width < sizeof(widths) / sizeof(widths[0]); width++) {
+    uint8_t num_bits = widths[width];
+    SIPO8_sim::reset();
+    SIPO8 SIPOs(3, 0);
+    SIPOs.create_bank(2, 3, 4, 3);
+    SIPO8_sim::add_chain(2, 3, 13, 24);  // stage n holds pin n, as MSBFIRST transfers
+    SIPOs.start_bcm(num_bits, MSBFIRST);
+    uint8_t max_level = (1 << num_bits) - 1;
+    uint8_t levels[24];
+    for (SIPO8_pin pin = 0; pin < 24; pin++) {
+      // fully off and fully on, then pseudo random
+      levels[pin] = pin == 0 ? 0 : pin == 1 ? max_level : (uint8_t)(pseudo_random() & max_level);
+      SIPOs.set_pin_brightness(pin, levels[pin]);
+    }
+    SIPOs.start_bcm(num_bits, MSBFIRST);  // planes built from the levels set
+    uint32_t on_ticks[24] = {0};
+    uint8_t  plane = 0;
+    bool planes_ok = true;
+    for (uint32_t tick = 0; tick < max_level; tick++) {
+      uint64_t clocks = SIPO8_sim::chain_clocks(0);
+      SIPOs.bcm_tick();
+      bool transferred = SIPO8_sim::chain_clocks(0) != clocks;
+      for (SIPO8_pin pin = 0; pin < 24; pin++) {
+        uint8_t level = SIPO8_sim::chain_stage(0, pin);
+        if (transferred) planes_ok = planes_ok && level == (levels[pin] >> plane & 1);
+        on_ticks[pin] += level;
+      }
+      if (transferred) plane++;
+    }
+    bool on_ok = plane == num_bits && SIPOs.num_bcm_frames == 1;
+    for (SIPO8_pin pin = 0; pin < 24; pin++) on_ok = on_ok && on_ticks[pin] == levels[pin];
+    if (!planes_ok || !on_ok) {
+      fprintf(stderr, "brightness modulation of %u bits %s\n", num_bits,
+              !planes_ok ? "transfers planes that differ from the levels" :
+              "shows pins on for other than their levels");
+      return false;
+    }
+  }
+  pseudo_random_state = random_state;
+  return true;
+}
+
+// checks input debouncing against a model - the data pin of an input bank of 5
+// PISOs (a SIPO8_word and a byte, on most hosts) is driven with bouncing and stable
+// runs of levels, one level a scan for every input, and a change must be reported
+// only after 4 consecutive scans at the new level - then without debouncing, when
+// it must follow every scan. The pseudo random sequence is restored, so that the
+// benchmark's pin data is unchanged. Returns false if any scan differs.
+static bool check_debounce() {
+  uint32_t random_state = pseudo_random_state;
+  const uint8_t data_pin = 20, debounce_scans = 4;
+  const SIPO8_index num_PISOs = 5;
+  for (uint8_t debounce = 0; debounce < 2; debounce++) {
+    SIPO8_sim::reset();
+    SIPO8 SIPOs(1, 0);
+    SIPOs.create_input_bank(data_pin, 21, 22, num_PISOs);
+    SIPOs.use_debounce(debounce);
+    SIPO8_sim::set_input(data_pin, LOW);
+    SIPOs.scan_inputs();  // the starting statuses
+    uint8_t  status = LOW, differing = 0, level = HIGH, run = 0;
+    uint32_t num_changes = 0;
+    for (uint32_t scan = 0; scan < 2000; scan++) {
+      // runs of 1 to 6 scans at a level - runs shorter than 4 are bounces
+      if (run == 0) {
+        level = !level;
+        run   = 1 + pseudo_random() % 6;
+      }
+      run--;
+      SIPO8_sim::set_input(data_pin, level);
+      SIPOs.scan_inputs();
+      differing = level != status ? differing + 1 : 0;
+      bool changed = differing == (debounce ? debounce_scans : 1);
+      if (changed) {
+        status    = level;
+        differing = 0;
+        num_changes++;
+      }
+      bool scan_ok = SIPOs.inputs_changed() == changed;
+      for (SIPO8_index PISO = 0; PISO < num_PISOs; PISO++) {
+        scan_ok = scan_ok && SIPOs.read_input_changes(0, PISO) == (changed ? 0xFF : 0) &&
+                  SIPOs.read_input_bank_PISO(0, PISO) == (status ? 0xFF : 0);
+      }
+      if (!scan_ok) {
+        fprintf(stderr, "input scan %u, %s, reports the wrong %s\n", scan,
+                debounce ? "debounced" : "not debounced",
+                SIPOs.read_input_pin(0) != status ? "status" : "changes");
+        return false;
+      }
+    }
+    if (num_changes == 0) {
+      fprintf(stderr, "input scans, %s, report no changes\n", debounce ? "debounced" : "not debounced");
+      return false;
+    }
+  }
+  pseudo_random_state = random_state;
+  return true;
+}
+
+// checks copy_array_range and invert_array_range against a bit by bit model, over
+// pseudo random ranges of a 3 bank array - aligned and unaligned starts and ends,
+// copies overlapping either way and ranges out of bounds. The pseudo random
+// sequence is restored, so that the benchmark's pin data is unchanged. Returns
+// false if any pin or return value differs.
+static bool check_array_ranges() {
+  uint32_t random_state = pseudo_random_state;
+  const SIPO8_pin num_pins = 17 * 8;
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(17, 0);
+  SIPOs.create_bank(2, 3, 4, 5);
+  SIPOs.create_bank(5, 6, 7, 4);
+  SIPOs.create_bank(8, 9, 10, 8);
+  std::vector<uint8_t> model(num_pins);
+  for (SIPO8_pin pin = 0; pin < num_pins; pin++) {
+    model[pin] = pseudo_random() & 1;
+    SIPOs.set_array_pin(pin, model[pin]);
+  }
+  for (uint32_t op = 0; op < 20000; op++) {
+    // pins near byte boundaries, so whole and part bytes, more often than not
+    SIPO8_pin pin_a = pseudo_random() % 2 ? pseudo_random() % 17 * 8 + pseudo_random() % 3 - 1
+                                          : pseudo_random() % num_pins;
+    SIPO8_pin pin_b = pseudo_random() % 2 ? pseudo_random() % 17 * 8 + pseudo_random() % 3 - 1
+                                          : pseudo_random() % num_pins;
+    if (pin_a >= num_pins) pin_a = 0;
+    if (pin_b >= num_pins) pin_b = num_pins - 1;
+    int result, expected;
+    const char * op_name;
+    if (pseudo_random() % 2) {
+      op_name = "invert_array_range";
+      SIPO8_pin from_pin = pin_a < pin_b ? pin_a : pin_b;
+      SIPO8_pin to_pin   = pin_a < pin_b ? pin_b : pin_a;
+      if (pseudo_random() % 16 == 0) to_pin = num_pins + pseudo_random() % 9;  // out of bounds
+      result = SIPOs.invert_array_range(from_pin, to_pin);
+      if (to_pin < num_pins) {
+        for (SIPO8_pin pin = from_pin; pin <= to_pin; pin++) model[pin] = !model[pin];
+        expected = to_pin - from_pin + 1;
+      } else {
+        expected = pin_invert_failure;
+      }
+    } else {
+      op_name = "copy_array_range";
+      SIPO8_pin src_pin = pin_a;
+      // overlapping, either way, as often as not
+      SIPO8_pin dst_pin = pseudo_random() % 2 ? pin_b : pin_a + pseudo_random() % 33 - 16;
+      if (dst_pin >= num_pins) dst_pin = pin_b;
+      SIPO8_pin max_pins = num_pins - (src_pin > dst_pin ? src_pin : dst_pin);
+      SIPO8_pin copy_pins = pseudo_random() % max_pins + 1;
+      if (pseudo_random() % 16 == 0) copy_pins = max_pins + 1 + pseudo_random() % 9;  // out of bounds
+      result = SIPOs.copy_array_range(src_pin, dst_pin, copy_pins);
+      if (copy_pins <= max_pins) {
+        std::vector<uint8_t> source(model.begin() + src_pin, model.begin() + src_pin + copy_pins);
+        std::copy(source.begin(), source.end(), model.begin() + dst_pin);
+        expected = copy_pins;
+      } else {
+        expected = pin_set_failure;
+      }
+    }
+    bool pins_ok = result == expected;
+    for (SIPO8_pin pin = 0; pin < num_pins; pin++) {
+      pins_ok = pins_ok && SIPOs.read_array_pin(pin) == model[pin];
+    }
+    if (!pins_ok) {
+      fprintf(stderr, "%s, operation %u, returned %d for %d or differs from the model\n",
+              op_name, op, result, expected);
+      return false;
+    }
+  }
+  pseudo_random_state = random_state;
+  return true;
+}
+
+// scheduled timer callback for check_timer_heap, recording the timers called
+static std::vector<uint8_t> timers_called;
+static void record_timer_call(SIPO8 &, uint8_t timer) {
+  timers_called.push_back(timer);
+}
+
+// checks scheduled timers against a model, in virtual time from shortly before the
+// millis roll over - pseudo random one shot and periodic timers are scheduled and
+// cancelled, time is moved on and each SIPO8_service must call just the timers the
+// model has due, in order of expiry. The pseudo random sequence is restored, so
+// that the benchmark's pin data is unchanged. Returns false if any service differs.
+static bool check_timer_heap() {
+  uint32_t random_state = pseudo_random_state;
+  const uint8_t num_timers = 32;
+  const uint64_t ns_per_ms = 1000000;
+  SIPO8_sim::reset();
+  SIPO8_sim::advance_ns((0x100000000ULL - 3000) * ns_per_ms);
+  SIPO8 SIPOs(1, num_timers);
+  struct model_timer {
+    bool     scheduled;
+    bool     periodic_timer;
+    uint64_t due;       // ms, not rolling over
+    uint32_t interval;
+  } model[num_timers] = {};
+  uint32_t num_called = 0;
+  for (uint32_t step = 0; step < 5000; step++) {
+    uint64_t now = SIPO8_sim::now_ns() / ns_per_ms;
+    uint8_t  timer = pseudo_random() % num_timers;
+    uint32_t choice = pseudo_random() % 8;
+    if (choice < 3) {
+      // insert, or replace, a timer
+      bool     periodic_timer = choice == 0 ? periodic : one_shot;
+      uint32_t interval = pseudo_random() % 300 + periodic_timer;  // periodic timers from 1
+      SIPOs.SIPO8_schedule_timer(timer, interval, periodic_timer, record_timer_call);
+      model[timer] = {true, periodic_timer, now + interval, interval};
+    } else if (choice == 3) {
+      SIPOs.SIPO8_stop_timer(timer);
+      model[timer].scheduled = false;
+    } else {
+      SIPO8_sim::advance_ns((pseudo_random() % 40) * ns_per_ms);
+      now = SIPO8_sim::now_ns() / ns_per_ms;
+      // the model's due timers, each called once, and the expiry each is called for
+      std::vector<uint8_t>  due;
+      std::vector<uint64_t> expiry(num_timers);
+      for (uint8_t t = 0; t < num_timers; t++) {
+        if (!model[t].scheduled || model[t].due > now) continue;
+        due.push_back(t);
+        expiry[t] = model[t].due;
+        if (model[t].periodic_timer) {
+          uint64_t behind = now - model[t].due;
+          model[t].due = model[t].due + model[t].interval + behind / model[t].interval * model[t].interval;
+        } else {
+          model[t].scheduled = false;
+        }
+      }
+      timers_called.clear();
+      uint8_t num_serviced = SIPOs.SIPO8_service();
+      std::vector<uint8_t> called = timers_called;
+      bool in_order = true;
+      for (size_t call = 1; call < called.size(); call++) {
+        in_order = in_order && expiry[called[call - 1]] <= expiry[called[call]];
+      }
+      std::sort(called.begin(), called.end());
+      if (called != due || num_serviced != due.size() || !in_order) {
+        fprintf(stderr, "timer service at step %u called %u timers of %u due%s\n", step,
+                (unsigned)timers_called.size(), (unsigned)due.size(),
+                in_order ? "" : ", out of expiry order");
+        return false;
+      }
+      num_called = num_called + due.size();
+    }
+  }
+  if (num_called == 0) {
+    fprintf(stderr, "timer services called no timers\n");
+    return false;
+  }
+  pseudo_random_state = random_state;
+  return true;
+}
+
+#if SIPO8_INDEX_BITS > 8
+// checks an array of 10400 pins - a bank of 1000 SIPOs then 300 banks of 1 SIPO -
+// against a model, returning false if any check fails. The pseudo random sequence
+// is restored, so that the benchmark's pin data is that of an 8 bit build.
+static bool check_large_array() {
+  uint32_t random_state = pseudo_random_state;
+  const SIPO8_index large_SIPOs = 1000, small_banks = 300;
+  const SIPO8_pin   large_pins  = large_SIPOs * 8;
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(large_SIPOs + small_banks, 0);
+  SIPOs.create_bank(2, 3, 4, large_SIPOs);
+  for (SIPO8_index bank = 1; bank <= small_banks; bank++) {
+    SIPOs.create_bank(5, 6, 7 + bank % 200, 1);
+  }
+  SIPO8_pin num_pins = SIPOs.num_active_pins;
+  if (SIPOs.num_banks != small_banks + 1 || num_pins != large_pins + small_banks * 8 ||
+      SIPOs.num_pins_in_bank(0) != (SIPO8_result)large_pins) {
+    fprintf(stderr, "large array: banks not created\n");
+    return false;
+  }
+  std::vector<uint8_t> model(num_pins, LOW);
+  for (uint32_t i = 0; i < 20000; i++) {
+    SIPO8_pin pin = pseudo_random() % num_pins;
+    SIPO8_index bank = pin < large_pins ? 0 : 1 + (pin - large_pins) / 8;
+    SIPO8_pin bank_pin = pin - SIPOs.SIPO_banks[bank].bank_low_pin;
+    switch (i % 6) {
+      case 0:
+        if (SIPOs.set_array_pin(pin, i & 8) != (SIPO8_result)pin) {
+          fprintf(stderr, "large array: set_array_pin did not return pin %u\n", (unsigned)pin);
+          return false;
+        }
+        model[pin] = (i & 8) != 0;
+        break;
+      case 1:
+        SIPOs.invert_array_pin(pin);
+        model[pin] = !model[pin];
+        break;
+      case 2:
+        SIPOs.set_bank_pin(bank, bank_pin, i & 8);
+        model[pin] = (i & 8) != 0;
+        break;
+      case 3: {
+          SIPO8_pin to_pin = pin + pseudo_random() % (num_pins - pin);
+          SIPOs.set_array_range(pin, to_pin, i & 8);
+          for (SIPO8_pin next = pin; next <= to_pin; next++) model[next] = (i & 8) != 0;
+          break;
+        }
+      case 4: {
+          SIPO8::batch_command command = {batch_invert_pin, bank, bank_pin, 0};
+          SIPOs.submit_batch(&command, 1);
+          model[pin] = !model[pin];
+          break;
+        }
+      case 5: {
+          uint8_t value = pseudo_random();
+          SIPOs.set_bank_SIPO(bank, bank_pin / 8, value);
+          for (uint8_t bit = 0; bit < 8; bit++) model[pin - bank_pin % 8 + bit] = (value >> bit) & 1;
+          break;
+        }
+    }
+  }
+  for (SIPO8_pin pin = 0; pin < num_pins; pin++) {
+    if (SIPOs.read_array_pin(pin) != model[pin]) {
+      fprintf(stderr, "large array: pin %u differs\n", (unsigned)pin);
+      return false;
+    }
+  }
+  for (int mapped = 0; mapped < 2; mapped++) {
+    if (mapped) SIPOs.use_bank_map();
+    for (SIPO8_pin pin = 0; pin < num_pins; pin++) {
+      SIPO8_result bank = pin < large_pins ? 0 : 1 + (pin - large_pins) / 8;
+      if (SIPOs.get_bank_from_pin(pin) != bank) {
+        fprintf(stderr, "large array: bank of pin %u differs\n", (unsigned)pin);
+        return false;
+      }
+    }
+  }
+  // the bits clocked out to the large bank, MSBFIRST - its highest pin first
+  SIPO8_sim::clear_counts();
+  SIPO8_sim::record_edges(true);
+  uint8_t data_level = SIPO8_sim::pin_level(2);
+  SIPOs.xfer_bank(0, MSBFIRST);
+  SIPO8_sim::record_edges(false);
+  SIPO8_pin next = large_pins;
+  for (const SIPO8_sim::edge_record & edge : SIPO8_sim::edges()) {
+    if (edge.pin == 2) data_level = edge.level;
+    if (edge.pin != 3 || edge.level != HIGH) continue;
+    if (next == 0 || data_level != model[--next]) {
+      fprintf(stderr, "large array: bit %u clocked out differs\n", (unsigned)(large_pins - next));
+      return false;
+    }
+  }
+  if (next != 0) {
+    fprintf(stderr, "large array: %u bits not clocked out\n", (unsigned)next);
+    return false;
+  }
+  for (SIPO8_pin pin = 0; pin < large_pins; pin++) {
+    if (SIPOs.read_committed_array_pin(pin) != model[pin]) {
+      fprintf(stderr, "large array: committed pin %u differs\n", (unsigned)pin);
+      return false;
+    }
+  }
+  pseudo_random_state = random_state;
+  return true;
+}
+#endif
+
+#if SIPO8_FAST_IO
+// sets pins 0-15 to the given levels, as pin_levels returned them
+static void set_pin_levels(uint16_t levels) {
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    uint8_t level = levels >> pin & 1;
+    if (SIPO8_sim::pin_level(pin) != level) SIPO8_digital_write(pin, level);
+  }
+}
+
+// checks that transfers and input scans made by port register writes and reads
+// match those made by digitalWrite and digitalRead - the data levels at each clock
+// and latch rising edge, the number of edges and the bits read - and make no
+// digitalWrite or digitalRead calls, for solo banks, groups with their data pins on
+// one port and on two and an input bank, read from a modelled chain. The pseudo
+// random sequence is restored, so that the benchmark's pin data is unchanged.
+// Returns false if they differ.
+static bool check_fast_io() {
+  uint32_t random_state = pseudo_random_state;
+  const uint16_t data_pins  = 1 << 2 | 1 << 5 | 1 << 6 | 1 << 9 | 1 << 12;
+  const uint16_t clock_pins = 1 << 3 | 1 << 4 | 1 << 10 | 1 << 11 | 1 << 13 | 1 << 14;
+  static const uint16_t sampled_pins[16] = {0, 0, 0, 1 << 2 | 1 << 5, data_pins, 0, 0, 0,
+                                            0, 0, 1 << 6 | 1 << 9, data_pins,
+                                            0, 1 << 12, data_pins};
+  static const uint8_t wiring[8] = {3, 0, 7, 5, 1, 6, 2, 4};
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(9, 0);
+  SIPOs.create_bank(2, 3, 4, 3);                        // bank 0, a group with bank 1...
+  SIPOs.create_bank(5, 3, 4, 1, LSBFIRST);              // ...data pins on port 0
+  SIPOs.create_bank(6, 10, 11, 2, order_by_xfer, wiring); // bank 2, a group with bank 3...
+  SIPOs.create_bank(9, 10, 11, 1);                      // ...data pins on ports 0 and 1
+  SIPOs.create_bank(12, 13, 14, 2);                     // bank 4, solo
+  SIPO8_sim::record_edges(true);
+  for (uint16_t round = 0; round < 64; round++) {
+    for (SIPO8_index SIPO = 0; SIPO < SIPOs.bank_SIPO_count; SIPO++) {
+      SIPOs.set_array_SIPO(SIPO, pseudo_random());
+    }
+    std::vector<uint32_t> clocked[2];
+    uint64_t edges[2], writes[2], port_writes[2];
+    uint16_t start_levels = pin_levels();
+    for (uint8_t fast_io = 0; fast_io < 2; fast_io++) {
+      SIPOs.use_fast_io(fast_io);
+      set_pin_levels(start_levels);
+      SIPO8_sim::clear_counts();
+      SIPOs.xfer_array(MSBFIRST);
+      SIPOs.xfer_array(LSBFIRST);
+      SIPOs.xfer_bank(4, LSBFIRST);
+      SIPOs.xfer_begin(MSBFIRST);
+      while (!SIPOs.xfer_step(5));
+      clocked[fast_io]     = clocked_levels(start_levels, clock_pins, sampled_pins);
+      edges[fast_io]       = SIPO8_sim::num_edges();
+      writes[fast_io]      = SIPO8_sim::num_writes();
+      port_writes[fast_io] = SIPO8_sim::num_port_writes();
+    }
+    if (clocked[0] != clocked[1] || edges[0] != edges[1] || port_writes[0] != 0 ||
+        writes[1] != 0 || port_writes[1] == 0) {
+      fprintf(stderr, "transfers by port registers, round %u, %s\n", round,
+              clocked[0] != clocked[1] ? "shift out the wrong bits" :
+              edges[0] != edges[1] ? "make a different number of edges" :
+              "are not made by port registers alone");
+      return false;
+    }
+  }
+  // an input bank of 3 PISOs, read from a modelled chain filled with test bytes
+  // before each scan, the first shifted in first so read first
+  SIPO8_sim::reset();
+  SIPO8 inputs(1, 0);
+  inputs.create_input_bank(2, 3, 4, 3);
+  inputs.use_debounce(false);
+  SIPO8_sim::add_chain(5, 3, 2, 3 * 8);
+  static const uint16_t no_pins[16] = {0};
+  for (uint16_t round = 0; round < 64; round++) {
+    uint8_t bytes[3];
+    for (uint8_t PISO = 0; PISO < 3; PISO++) bytes[PISO] = (uint8_t)pseudo_random();
+    std::vector<uint32_t> clocked[2];
+    uint64_t reads[2], port_reads[2];
+    bool read_ok = true;
+    for (uint8_t fast_io = 0; fast_io < 2; fast_io++) {
+      inputs.use_fast_io(fast_io);
+      for (uint8_t bit = 0; bit < 3 * 8; bit++) {
+        SIPO8_digital_write(5, bytes[bit / 8] >> (7 - bit % 8) & 1);
+        SIPO8_digital_write(3, HIGH);
+        SIPO8_digital_write(3, LOW);
+      }
+      SIPO8_sim::clear_counts();
+      uint16_t levels = pin_levels();
+      inputs.scan_inputs();
+      clocked[fast_io]    = clocked_levels(levels, 1 << 3 | 1 << 4, no_pins);
+      reads[fast_io]      = SIPO8_sim::num_reads();
+      port_reads[fast_io] = SIPO8_sim::num_port_reads();
+      for (SIPO8_index PISO = 0; PISO < 3; PISO++) {
+        read_ok = read_ok && inputs.read_input_bank_PISO(0, PISO) == bytes[PISO];
+      }
+    }
+    if (!read_ok || clocked[0] != clocked[1] || port_reads[0] != 0 || reads[1] != 0 ||
+        port_reads[1] == 0) {
+      fprintf(stderr, "input scan by port registers, round %u, %s\n", round,
+              !read_ok ? "reads the wrong bits" :
+              clocked[0] != clocked[1] ? "clocks or loads differently" :
+              "is not made by port registers alone");
+      return false;
+    }
+  }
+  SIPO8_sim::record_edges(false);
+  pseudo_random_state = random_state;
+  return true;
+}
+
+// benchmarks transfers to a bank of 32 SIPOs and to groups of 4 banks of 8 SIPOs,
+// their data pins on one port and on 4, and scans of an input bank of 32 PISOs,
+// made by digitalWrite and by port register writes
+static void bench_fast_io() {
+  static const uint8_t group_data_pins[2][4] = {{2, 5, 6, 7}, {2, 9, 17, 25}};
+  static const char * const configs[3] = {"32 SIPOs/1 bank", "32 SIPOs/group 1 port",
+                                          "32 SIPOs/group 4 ports"};
+  for (uint8_t config = 0; config < 3; config++) {
+    SIPO8_sim::reset();
+    SIPO8_sim::set_gpio_cost_ns(gpio_ns);
+    SIPO8_sim::set_port_cost_ns(port_ns);
+    SIPO8 SIPOs(32, 0);
+#if SIPO8_STATS
+    bench_SIPOs = &SIPOs;
+#endif
+    if (config == 0) {
+      SIPOs.create_bank(2, 3, 4, 32);
+    } else {
+      for (uint8_t bank = 0; bank < 4; bank++) {
+        SIPOs.create_bank(group_data_pins[config - 1][bank], 3, 4, 8);
+      }
+    }
+    for (SIPO8_pin pin = 0; pin < SIPOs.num_active_pins; pin++) {
+      SIPOs.set_array_pin(pin, pseudo_random() & 1);
+    }
+    for (uint8_t fast_io = 0; fast_io < 2; fast_io++) {
+      SIPOs.use_fast_io(fast_io);
+      report(configs[config], fast_io ? "xfer_array, port regs" : "xfer_array, digitalWrite",
+             run(iterations, [&](uint32_t) { SIPOs.xfer_array(MSBFIRST); }));
+    }
+  }
+  SIPO8_sim::reset();
+  SIPO8 inputs(1, 0);
+#if SIPO8_STATS
+  bench_SIPOs = &inputs;
+#endif
+  inputs.create_input_bank(2, 3, 4, 32);
+  for (uint8_t fast_io = 0; fast_io < 2; fast_io++) {
+    inputs.use_fast_io(fast_io);
+    report("32 PISOs/1 bank", fast_io ? "scan_inputs, port regs" : "scan_inputs, digitalRead",
+           run(iterations, [&](uint32_t) { inputs.scan_inputs(); }));
+  }
+}
+#endif
+
+int main(int argc, char ** argv) {
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--gpio-ns") == 0 && arg + 1 < argc) {
+      gpio_ns = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "--port-ns") == 0 && arg + 1 < argc) {
+      port_ns = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc) {
+      iterations = strtoul(argv[++arg], NULL, 10);
+      if (iterations == 0) iterations = 1;
+    } else if (strcmp(argv[arg], "--csv") == 0) {
+      csv = true;
+    } else {
+      fprintf(stderr, "usage: %s [--gpio-ns N] [--port-ns N] [--iterations N] [--csv]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (csv) {
+    printf("config,op,writes_per_op,edges_per_op,sim_us_per_op,host_ns_per_op");
+#if SIPO8_STATS
+    printf(",xfers_per_op,bytes_per_op,bits_per_op,xfer_us_max");
+#endif
+  } else {
+    printf("SIPO8 host benchmark, %u ns per pin write", gpio_ns);
+#if SIPO8_FAST_IO
+    printf(", %u ns per port register read or write", port_ns);
+#endif
+    printf("\n\n");
+    printf("%-22s %-26s %10s %10s %12s %12s", "config", "op", "writes/op",
+           "edges/op", "sim_us/op", "host_ns/op");
+#if SIPO8_STATS
+    printf(" %10s %10s %10s %12s", "xfers/op", "bytes/op", "bits/op", "xfer_us_max");
+#endif
+  }
+  printf("\n");
+  if (!check_wiring()) return 1;
+  if (!check_chunked_xfer()) return 1;
+  if (!check_chain_verify()) return 1;
+  if (!check_bcm()) return 1;
+  if (!check_debounce()) return 1;
+  if (!check_timer_heap()) return 1;
+  if (!check_array_ranges()) return 1;
+#if SIPO8_FAST_IO
+  if (!check_fast_io()) return 1;
+#endif
+#if SIPO8_INDEX_BITS > 8
+  if (!check_large_array()) return 1;
+#endif
+  static const uint16_t configs[][2] = {
+    {1, 1}, {8, 1}, {8, 8}, {32, 1}, {32, 32}, {128, 4}, {128, 128}, {255, 1}, {255, 255}
+#if SIPO8_INDEX_BITS > 8
+    , {1280, 16}, {1280, 1280}
+#endif
+  };
+  for (uint8_t config = 0; config < sizeof(configs) / sizeof(configs[0]); config++) {
+    if (!bench_config(configs[config][0], configs[config][1])) return 1;
+  }
+#if SIPO8_FAST_IO
+  bench_fast_io();
+#endif
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+   SIPO8 host pattern benchmark
+
+   Encodes the chaser and strobe patterns of the library's LED_chaser and strobe
+   examples, at the examples' sizes and for large pin arrays, with a key frame
+   every --key-interval frames and XOR frames between, and reports for each:
+     frames       - frames in the pattern
+     keys         - key (full) frames written
+     full_bytes   - pattern length with every frame a full frame
+     coded_bytes  - pattern length as encoded
+     ratio        - full_bytes / coded_bytes
+     play_ns/f    - host time per frame for SIPO8_player to decode the encoded
+                    pattern into the pin status bytes
+     full_ns/f    - the same for the all full frame pattern
+     decode_ns/f  - host time per frame for SIPO8_pattern_decoder
+
+   Every frame decoded by SIPO8_player and SIPO8_pattern_decoder is checked
+   against the frame encoded, and SIPO8_player is checked to refuse the pattern
+   if its first frame is made an XOR frame. The byte counts are exact, the times indicative
+   only.
+
+   See README.md in this directory for how to build, then run as:
+     ./SIPO8_pattern_bench [--key-interval N] [--passes N] [--csv]
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_pattern.h>
+#include <SIPO8_pattern_codec.h>
+#include <SIPO8_sim.h>
+#include <chrono>
+
+#define frame_duration 50 // milli seconds, as the strobe example
+
+static uint16_t key_interval = 64;
+static uint32_t passes       = 20;
+static bool     csv          = false;
+
+typedef std::vector<std::vector<uint8_t> > frame_list;
+
+static void add_frame(frame_list & frames, const std::vector<bool> & pins) {
+  std::vector<uint8_t> status_bytes((pins.size() + 7) / 8, 0);
+  for (uint16_t pin = 0; pin < pins.size(); pin++) {
+    if (pins[pin]) status_bytes[pin / 8] |= 1 << (pin % 8);
+  }
+  frames.push_back(status_bytes);
+}
+
+// LED_chaser example - pins set one by one, then all cleared
+static frame_list chaser_frames(uint16_t num_pins) {
+  frame_list frames;
+  std::vector<bool> pins(num_pins, false);
+  for (uint16_t pin = 0; pin < num_pins; pin++) {
+    pins[pin] = true;
+    add_frame(frames, pins);
+  }
+  pins.assign(num_pins, false);
+  add_frame(frames, pins);
+  return frames;
+}
+
+// strobe example - each pin lit then cleared in turn, forwards then backwards
+static frame_list strobe_frames(uint16_t num_pins) {
+  frame_list frames;
+  std::vector<bool> pins(num_pins, false);
+  for (uint32_t step = 0; step < 2 * (uint32_t) num_pins; step++) {
+    uint16_t pin = step < num_pins ? step : 2 * num_pins - 1 - step;
+    pins[pin] = true;
+    add_frame(frames, pins);
+    pins[pin] = false;
+    add_frame(frames, pins);
+  }
+  return frames;
+}
+
+static double ns_per_frame(std::chrono::steady_clock::duration host_time, uint32_t num_frames) {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(host_time).count() /
+         num_frames;
+}
+
+// host time per frame for SIPO8_player to decode the pattern, which must be of
+// frames, or -1 if a frame decoded differs
+static double time_player(SIPO8 & SIPOs, const std::vector<uint8_t> & pattern,
+                          const frame_list & frames) {
+  SIPO8_player player(SIPOs);
+  player.play(&pattern[0], pattern_in_RAM, play_repeat, MSBFIRST);
+  for (uint32_t frame = 0; frame < frames.size(); frame++) {
+    player.next_frame();
+    if (memcmp(SIPOs.pin_status_bytes, &frames[frame][0], frames[frame].size()) != 0) return -1;
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < passes * frames.size(); frame++) {
+    player.next_frame();
+  }
+  return ns_per_frame(std::chrono::steady_clock::now() - start, passes * frames.size());
+}
+
+// as time_player, for SIPO8_pattern_decoder
+static double time_decoder(const std::vector<uint8_t> & pattern, const frame_list & frames) {
+  SIPO8_pattern_decoder decoder;
+  if (!decoder.open(&pattern[0], pattern.size())) return -1;
+  std::vector<uint8_t> status_bytes(decoder.num_bytes());
+  uint16_t duration;
+  for (uint32_t frame = 0; frame < frames.size(); frame++) {
+    if (!decoder.next(&status_bytes[0], duration) || status_bytes != frames[frame]) return -1;
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < passes; pass++) {
+    decoder.rewind();
+    while (decoder.next(&status_bytes[0], duration)) {}
+  }
+  return ns_per_frame(std::chrono::steady_clock::now() - start, passes * frames.size());
+}
+
+static bool bench_pattern(const char * name, uint16_t num_pins, const frame_list & frames) {
+  uint8_t num_bytes = frames[0].size();
+  SIPO8_pattern_encoder encoder(num_bytes, key_interval);
+  SIPO8_pattern_encoder full_encoder(num_bytes, 1);
+  for (uint32_t frame = 0; frame < frames.size(); frame++) {
+    encoder.add_frame(&frames[frame][0], frame_duration);
+    full_encoder.add_frame(&frames[frame][0], frame_duration);
+  }
+  const std::vector<uint8_t> & pattern      = encoder.pattern();
+  const std::vector<uint8_t> & full_pattern = full_encoder.pattern();
+  SIPO8_sim::reset();
+  SIPO8 SIPOs(num_bytes, 0);
+  SIPOs.create_bank(2, 3, 4, num_bytes);
+  // a pattern must open with a full frame, else play would XOR it onto whatever
+  // the status bytes hold
+  std::vector<uint8_t> xor_first(pattern);
+  xor_first[pattern_header_size] = pattern_xor_frame;
+  if (SIPO8_player(SIPOs).play(&xor_first[0], pattern_in_RAM, play_once, MSBFIRST)) {
+    fprintf(stderr, "%s, %u pins: played a pattern opening with an XOR frame\n", name, num_pins);
+    return false;
+  }
+  double play_ns   = time_player(SIPOs, pattern, frames);
+  double full_ns   = time_player(SIPOs, full_pattern, frames);
+  double decode_ns = time_decoder(pattern, frames);
+  if (play_ns < 0 || full_ns < 0 || decode_ns < 0) {
+    fprintf(stderr, "%s, %u pins: decoded frames differ from those encoded\n", name, num_pins);
+    return false;
+  }
+  double ratio = (double) full_pattern.size() / pattern.size();
+  if (csv) {
+    printf("%s,%u,%u,%u,%u,%u,%.2f,%.1f,%.1f,%.1f\n", name, num_pins, encoder.num_frames(),
+           encoder.num_key_frames(), (unsigned) full_pattern.size(), (unsigned) pattern.size(),
+           ratio, play_ns, full_ns, decode_ns);
+  } else {
+    printf("%-8s %6u %7u %6u %11u %11u %7.2f %10.1f %10.1f %11.1f\n", name, num_pins,
+           encoder.num_frames(), encoder.num_key_frames(), (unsigned) full_pattern.size(),
+           (unsigned) pattern.size(), ratio, play_ns, full_ns, decode_ns);
+  }
+  return true;
+}
+
+int main(int argc, char ** argv) {
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--key-interval") == 0 && arg + 1 < argc) {
+      key_interval = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "--passes") == 0 && arg + 1 < argc) {
+      passes = strtoul(argv[++arg], NULL, 10);
+      if (passes == 0) passes = 1;
+    } else if (strcmp(argv[arg], "--csv") == 0) {
+      csv = true;
+    } else {
+      fprintf(stderr, "usage: %s [--key-interval N] [--passes N] [--csv]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (csv) {
+    printf("pattern,pins,frames,keys,full_bytes,coded_bytes,ratio,play_ns_per_frame,"
+           "full_ns_per_frame,decode_ns_per_frame\n");
+  } else {
+    printf("SIPO8 pattern benchmark, key frame every %u frames\n\n", key_interval);
+    printf("%-8s %6s %7s %6s %11s %11s %7s %10s %10s %11s\n", "pattern", "pins", "frames",
+           "keys", "full_bytes", "coded_bytes", "ratio", "play_ns/f", "full_ns/f", "decode_ns/f");
+  }
+  // the examples' sizes, then large pin arrays
+  static const uint16_t sizes[] = {8, 64, 1024, 2040};
+  bool all_ok = true;
+  for (uint8_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); size++) {
+    all_ok = bench_pattern("chaser", sizes[size], chaser_frames(sizes[size])) && all_ok;
+    all_ok = bench_pattern("strobe", sizes[size], strobe_frames(sizes[size])) && all_ok;
+  }
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/*
+   SIPO8 host pattern encoder and decoder, see SIPO8_pattern_codec.h
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <SIPO8_pattern_codec.h>
+#include <ez_SIPO8_pattern.h>
+
+SIPO8_pattern_encoder::SIPO8_pattern_encoder(uint8_t num_bytes, uint16_t key_interval) :
+  _num_bytes(num_bytes),
+  _key_interval(key_interval),
+  _previous(num_bytes, 0) {
+  const uint8_t header[pattern_header_size] = {pattern_version, num_bytes, pattern_uint16(0)};
+  _pattern.assign(header, header + pattern_header_size);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Adds a frame of num_bytes status bytes, shown for duration milli seconds. A key
+// frame is written when one is due, or when the frame's XOR runs would be no
+// smaller, otherwise an XOR frame.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_pattern_encoder::add_frame(const uint8_t * status_bytes, uint16_t duration) {
+  if (_num_bytes == 0 || _num_frames == 0xFFFF) return false;
+  std::vector<uint8_t> runs;
+  bool key_frame = _num_frames == 0 ||
+                   (_key_interval > 0 && _num_frames % _key_interval == 0);
+  if (!key_frame) {
+    xor_runs(&_previous[0], status_bytes, _num_bytes, runs);
+    key_frame = runs.size() >= _num_bytes;
+  }
+  const uint8_t frame_header[3] = {(uint8_t)(key_frame ? pattern_full_frame : pattern_xor_frame),
+                                   pattern_uint16(duration)};
+  _pattern.insert(_pattern.end(), frame_header, frame_header + 3);
+  if (key_frame) {
+    _pattern.insert(_pattern.end(), status_bytes, status_bytes + _num_bytes);
+    _num_key_frames++;
+  } else {
+    _pattern.insert(_pattern.end(), runs.begin(), runs.end());
+  }
+  _previous.assign(status_bytes, status_bytes + _num_bytes);
+  _num_frames++;
+  _pattern[2] = _num_frames & 0xFF;
+  _pattern[3] = _num_frames >> 8;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Appends the XOR frame runs taking the previous status bytes to the given ones.
+// Unchanged bytes become skip runs, or the end of the frame if no later byte
+// changes, runs of 3 or more equal changes become repeat runs, and the changes
+// between become literal runs. A literal run carries on through a lone unchanged
+// byte, which costs it a byte rather than the 2 of a skip run and a new literal
+// run.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_pattern_encoder::xor_runs(const uint8_t * previous, const uint8_t * status_bytes,
+                                     uint8_t num_bytes, std::vector<uint8_t> & runs) {
+  std::vector<uint8_t> changes(num_bytes);
+  for (uint16_t status_byte = 0; status_byte < num_bytes; status_byte++) {
+    changes[status_byte] = previous[status_byte] ^ status_bytes[status_byte];
+  }
+  // number of equal changes from the given byte, up to pattern_run_max
+  auto equal_run = [&](uint16_t from) {
+    uint16_t to = from + 1;
+    while (to < num_bytes && to - from < pattern_run_max && changes[to] == changes[from]) to++;
+    return to - from;
+  };
+  uint16_t status_byte = 0;
+  while (status_byte < num_bytes) {
+    if (changes[status_byte] == 0) {
+      uint16_t unchanged_end = status_byte;
+      while (unchanged_end < num_bytes && changes[unchanged_end] == 0) unchanged_end++;
+      if (unchanged_end == num_bytes) {
+        runs.push_back(pattern_run_end);
+        return;
+      }
+      while (status_byte < unchanged_end) {
+        uint16_t run_length = unchanged_end - status_byte;
+        if (run_length > pattern_run_max) run_length = pattern_run_max;
+        runs.push_back(pattern_run(pattern_run_skip, run_length));
+        status_byte = status_byte + run_length;
+      }
+    } else if (equal_run(status_byte) >= 3) {
+      uint16_t run_length = equal_run(status_byte);
+      runs.push_back(pattern_run(pattern_run_repeat, run_length));
+      runs.push_back(changes[status_byte]);
+      status_byte = status_byte + run_length;
+    } else {
+      uint16_t literal_end = status_byte + 1;
+      while (literal_end < num_bytes && literal_end - status_byte < pattern_run_max) {
+        if (changes[literal_end] == 0 &&
+            (literal_end + 1 == num_bytes || changes[literal_end + 1] == 0)) break;
+        if (equal_run(literal_end) >= 4) break;
+        literal_end++;
+      }
+      runs.push_back(pattern_run(pattern_run_literal, literal_end - status_byte));
+      runs.insert(runs.end(), changes.begin() + status_byte, changes.begin() + literal_end);
+      status_byte = literal_end;
+    }
+  }
+}
+
+const std::vector<uint8_t> & SIPO8_pattern_encoder::pattern() const {
+  return _pattern;
+}
+
+bool SIPO8_pattern_encoder::save(const char * path) const {
+  FILE * file = fopen(path, "wb");
+  if (file == NULL) return false;
+  bool written = fwrite(&_pattern[0], 1, _pattern.size(), file) == _pattern.size();
+  return fclose(file) == 0 && written;
+}
+
+uint16_t SIPO8_pattern_encoder::num_frames() const {
+  return _num_frames;
+}
+
+uint16_t SIPO8_pattern_encoder::num_key_frames() const {
+  return _num_key_frames;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Decoder.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_pattern_decoder::open(const uint8_t * pattern, uint32_t length) {
+  _pattern = NULL;
+  if (SIPO8_player::pattern_length(pattern, pattern_in_RAM, length) == 0) return false;
+  _pattern = pattern;
+  _status_bytes.assign(num_bytes(), 0);
+  rewind();
+  return true;
+}
+
+void SIPO8_pattern_decoder::rewind() {
+  _next  = _pattern + pattern_header_size;
+  _frame = 0;
+}
+
+bool SIPO8_pattern_decoder::next(uint8_t * status_bytes, uint16_t & duration) {
+  if (_pattern == NULL || _frame == num_frames()) return false;
+  uint8_t frame_type = _next[0];
+  duration = _next[1] | _next[2] << 8;
+  _next = _next + 3;
+  uint8_t * frame_bytes = &_status_bytes[0];
+  if (frame_type == pattern_full_frame) {
+    memcpy(frame_bytes, _next, num_bytes());
+    _next = _next + num_bytes();
+  } else if (frame_type == pattern_delta_frame) {
+    uint8_t count = *_next++;
+    for (; count > 0; count--, _next = _next + 2) {
+      frame_bytes[_next[0]] = _next[1];
+    }
+  } else {
+    uint16_t status_byte = 0;
+    while (status_byte < num_bytes()) {
+      uint8_t run = *_next++;
+      uint8_t run_type = run & pattern_run_type_mask;
+      if (run_type == pattern_run_end) break;
+      uint8_t run_length = (run & ~pattern_run_type_mask) + 1;
+      if (run_type == pattern_run_repeat) {
+        for (uint8_t run_byte = 0; run_byte < run_length; run_byte++) {
+          frame_bytes[status_byte + run_byte] ^= _next[0];
+        }
+        _next = _next + 1;
+      } else if (run_type == pattern_run_literal) {
+        for (uint8_t run_byte = 0; run_byte < run_length; run_byte++) {
+          frame_bytes[status_byte + run_byte] ^= _next[run_byte];
+        }
+        _next = _next + run_length;
+      }
+      status_byte = status_byte + run_length;
+    }
+  }
+  memcpy(status_bytes, frame_bytes, num_bytes());
+  _frame++;
+  return true;
+}
+
+uint8_t SIPO8_pattern_decoder::num_bytes() const {
+  return _pattern == NULL ? 0 : _pattern[1];
+}
+
+uint16_t SIPO8_pattern_decoder::num_frames() const {
+  return _pattern == NULL ? 0 : _pattern[2] | _pattern[3] << 8;
+}
@@ -0,0 +1,66 @@
+/*
+   SIPO8 host pattern encoder and decoder
+
+   Builds patterns (see ez_SIPO8_pattern.h for the format) from a sequence of
+   frames of pin status bytes, for installations too large for every frame to be
+   stored in full. A key (full) frame is written every key_interval frames and
+   the frames between are written as run length encoded XOR frames, holding only
+   the status bytes that change. The decoder turns a pattern back into its frames,
+   independently of SIPO8_player, for checking patterns and players against each
+   other.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_pattern_codec_h
+#define SIPO8_pattern_codec_h
+
+#include <Arduino.h>
+#include <vector>
+
+class SIPO8_pattern_encoder
+{
+  public:
+    // key_interval is the frames from one key frame to the next, 0 for the first
+    // frame only
+    SIPO8_pattern_encoder(uint8_t num_bytes, uint16_t key_interval);
+
+    bool add_frame(const uint8_t *, uint16_t);    // status bytes, duration - false if 65535 frames
+    const std::vector<uint8_t> & pattern() const; // to be played as pattern_in_RAM, or saved
+    bool save(const char *) const;                // writes the pattern to the given file
+    uint16_t num_frames() const;
+    uint16_t num_key_frames() const;
+
+  private:
+    static void xor_runs(const uint8_t *, const uint8_t *, uint8_t, std::vector<uint8_t> &);
+
+    uint8_t  _num_bytes;
+    uint16_t _key_interval;
+    uint16_t _num_frames     = 0;
+    uint16_t _num_key_frames = 0;
+    std::vector<uint8_t> _pattern;
+    std::vector<uint8_t> _previous; // status bytes of the last frame added
+};
+
+class SIPO8_pattern_decoder
+{
+  public:
+    SIPO8_pattern_decoder() {}
+
+    bool open(const uint8_t *, uint32_t); // pattern, length - false if not a valid pattern
+    void rewind();                        // back to the first frame
+    bool next(uint8_t *, uint16_t &);     // decodes the next frame's status bytes and duration,
+                                          // false after the last frame
+    uint8_t  num_bytes() const;
+    uint16_t num_frames() const;
+
+  private:
+    const uint8_t * _pattern = NULL;
+    const uint8_t * _next    = NULL;
+    uint16_t _frame          = 0;
+    std::vector<uint8_t> _status_bytes;
+};
+
+#endif
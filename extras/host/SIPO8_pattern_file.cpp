@@ -0,0 +1,59 @@
+/*
+   SIPO8 host pattern files, see SIPO8_pattern_file.h
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <SIPO8_pattern_file.h>
+#include <ez_SIPO8_pattern.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SIPO8_pattern_file::~SIPO8_pattern_file() {
+  close();
+}
+
+bool SIPO8_pattern_file::open(const char * path) {
+  close();
+  int file = ::open(path, O_RDONLY);
+  if (file < 0) return false;
+  struct stat file_status;
+  if (fstat(file, &file_status) != 0 || file_status.st_size <= 0) {
+    ::close(file);
+    return false;
+  }
+  void * mapping = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);  // the mapping remains valid
+  if (mapping == MAP_FAILED) return false;
+  _mapping      = (const uint8_t *) mapping;
+  _mapping_size = file_status.st_size;
+  // the whole file must be a single valid pattern
+  uint32_t max_length = _mapping_size > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) _mapping_size;
+  _length = SIPO8_player::pattern_length(_mapping, pattern_in_RAM, max_length);
+  if (_length == 0 || _length != _mapping_size) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void SIPO8_pattern_file::close() {
+  if (_mapping != NULL) {
+    munmap((void *) _mapping, _mapping_size);
+  }
+  _mapping      = NULL;
+  _mapping_size = 0;
+  _length       = 0;
+}
+
+const uint8_t * SIPO8_pattern_file::pattern() const {
+  return _mapping;
+}
+
+uint32_t SIPO8_pattern_file::length() const {
+  return _length;
+}
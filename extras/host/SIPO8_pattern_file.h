@@ -0,0 +1,39 @@
+/*
+   SIPO8 host pattern files
+
+   Maps a pattern file (see ez_SIPO8_pattern.h for the format) into memory, so it
+   may be played by SIPO8_player on a desktop machine exactly as a PROGMEM pattern
+   is on an Arduino - read in place, a frame at a time, without being loaded.
+   POSIX (Linux, macOS, etc) only.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_pattern_file_h
+#define SIPO8_pattern_file_h
+
+#include <Arduino.h>
+
+class SIPO8_pattern_file
+{
+  public:
+    SIPO8_pattern_file() {}
+    ~SIPO8_pattern_file();
+
+    bool open(const char *);         // false if the file cannot be mapped or is not a valid pattern
+    void close();
+    const uint8_t * pattern() const; // to be played as pattern_in_RAM, NULL if not open
+    uint32_t length() const;         // pattern length in bytes
+
+  private:
+    SIPO8_pattern_file(const SIPO8_pattern_file &);
+    SIPO8_pattern_file & operator=(const SIPO8_pattern_file &);
+
+    const uint8_t * _mapping = NULL;
+    size_t   _mapping_size   = 0;
+    uint32_t _length         = 0;
+};
+
+#endif
@@ -0,0 +1,419 @@
+/*
+   SIPO8 host remote client, see SIPO8_remote_client.h
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <SIPO8_remote_client.h>
+#include <chrono>
+#include <errno.h>
+#include <thread>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+SIPO8_remote_client::SIPO8_remote_client(send_function send, receive_function receive) :
+  _send(send),
+  _receive(receive) {
+  memset(&_info, 0, sizeof(_info));
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Reads the remote info. Until connected, requests are sent one frame at a time
+// and kept short enough for the smallest receive buffer SIPO8_remote allows.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::connect() {
+  std::vector<uint8_t> data;
+  if (!send_request(remote_read_info, std::vector<uint8_t>(), false) || !await_response(&data)) {
+    return false;
+  }
+  if (data.size() < 12 || data[0] != remote_protocol_version || data[1] < 1 || data[1] > 2) {
+    _last_status = remote_bad_length;
+    return false;
+  }
+  _info.version         = data[0];
+  _info.offset_size     = data[1];
+  _info.num_banks       = data[2] | data[3] << 8;
+  _info.num_SIPOs       = data[4] | data[5] << 8;
+  _info.num_input_banks = data[6] | data[7] << 8;
+  _info.num_input_bytes = data[8] | data[9] << 8;
+  _info.buffer_size     = data[10] | data[11] << 8;
+  _window               = _info.buffer_size;
+  return true;
+}
+
+const SIPO8_remote_client::remote_info & SIPO8_remote_client::info() const {
+  return _info;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Pipelined requests. These return once sent, so return false only if a request
+// sent earlier has failed - the failure of the last is returned by flush. Status
+// bytes are addressed by the offset size the remote reports, so connect first.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::write_bytes(uint16_t first_byte, const uint8_t * bytes, uint16_t num_bytes) {
+  if (!addressable(first_byte, num_bytes)) return false;
+  uint16_t max_chunk = _window - remote_frame_overhead - _info.offset_size;
+  if (max_chunk > 255 - _info.offset_size) max_chunk = 255 - _info.offset_size;
+  while (num_bytes > 0) {
+    uint16_t chunk = num_bytes < max_chunk ? num_bytes : max_chunk;
+    std::vector<uint8_t> payload = offset(first_byte);
+    payload.insert(payload.end(), bytes, bytes + chunk);
+    if (!send_request(remote_write_bytes, payload, true)) return false;
+    first_byte = first_byte + chunk;
+    bytes      = bytes + chunk;
+    num_bytes  = num_bytes - chunk;
+  }
+  return true;
+}
+
+bool SIPO8_remote_client::fill_banks(uint16_t from_bank, uint16_t to_bank, bool pin_status) {
+  if (!addressable(from_bank, 1) || !addressable(to_bank, 1)) return false;
+  std::vector<uint8_t> payload = offset(from_bank);
+  std::vector<uint8_t> to      = offset(to_bank);
+  payload.insert(payload.end(), to.begin(), to.end());
+  payload.push_back(pin_status);
+  return send_request(remote_fill_banks, payload, true);
+}
+
+bool SIPO8_remote_client::xfer(bool msb_or_lsb, uint8_t xfer_what) {
+  const uint8_t payload[2] = {msb_or_lsb, xfer_what};
+  return send_request(remote_xfer, std::vector<uint8_t>(payload, payload + 2), true);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Requests sent one at a time, after those pipelined have been answered.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::invert_banks(uint16_t from_bank, uint16_t to_bank) {
+  if (!addressable(from_bank, 1) || !addressable(to_bank, 1)) return false;
+  std::vector<uint8_t> payload = offset(from_bank);
+  std::vector<uint8_t> to      = offset(to_bank);
+  payload.insert(payload.end(), to.begin(), to.end());
+  return send_request(remote_invert_banks, payload, false) && await_response(NULL);
+}
+
+bool SIPO8_remote_client::read_bytes(uint8_t source, uint16_t first_byte, uint16_t num_bytes,
+                                     uint8_t * bytes) {
+  if (!addressable(first_byte, num_bytes)) return false;
+  while (num_bytes > 0) {
+    uint8_t chunk = num_bytes < 254 ? num_bytes : 254;
+    std::vector<uint8_t> payload(1, source);
+    std::vector<uint8_t> first = offset(first_byte);
+    payload.insert(payload.end(), first.begin(), first.end());
+    payload.push_back(chunk);
+    std::vector<uint8_t> data;
+    if (!send_request(remote_read_bytes, payload, false) || !await_response(&data)) {
+      return false;
+    }
+    if (data.size() != chunk) {
+      _last_status = remote_bad_length;
+      return false;
+    }
+    memcpy(bytes, &data[0], chunk);
+    first_byte = first_byte + chunk;
+    bytes      = bytes + chunk;
+    num_bytes  = num_bytes - chunk;
+  }
+  return true;
+}
+
+// Banks beyond those the remote can address are sent as the largest it can, which
+// is never a bank, so that the remote skips their commands rather than applying
+// them to another bank.
+int SIPO8_remote_client::submit_batch(const SIPO8::batch_command * commands, uint16_t num_commands) {
+  if (!addressable(0, 1)) return -1;
+  uint16_t command_size = 4 + _info.offset_size;
+  uint16_t no_bank      = (1UL << 8 * _info.offset_size) - 1;
+  uint16_t max_chunk    = (_window - remote_frame_overhead) / command_size;
+  if (max_chunk > 255 / command_size) max_chunk = 255 / command_size;
+  int num_applied = 0;
+  while (num_commands > 0) {
+    uint16_t chunk = num_commands < max_chunk ? num_commands : max_chunk;
+    std::vector<uint8_t> payload;
+    for (uint16_t command = 0; command < chunk; command++) {
+      std::vector<uint8_t> bank = offset(commands[command].command_bank < no_bank ?
+                                         commands[command].command_bank : no_bank);
+      payload.push_back(commands[command].command_op);
+      payload.insert(payload.end(), bank.begin(), bank.end());
+      payload.push_back(commands[command].command_index & 0xFF);
+      payload.push_back(commands[command].command_index >> 8);
+      payload.push_back(commands[command].command_value);
+    }
+    std::vector<uint8_t> data;
+    if (!send_request(remote_batch, payload, false) || !await_response(&data) || data.size() != 1) {
+      return -1;
+    }
+    num_applied  = num_applied + data[0];
+    commands     = commands + chunk;
+    num_commands = num_commands - chunk;
+  }
+  return num_applied;
+}
+
+bool SIPO8_remote_client::flush() {
+  while (!_pending.empty()) {
+    if (!await_response(NULL)) return false;
+  }
+  return true;
+}
+
+uint8_t SIPO8_remote_client::last_status() const {
+  return _last_status;
+}
+
+void SIPO8_remote_client::set_timeout_ms(uint32_t timeout_ms) {
+  _timeout_ms = timeout_ms;
+}
+
+void SIPO8_remote_client::set_retries(uint8_t retries) {
+  _retries = retries;
+}
+
+uint32_t SIPO8_remote_client::num_resent() const {
+  return _num_resent;
+}
+
+uint64_t SIPO8_remote_client::num_bytes_sent() const {
+  return _num_bytes_sent;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sends a request, first waiting for responses until it fits the window, or for
+// every response if it is not to be pipelined.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::send_request(uint8_t command, const std::vector<uint8_t> & payload,
+                                       bool pipelined) {
+  pending_request request;
+  request.sequence = _next_sequence++;
+  request.command  = command;
+  request.frame    = frame(request.sequence, command, payload.empty() ? NULL : &payload[0],
+                           payload.size());
+  while (!_pending.empty() &&
+         (!pipelined || _pending_bytes + request.frame.size() > _window ||
+          _pending.size() == remote_max_outstanding)) {
+    if (!await_response(NULL)) return false;
+  }
+  _send(&request.frame[0], request.frame.size());
+  _num_bytes_sent = _num_bytes_sent + request.frame.size();
+  _pending_bytes  = _pending_bytes + request.frame.size();
+  _pending.push_back(request);
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Waits for the response to the oldest request not yet answered, giving its data
+// after the status. If none arrives in time, resends every request not yet
+// answered, in order, so that the requests are applied in the order sent.
+// Returns false if the response's status is not remote_ok, or if there is no
+// response after the given number of retries, when the requests not yet answered
+// are abandoned.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::await_response(std::vector<uint8_t> * data) {
+  if (_pending.empty()) return false;
+  uint8_t tries = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (true) {
+    uint8_t sequence, command;
+    std::vector<uint8_t> payload;
+    while (next_response(sequence, command, payload)) {
+      const pending_request & request = _pending.front();
+      if (sequence != request.sequence || command != (request.command | remote_response) ||
+          payload.empty()) {
+        continue;  // a late response to a request resent, or not a response
+      }
+      _pending_bytes = _pending_bytes - request.frame.size();
+      _pending.pop_front();
+      if (payload[0] != remote_ok) {
+        _last_status = payload[0];
+        return false;
+      }
+      if (data != NULL) data->assign(payload.begin() + 1, payload.end());
+      return true;
+    }
+    if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(_timeout_ms)) {
+      if (tries == _retries) {
+        _pending.clear();
+        _pending_bytes = 0;
+        return false;
+      }
+      tries++;
+      // bytes still held may be the start of a response whose length was corrupted,
+      // which would be waited on, and every request they could answer is resent
+      _received.clear();
+      // and the remote may be waiting on a request whose length was corrupted, so
+      // first complete the longest frame with bytes that cannot start one
+      std::vector<uint8_t> padding(255 + remote_frame_overhead, 0);
+      _send(&padding[0], padding.size());
+      _num_bytes_sent = _num_bytes_sent + padding.size();
+      for (size_t request = 0; request < _pending.size(); request++) {
+        _send(&_pending[request].frame[0], _pending[request].frame.size());
+        _num_bytes_sent = _num_bytes_sent + _pending[request].frame.size();
+        _num_resent++;
+      }
+      start = std::chrono::steady_clock::now();
+    }
+    uint8_t bytes[256];
+    size_t  num_received = _receive(bytes, sizeof(bytes));
+    if (num_received > 0) {
+      _received.insert(_received.end(), bytes, bytes + num_received);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Takes the next complete frame valid by its CRC from the bytes received.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::next_response(uint8_t & sequence, uint8_t & command,
+                                        std::vector<uint8_t> & payload) {
+  size_t start = 0;
+  bool found = false;
+  while (start < _received.size()) {
+    if (_received[start] != remote_sync) {
+      start++;
+      continue;
+    }
+    if (_received.size() - start < remote_frame_overhead) break;
+    uint8_t length = _received[start + 3];
+    if (_received.size() - start < (size_t) length + remote_frame_overhead) break;
+    uint16_t crc = crc16(&_received[start + 1], 3 + length);
+    if (crc != (_received[start + 4 + length] | _received[start + 5 + length] << 8)) {
+      start++;
+      continue;
+    }
+    sequence = _received[start + 1];
+    command  = _received[start + 2];
+    payload.assign(_received.begin() + start + 4, _received.begin() + start + 4 + length);
+    start    = start + length + remote_frame_overhead;
+    found    = true;
+    break;
+  }
+  _received.erase(_received.begin(), _received.begin() + start);
+  return found;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Status byte and bank numbers, of the size the remote reports, little endian. A
+// range of them is addressable only once connected, and only if its every one is.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote_client::addressable(uint16_t first_byte, uint16_t num_bytes) {
+  if (_info.offset_size == 0 ||
+      (uint32_t)first_byte + num_bytes > (uint32_t)1 << 8 * _info.offset_size) {
+    _last_status = remote_out_of_range;
+    return false;
+  }
+  return true;
+}
+
+std::vector<uint8_t> SIPO8_remote_client::offset(uint16_t first_byte) const {
+  std::vector<uint8_t> offset_bytes(1, first_byte & 0xFF);
+  if (_info.offset_size == 2) offset_bytes.push_back(first_byte >> 8);
+  return offset_bytes;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Frame encoding.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+std::vector<uint8_t> SIPO8_remote_client::frame(uint8_t sequence, uint8_t command,
+                                                const uint8_t * payload, uint8_t length) {
+  std::vector<uint8_t> frame_bytes;
+  frame_bytes.reserve(length + remote_frame_overhead);
+  frame_bytes.push_back(remote_sync);
+  frame_bytes.push_back(sequence);
+  frame_bytes.push_back(command);
+  frame_bytes.push_back(length);
+  if (length > 0) frame_bytes.insert(frame_bytes.end(), payload, payload + length);
+  uint16_t crc = crc16(&frame_bytes[1], 3 + length);
+  frame_bytes.push_back(crc & 0xFF);
+  frame_bytes.push_back(crc >> 8);
+  return frame_bytes;
+}
+
+uint16_t SIPO8_remote_client::crc16(const uint8_t * bytes, size_t num_bytes, uint16_t crc) {
+  for (size_t next_byte = 0; next_byte < num_bytes; next_byte++) {
+    crc = SIPO8_remote::crc16(crc, bytes[next_byte]);
+  }
+  return crc;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Serial port.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_serial_port::~SIPO8_serial_port() {
+  close();
+}
+
+bool SIPO8_serial_port::open(const char * device, uint32_t baud) {
+  static const struct {
+    uint32_t baud;
+    speed_t  speed;
+  } speeds[] = {
+    {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200},
+    {230400, B230400},
+#ifdef B500000
+    {500000, B500000},
+#endif
+#ifdef B1000000
+    {1000000, B1000000},
+#endif
+#ifdef B2000000
+    {2000000, B2000000},
+#endif
+  };
+  close();
+  speed_t speed = 0;
+  bool speed_found = false;
+  for (size_t entry = 0; entry < sizeof(speeds) / sizeof(speeds[0]); entry++) {
+    if (speeds[entry].baud == baud) {
+      speed       = speeds[entry].speed;
+      speed_found = true;
+    }
+  }
+  if (!speed_found) return false;
+  _port = ::open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (_port < 0) return false;
+  struct termios settings;
+  if (tcgetattr(_port, &settings) != 0) {
+    close();
+    return false;
+  }
+  cfmakeraw(&settings);
+  settings.c_cflag |= CLOCAL | CREAD;
+  settings.c_cflag &= ~(CSTOPB | PARENB);
+  cfsetispeed(&settings, speed);
+  cfsetospeed(&settings, speed);
+  if (tcsetattr(_port, TCSANOW, &settings) != 0) {
+    close();
+    return false;
+  }
+  tcflush(_port, TCIOFLUSH);
+  return true;
+}
+
+void SIPO8_serial_port::close() {
+  if (_port >= 0) ::close(_port);
+  _port = -1;
+}
+
+void SIPO8_serial_port::send(const uint8_t * bytes, size_t num_bytes) {
+  while (_port >= 0 && num_bytes > 0) {
+    ssize_t written = ::write(_port, bytes, num_bytes);
+    if (written > 0) {
+      bytes     = bytes + written;
+      num_bytes = num_bytes - written;
+    } else if (written < 0 && errno != EAGAIN && errno != EINTR) {
+      return;  // the port has failed, responses will time out
+    } else {
+      std::this_thread::yield();  // output buffer full
+    }
+  }
+}
+
+size_t SIPO8_serial_port::receive(uint8_t * bytes, size_t max_bytes) {
+  if (_port < 0) return 0;
+  ssize_t num_read = ::read(_port, bytes, max_bytes);
+  return num_read > 0 ? num_read : 0;
+}
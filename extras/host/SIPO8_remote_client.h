@@ -0,0 +1,115 @@
+/*
+   SIPO8 host remote client
+
+   Reference client for the SIPO8_remote binary protocol (see ez_SIPO8_remote.h
+   for the frame format and commands), for driving a SIPO8 object on an Arduino
+   from a host PC. The client is independent of the link - it is given functions
+   to send bytes and to take the bytes received - and SIPO8_serial_port provides
+   these for a serial port (POSIX only).
+
+   Writes, fills and transfers are pipelined, up to remote_max_outstanding being
+   sent ahead of their responses, as far as the Arduino's receive buffer will
+   hold them. If a response does not arrive in time the requests not yet answered
+   are resent, in order, up to a number of retries - the Arduino applies each
+   request once, in sequence, however often it is resent.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_remote_client_h
+#define SIPO8_remote_client_h
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_remote.h>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class SIPO8_remote_client
+{
+  public:
+    typedef std::function<void(const uint8_t *, size_t)> send_function;
+    typedef std::function<size_t(uint8_t *, size_t)>      receive_function; // bytes received, 0 if none yet
+
+    struct remote_info {
+      uint8_t  version;
+      uint8_t  offset_size;      // bytes addressing a status byte or bank
+      uint16_t num_banks;
+      uint16_t num_SIPOs;        // bank_SIPO_count
+      uint16_t num_input_banks;
+      uint16_t num_input_bytes;
+      uint16_t buffer_size;      // longest request frame accepted
+    };
+
+    SIPO8_remote_client(send_function, receive_function);
+
+    bool connect();              // reads the remote info, which sets the pipelining window
+    const remote_info & info() const;
+
+    bool write_bytes(uint16_t, const uint8_t *, uint16_t); // first status byte, bytes, num bytes
+    bool fill_banks(uint16_t, uint16_t, bool);            // from bank, to bank, pin status
+    bool invert_banks(uint16_t, uint16_t);                // from bank, to bank
+    bool xfer(bool, uint8_t);                             // msb_or_lsb, remote_xfer_dirty or _array
+    bool read_bytes(uint8_t, uint16_t, uint16_t, uint8_t *); // source, first byte, num bytes, to
+    int  submit_batch(const SIPO8::batch_command *, uint16_t); // commands applied, -1 on failure
+    bool flush();                // waits for every pipelined request to be answered
+
+    uint8_t  last_status() const;   // status of the last failed request, remote_ok if none
+    void     set_timeout_ms(uint32_t);
+    void     set_retries(uint8_t);
+    uint32_t num_resent() const;    // requests resent
+    uint64_t num_bytes_sent() const;
+
+    static std::vector<uint8_t> frame(uint8_t, uint8_t, const uint8_t *, uint8_t); // sequence, command, payload
+    static uint16_t crc16(const uint8_t *, size_t, uint16_t = 0xFFFF);
+
+  private:
+    struct pending_request {
+      std::vector<uint8_t> frame;
+      uint8_t sequence;
+      uint8_t command;
+    };
+
+    send_function    _send;
+    receive_function _receive;
+    remote_info _info;
+    uint16_t _window         = 64;  // request bytes that may be outstanding, until connected
+    uint32_t _timeout_ms     = 500;
+    uint8_t  _retries        = 3;
+    uint8_t  _next_sequence  = 0;
+    uint8_t  _last_status    = remote_ok;
+    uint32_t _num_resent     = 0;
+    uint64_t _num_bytes_sent = 0;
+    std::deque<pending_request> _pending;  // sent, not yet answered
+    uint32_t _pending_bytes  = 0;
+    std::vector<uint8_t> _received;        // bytes received, not yet parsed
+
+    bool addressable(uint16_t, uint16_t);          // first status byte or bank, number
+    std::vector<uint8_t> offset(uint16_t) const;   // a status byte or bank as sent
+    bool send_request(uint8_t, const std::vector<uint8_t> &, bool);
+    bool await_response(std::vector<uint8_t> *);
+    bool next_response(uint8_t &, uint8_t &, std::vector<uint8_t> &);
+};
+
+class SIPO8_serial_port
+{
+  public:
+    SIPO8_serial_port() {}
+    ~SIPO8_serial_port();
+
+    bool open(const char *, uint32_t);   // device, baud rate - 8 data bits, no parity, 1 stop bit
+    void close();
+    void send(const uint8_t *, size_t);
+    size_t receive(uint8_t *, size_t);   // does not wait
+
+  private:
+    SIPO8_serial_port(const SIPO8_serial_port &);
+    SIPO8_serial_port & operator=(const SIPO8_serial_port &);
+
+    int _port = -1;
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*
+   SIPO8 host remote loopback harness
+
+   Connects a SIPO8_remote_client to a SIPO8_remote, driving a simulated SIPO8
+   object, through an in memory link, and checks that random sequences of
+   requests leave the remote SIPO8 object exactly as the same operations applied
+   directly to a second, model, SIPO8 object - first over a clean link, then with
+   bytes corrupted and dropped in both directions, which the CRC, resynchronising
+   and resending must recover from. Then reports the protocol's throughput for
+   full array writes at 1 and 2 Mbaud (8 data bits, no parity, 1 stop bit) and
+   the host time SIPO8_remote takes per byte received. With SIPO8_INDEX_BITS
+   above 8 the array has more than 255 SIPOs and banks, so that status bytes and
+   banks beyond the first 255 are addressed, by 2 bytes each.
+
+   See README.md in this directory for how to build, then run as:
+     ./SIPO8_remote_loopback [--operations N] [--seed N]
+
+   Exits with status 1 if any check fails.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+#include <ez_SIPO8_remote.h>
+#include <SIPO8_remote_client.h>
+#include <SIPO8_sim.h>
+#include <chrono>
+#include <deque>
+
+#if SIPO8_INDEX_BITS > 8
+#define test_SIPOs       364  // 4 banks of 64 SIPOs between them, and 300 of 1
+#define test_banks       304
+#else
+#define test_SIPOs        64
+#define test_banks         4
+#endif
+#define test_buffer_size 300
+
+static uint32_t operations = 2000;
+static uint32_t seed       = 1;
+
+static uint32_t pseudo_random() {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+// the link, with bytes corrupted or dropped at the given rates (1 in N, 0 for none)
+class loopback_link : public Stream {
+  public:
+    std::deque<uint8_t> to_remote;
+    std::deque<uint8_t> to_client;
+    uint32_t corrupt_rate = 0;
+    uint32_t drop_rate    = 0;
+    uint64_t num_faults   = 0;
+
+    int available() {
+      return to_remote.size();
+    }
+    int read() {
+      if (to_remote.empty()) return -1;
+      uint8_t next_byte = to_remote.front();
+      to_remote.pop_front();
+      return next_byte;
+    }
+    size_t write(uint8_t next_byte) {
+      carry(to_client, next_byte);
+      return 1;
+    }
+    void carry(std::deque<uint8_t> & direction, uint8_t next_byte) {
+      if (drop_rate > 0 && pseudo_random() % drop_rate == 0) {
+        num_faults++;
+        return;
+      }
+      if (corrupt_rate > 0 && pseudo_random() % corrupt_rate == 0) {
+        next_byte = next_byte ^ (1 << (pseudo_random() % 8));
+        num_faults++;
+      }
+      direction.push_back(next_byte);
+    }
+};
+
+static bool check(bool condition, const char * what) {
+  if (!condition) printf("FAILED: %s\n", what);
+  return condition;
+}
+
+// random requests, each applied directly to model as well, num_operations times
+static bool run_operations(SIPO8_remote_client & client, SIPO8 & remote_SIPOs, SIPO8 & model,
+                           uint32_t num_operations) {
+  for (uint32_t operation = 0; operation < num_operations; operation++) {
+    switch (pseudo_random() % 6) {
+      case 0: {
+          uint8_t bytes[test_SIPOs];
+          uint16_t first_byte = pseudo_random() % test_SIPOs;
+          uint16_t num_bytes  = 1 + pseudo_random() % (test_SIPOs - first_byte);
+          for (uint16_t next = 0; next < num_bytes; next++) {
+            bytes[next] = pseudo_random();
+            model.set_array_SIPO(first_byte + next, bytes[next]);
+          }
+          if (!check(client.write_bytes(first_byte, bytes, num_bytes), "write_bytes")) return false;
+          break;
+        }
+      case 1: {
+          uint16_t to_bank   = pseudo_random() % model.num_banks;
+          uint16_t from_bank = pseudo_random() % (to_bank + 1);
+          bool     status    = pseudo_random() & 1;
+          model.set_banks(from_bank, to_bank, status);
+          if (!check(client.fill_banks(from_bank, to_bank, status), "fill_banks")) return false;
+          break;
+        }
+      case 2: {
+          uint16_t to_bank   = pseudo_random() % model.num_banks;
+          uint16_t from_bank = pseudo_random() % (to_bank + 1);
+          model.invert_banks(from_bank, to_bank);
+          if (!check(client.invert_banks(from_bank, to_bank), "invert_banks")) return false;
+          break;
+        }
+      case 3: {
+          SIPO8::batch_command commands[30];
+          uint8_t num_commands = 1 + pseudo_random() % 30;
+          for (uint8_t command = 0; command < num_commands; command++) {
+            commands[command].command_op    = pseudo_random() % 5;
+            commands[command].command_bank  = pseudo_random() % (model.num_banks + 1);
+            commands[command].command_index = pseudo_random() % 140;
+            commands[command].command_value = pseudo_random();
+          }
+          int expected = model.submit_batch(commands, num_commands);
+          if (!check(client.submit_batch(commands, num_commands) == expected, "submit_batch")) return false;
+          break;
+        }
+      case 4: {
+          bool order = pseudo_random() & 1;
+          uint8_t xfer_what = pseudo_random() & 1 ? remote_xfer_dirty : remote_xfer_array;
+          if (xfer_what == remote_xfer_dirty) model.xfer_dirty(order); else model.xfer_array(order);
+          if (!check(client.xfer(order, xfer_what), "xfer")) return false;
+          break;
+        }
+      case 5: {
+          uint8_t bytes[test_SIPOs];
+          uint8_t source = pseudo_random() & 1 ? remote_pin_statuses : remote_committed_statuses;
+          if (!check(client.read_bytes(source, 0, test_SIPOs, bytes), "read_bytes")) return false;
+          const uint8_t * expected = source == remote_pin_statuses ? model.pin_status_bytes
+                                                                   : model.committed_status_bytes;
+          if (!check(memcmp(bytes, expected, test_SIPOs) == 0, "read_bytes matches the model")) {
+            return false;
+          }
+          break;
+        }
+    }
+  }
+  return check(client.flush(), "flush") &&
+         check(memcmp(remote_SIPOs.pin_status_bytes, model.pin_status_bytes, test_SIPOs) == 0,
+               "pin statuses match the model") &&
+         check(memcmp(remote_SIPOs.committed_status_bytes, model.committed_status_bytes,
+                      test_SIPOs) == 0, "committed statuses match the model");
+}
+
+static void create_banks(SIPO8 & SIPOs) {
+  SIPOs.create_bank(2, 3, 4, 8);
+  SIPOs.create_bank(2, 3, 5, 16);
+  SIPOs.create_bank(2, 3, 6, 32);
+  SIPOs.create_bank(2, 3, 7, 8);
+  for (uint16_t bank = 4; bank < test_banks; bank++) SIPOs.create_bank(2, 3, 8, 1);
+}
+
+int main(int argc, char ** argv) {
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--operations") == 0 && arg + 1 < argc) {
+      operations = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc) {
+      seed = strtoul(argv[++arg], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--operations N] [--seed N]\n", argv[0]);
+      return 1;
+    }
+  }
+  SIPO8_sim::reset();
+  SIPO8 remote_SIPOs(test_SIPOs, 0);
+  SIPO8 model(test_SIPOs, 0);
+  create_banks(remote_SIPOs);
+  create_banks(model);
+  loopback_link link;
+  SIPO8_remote remote(remote_SIPOs, link);
+  remote.begin(test_buffer_size);
+  uint64_t remote_bytes = 0;
+  std::chrono::steady_clock::duration remote_time(0);
+  SIPO8_remote_client client(
+    [&](const uint8_t * bytes, size_t num_bytes) {
+      for (size_t next = 0; next < num_bytes; next++) link.carry(link.to_remote, bytes[next]);
+    },
+    [&](uint8_t * bytes, size_t max_bytes) {
+      // the remote answers at once
+      remote_bytes = remote_bytes + link.to_remote.size();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      remote.update();
+      remote_time += std::chrono::steady_clock::now() - start;
+      size_t num_bytes = 0;
+      while (num_bytes < max_bytes && !link.to_client.empty()) {
+        bytes[num_bytes++] = link.to_client.front();
+        link.to_client.pop_front();
+      }
+      return num_bytes;
+    });
+  client.set_timeout_ms(5);
+
+  bool passed = check(client.connect(), "connect") &&
+                check(client.info().num_SIPOs == test_SIPOs &&
+                      client.info().num_banks == test_banks &&
+                      client.info().offset_size == remote_offset_size &&
+                      client.info().buffer_size == test_buffer_size, "remote info");
+  if (passed) {
+    passed = run_operations(client, remote_SIPOs, model, operations);
+    printf("clean link:  %u operations, %s\n", operations, passed ? "passed" : "FAILED");
+  }
+  if (passed) {
+    link.corrupt_rate = 500;
+    link.drop_rate    = 1000;
+    client.set_retries(20);
+    uint32_t crc_errors = remote.num_crc_errors;
+    passed = run_operations(client, remote_SIPOs, model, operations);
+    printf("faulty link: %u operations, %s - %lu bytes corrupted or dropped, %u remote CRC "
+           "errors, %u requests resent\n", operations, passed ? "passed" : "FAILED",
+           (unsigned long) link.num_faults, remote.num_crc_errors - crc_errors, client.num_resent());
+    link.corrupt_rate = 0;
+    link.drop_rate    = 0;
+  }
+  if (passed) {
+    // full array writes, each followed by a transfer of the changed banks
+    uint8_t bytes[test_SIPOs];
+    uint32_t num_writes = 2000;
+    uint64_t bytes_sent = client.num_bytes_sent();
+    remote_bytes = 0;
+    remote_time  = std::chrono::steady_clock::duration(0);
+    for (uint32_t write = 0; write < num_writes && passed; write++) {
+      for (uint16_t next = 0; next < test_SIPOs; next++) bytes[next] = pseudo_random();
+      passed = client.write_bytes(0, bytes, test_SIPOs) && client.xfer(MSBFIRST, remote_xfer_dirty);
+    }
+    passed = check(passed && client.flush(), "full array writes");
+    bytes_sent = client.num_bytes_sent() - bytes_sent;
+    double efficiency = (double) num_writes * test_SIPOs / bytes_sent;
+    printf("full array writes of %u status bytes: %.1f%% of the bytes sent are status bytes\n",
+           test_SIPOs, efficiency * 100);
+    static const uint32_t bauds[] = {1000000, 2000000};
+    for (uint8_t baud = 0; baud < 2; baud++) {
+      double line_bytes = bauds[baud] / 10.0;
+      printf("  at %u baud: %.0f status bytes/s, %.0f full array writes/s\n", bauds[baud],
+             line_bytes * efficiency, line_bytes * efficiency / test_SIPOs);
+    }
+    printf("  SIPO8_remote host time: %.1f ns per byte received\n",
+           (double)std::chrono::duration_cast<std::chrono::nanoseconds>(remote_time).count() /
+           remote_bytes);
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*
+   SIPO8 host simulation backend, see SIPO8_sim.h
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#include <SIPO8_sim.h>
+
+uint8_t  SIPO8_sim::_levels[SIPO8_sim_max_pins];
+uint8_t  SIPO8_sim::_modes[SIPO8_sim_max_pins];
+uint8_t  SIPO8_sim::_inputs[SIPO8_sim_max_pins];
+uint64_t SIPO8_sim::_now_ns       = 0;
+uint32_t SIPO8_sim::_gpio_cost_ns = 0;
+uint32_t SIPO8_sim::_port_cost_ns = 0;
+bool     SIPO8_sim::_record_edges = false;
+uint64_t SIPO8_sim::_num_writes   = 0;
+uint64_t SIPO8_sim::_num_reads    = 0;
+uint64_t SIPO8_sim::_num_edges    = 0;
+uint64_t SIPO8_sim::_num_port_writes = 0;
+uint64_t SIPO8_sim::_num_port_reads  = 0;
+std::vector<SIPO8_sim::edge_record> SIPO8_sim::_edges;
+std::vector<SIPO8_sim::chain_model> SIPO8_sim::_chains;
+SIPO8_custom_port_reg SIPO8_sim::_port_regs[2 * SIPO8_host_num_ports];
+
+HostSerial Serial;
+
+void SIPO8_sim::reset() {
+  memset(_levels, LOW, sizeof(_levels));
+  memset(_modes, INPUT, sizeof(_modes));
+  memset(_inputs, LOW, sizeof(_inputs));
+  _now_ns = 0;
+  _chains.clear();
+  clear_counts();
+}
+
+void SIPO8_sim::set_gpio_cost_ns(uint32_t cost_ns) {
+  _gpio_cost_ns = cost_ns;
+}
+
+uint32_t SIPO8_sim::gpio_cost_ns() {
+  return _gpio_cost_ns;
+}
+
+void SIPO8_sim::set_port_cost_ns(uint32_t cost_ns) {
+  _port_cost_ns = cost_ns;
+}
+
+uint32_t SIPO8_sim::port_cost_ns() {
+  return _port_cost_ns;
+}
+
+void SIPO8_sim::record_edges(bool record) {
+  _record_edges = record;
+}
+
+uint64_t SIPO8_sim::now_ns() {
+  return _now_ns;
+}
+
+void SIPO8_sim::advance_ns(uint64_t ns) {
+  _now_ns = _now_ns + ns;
+}
+
+uint8_t SIPO8_sim::pin_level(uint8_t pin) {
+  return _levels[pin];
+}
+
+uint8_t SIPO8_sim::pin_mode(uint8_t pin) {
+  return _modes[pin];
+}
+
+void SIPO8_sim::set_input(uint8_t pin, uint8_t level) {
+  _inputs[pin] = level;
+}
+
+uint8_t SIPO8_sim::add_chain(uint8_t data_pin, uint8_t clock_pin, uint8_t loopback_pin,
+                             uint16_t num_bits) {
+  chain_model chain;
+  chain.data_pin     = data_pin;
+  chain.clock_pin    = clock_pin;
+  chain.loopback_pin = loopback_pin;
+  chain.stages.assign(num_bits, LOW);
+  chain.fault        = fault_none;
+  chain.fault_stage  = 0;
+  chain.fault_value  = 0;
+  chain.clocks       = 0;
+  _chains.push_back(chain);
+  _inputs[loopback_pin] = LOW;
+  return (uint8_t)(_chains.size() - 1);
+}
+
+void SIPO8_sim::set_chain_fault(uint8_t chain, chain_fault fault, uint16_t stage,
+                                uint32_t level_or_clocks) {
+  _chains[chain].fault       = fault;
+  _chains[chain].fault_stage = stage;
+  _chains[chain].fault_value = level_or_clocks;
+}
+
+uint64_t SIPO8_sim::chain_clocks(uint8_t chain) {
+  return _chains[chain].clocks;
+}
+
+uint8_t SIPO8_sim::chain_stage(uint8_t chain, uint16_t stage) {
+  return _chains[chain].stages[stage];
+}
+
+// sets the given pin's level, counting and recording an edge and clocking chains
+// if it changes
+void SIPO8_sim::set_level(uint8_t pin, uint8_t level) {
+  if (_levels[pin] == level) return;
+  _levels[pin] = level;
+  _num_edges++;
+  if (_record_edges) {
+    edge_record edge = {_now_ns, pin, level};
+    _edges.push_back(edge);
+  }
+  if (level == HIGH && !_chains.empty()) clock_chains(pin);
+}
+
+// the level a read of the given pin returns - its own if an output
+uint8_t SIPO8_sim::read_pin(uint8_t pin) {
+  if (_modes[pin] == OUTPUT) return _levels[pin];
+  return _inputs[pin];
+}
+
+// shifts every chain clocked by the given pin, on its rising edge
+void SIPO8_sim::clock_chains(uint8_t clock_pin) {
+  for (size_t index = 0; index < _chains.size(); index++) {
+    chain_model & chain = _chains[index];
+    if (chain.clock_pin != clock_pin) continue;
+    std::vector<uint8_t> & stages = chain.stages;
+    for (size_t stage = stages.size() - 1; stage > 0; stage--) {
+      stages[stage] = stages[stage - 1];
+    }
+    stages[0] = _levels[chain.data_pin];
+    chain.clocks++;
+    if (chain.fault == fault_stuck) {
+      stages[chain.fault_stage] = (uint8_t)chain.fault_value;
+    } else if (chain.fault == fault_glitch && chain.fault_value > 0 && --chain.fault_value == 0) {
+      stages[chain.fault_stage] = !stages[chain.fault_stage];
+    }
+    _inputs[chain.loopback_pin] = stages.back();
+  }
+}
+
+uint64_t SIPO8_sim::num_writes() {
+  return _num_writes;
+}
+
+uint64_t SIPO8_sim::num_reads() {
+  return _num_reads;
+}
+
+uint64_t SIPO8_sim::num_edges() {
+  return _num_edges;
+}
+
+uint64_t SIPO8_sim::num_port_writes() {
+  return _num_port_writes;
+}
+
+uint64_t SIPO8_sim::num_port_reads() {
+  return _num_port_reads;
+}
+
+const std::vector<SIPO8_sim::edge_record> & SIPO8_sim::edges() {
+  return _edges;
+}
+
+void SIPO8_sim::clear_counts() {
+  _num_writes = 0;
+  _num_reads  = 0;
+  _num_edges  = 0;
+  _num_port_writes = 0;
+  _num_port_reads  = 0;
+  _edges.clear();
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// SIPO8 library pin and clock functions (SIPO8_CUSTOM_IO)
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_pin_mode(uint8_t pin, uint8_t mode) {
+  SIPO8_sim::_modes[pin] = mode;
+}
+
+void SIPO8_digital_write(uint8_t pin, uint8_t level) {
+  SIPO8_sim::_now_ns = SIPO8_sim::_now_ns + SIPO8_sim::_gpio_cost_ns;
+  SIPO8_sim::_num_writes++;
+  SIPO8_sim::set_level(pin, level ? HIGH : LOW);
+}
+
+int SIPO8_digital_read(uint8_t pin) {
+  SIPO8_sim::_now_ns = SIPO8_sim::_now_ns + SIPO8_sim::_gpio_cost_ns;
+  SIPO8_sim::_num_reads++;
+  return SIPO8_sim::read_pin(pin);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Port registers (SIPO8_FAST_IO), see Arduino.h. A register is known by its place
+// in _port_regs - each port's output register, then each port's input register.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t digitalPinToPort(uint8_t pin) {
+  return pin / 8;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) {
+  return (uint8_t)(1 << (pin % 8));
+}
+
+SIPO8_custom_port_reg * portOutputRegister(uint8_t port) {
+  if (port >= SIPO8_host_num_ports) return NULL;
+  return &SIPO8_sim::_port_regs[port];
+}
+
+SIPO8_custom_port_reg * portInputRegister(uint8_t port) {
+  if (port >= SIPO8_host_num_ports) return NULL;
+  return &SIPO8_sim::_port_regs[SIPO8_host_num_ports + port];
+}
+
+SIPO8_custom_port_reg::operator uint8_t() const {
+  ptrdiff_t reg   = this - SIPO8_sim::_port_regs;
+  bool      input = reg >= SIPO8_host_num_ports;
+  uint8_t   first_pin = (uint8_t)(reg % SIPO8_host_num_ports * 8);
+  SIPO8_sim::_now_ns = SIPO8_sim::_now_ns + SIPO8_sim::_port_cost_ns;
+  SIPO8_sim::_num_port_reads++;
+  uint8_t bits = 0;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    uint8_t pin = first_pin + bit;
+    if (input ? SIPO8_sim::read_pin(pin) : SIPO8_sim::_levels[pin]) bits = bits | 1 << bit;
+  }
+  return bits;
+}
+
+// only output registers set levels, input register writes are counted but ignored
+SIPO8_custom_port_reg & SIPO8_custom_port_reg::operator=(uint8_t bits) {
+  SIPO8_sim::_now_ns = SIPO8_sim::_now_ns + SIPO8_sim::_port_cost_ns;
+  SIPO8_sim::_num_port_writes++;
+  ptrdiff_t reg = this - SIPO8_sim::_port_regs;
+  if (reg >= SIPO8_host_num_ports) return *this;
+  uint8_t first_pin = (uint8_t)(reg * 8);
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    SIPO8_sim::set_level(first_pin + bit, bits >> bit & 1);
+  }
+  return *this;
+}
+
+uint32_t SIPO8_millis() {
+  return (uint32_t)(SIPO8_sim::now_ns() / 1000000);
+}
+
+uint32_t SIPO8_micros() {
+  return (uint32_t)(SIPO8_sim::now_ns() / 1000);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Arduino core stand ins, for sketch code run on the host
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void pinMode(uint8_t pin, uint8_t mode) {
+  SIPO8_pin_mode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  SIPO8_digital_write(pin, level);
+}
+
+int digitalRead(uint8_t pin) {
+  return SIPO8_digital_read(pin);
+}
+
+uint32_t millis() {
+  return SIPO8_millis();
+}
+
+uint32_t micros() {
+  return SIPO8_micros();
+}
+
+void delay(uint32_t ms) {
+  SIPO8_sim::advance_ns((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  SIPO8_sim::advance_ns((uint64_t)us * 1000);
+}
@@ -0,0 +1,119 @@
+/*
+   SIPO8 host simulation backend
+
+   Implements the SIPO8 library's pin and clock functions (SIPO8_CUSTOM_IO) and
+   the Arduino core stand ins (Arduino.h in this directory) on a desktop machine.
+
+   Time is virtual: every pin write or read advances a virtual clock by a
+   configurable GPIO cost, so transfer times may be estimated for a given
+   microcontroller without the hardware. Every pin write is counted, and every
+   edge (change of pin level) may be recorded with its virtual time stamp.
+
+   Port registers (see Arduino.h) are emulated for SIPO8_FAST_IO builds, so the
+   library's direct register transfers may be run and compared with digitalWrite
+   ones. Register reads and writes are counted apart from pin reads and writes,
+   and cost their own virtual time, but set pin levels and record edges alike.
+
+   SIPO chains wired for loopback may be modelled too (see add_chain), with faults
+   injected to exercise the library's chain verification (see verify_bank).
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_sim_h
+#define SIPO8_sim_h
+
+#include <Arduino.h>
+#include <vector>
+
+#define SIPO8_sim_max_pins  256
+
+class SIPO8_sim
+{
+  public:
+    struct edge_record {
+      uint64_t time_ns;   // virtual time of the edge
+      uint8_t  pin;
+      uint8_t  level;     // level after the edge, HIGH or LOW
+    };
+
+    static void     reset();                     // all pins LOW, counts/edges cleared, time 0
+    static void     set_gpio_cost_ns(uint32_t);  // virtual time per pin write/read, default 0
+    static uint32_t gpio_cost_ns();
+    static void     set_port_cost_ns(uint32_t);  // virtual time per register write/read, default 0
+    static uint32_t port_cost_ns();
+    static void     record_edges(bool);          // keep edge records, default false
+
+    static uint64_t now_ns();                    // virtual time
+    static void     advance_ns(uint64_t);        // move virtual time on, eg a simulated tick
+
+    static uint8_t  pin_level(uint8_t);
+    static uint8_t  pin_mode(uint8_t);
+    static void     set_input(uint8_t, uint8_t); // level returned by reads of an input pin
+
+    // 74HC595 chain model - a shift register of num_bits stages, clocked on each rising
+    // edge of clock_pin from data_pin, whose last stage (QH' of the last SIPO) drives
+    // the input loopback_pin. Returns the chain's number, for set_chain_fault.
+    enum chain_fault {
+      fault_none,
+      fault_stuck,   // the input of a stage is stuck at a level, eg a broken link
+      fault_glitch   // the bit entering a stage is inverted, once, so many clocks on
+    };
+    static uint8_t  add_chain(uint8_t data_pin, uint8_t clock_pin, uint8_t loopback_pin,
+                              uint16_t num_bits);
+    static void     set_chain_fault(uint8_t chain, chain_fault fault, uint16_t stage,
+                                    uint32_t level_or_clocks); // stuck level, or clocks to the glitch
+    static uint64_t chain_clocks(uint8_t chain);
+    static uint8_t  chain_stage(uint8_t chain, uint16_t stage); // level held, 0 nearest data_pin
+
+    static uint64_t num_writes();                // pin writes, whether or not the level changed
+    static uint64_t num_reads();
+    static uint64_t num_edges();                 // pin levels changed, by pin or register writes
+    static uint64_t num_port_writes();           // port register writes (SIPO8_FAST_IO)
+    static uint64_t num_port_reads();
+    static const std::vector<edge_record> & edges();
+    static void     clear_counts();              // zero counts and discard edge records
+
+  private:
+    struct chain_model {
+      uint8_t  data_pin;
+      uint8_t  clock_pin;
+      uint8_t  loopback_pin;
+      std::vector<uint8_t> stages;  // stage 0 nearest data_pin
+      chain_fault fault;
+      uint16_t fault_stage;
+      uint32_t fault_value;
+      uint64_t clocks;
+    };
+
+    static uint8_t  _levels[SIPO8_sim_max_pins];
+    static uint8_t  _modes[SIPO8_sim_max_pins];
+    static uint8_t  _inputs[SIPO8_sim_max_pins];
+    static uint64_t _now_ns;
+    static uint32_t _gpio_cost_ns;
+    static uint32_t _port_cost_ns;
+    static bool     _record_edges;
+    static uint64_t _num_writes;
+    static uint64_t _num_reads;
+    static uint64_t _num_edges;
+    static uint64_t _num_port_writes;
+    static uint64_t _num_port_reads;
+    static std::vector<edge_record> _edges;
+    static std::vector<chain_model> _chains;
+    static SIPO8_custom_port_reg _port_regs[2 * SIPO8_host_num_ports]; // outputs, then inputs
+
+    static void    set_level(uint8_t, uint8_t);
+    static void    clock_chains(uint8_t);
+    static uint8_t read_pin(uint8_t);
+
+    friend void SIPO8_digital_write(uint8_t, uint8_t);
+    friend int  SIPO8_digital_read(uint8_t);
+    friend void SIPO8_pin_mode(uint8_t, uint8_t);
+    friend class SIPO8_custom_port_reg;
+    friend SIPO8_custom_port_reg * portOutputRegister(uint8_t);
+    friend SIPO8_custom_port_reg * portInputRegister(uint8_t);
+};
+
+#endif
@@ -5,8 +5,8 @@
 
    Serial/Parallel IC (SIPO) library supporting banking of multiple SIPOs
    of same/different bit sizes.
-   Supports maximum of up to 255 8bit SIPOs (2040 individual output pins)
-   and up to 255 indivual timers.
+   Supports maximum of up to 255 8bit SIPOs (2040 individual output pins),
+   or more with SIPO8_INDEX_BITS, and up to 255 indivual timers.
 
    This example and code is in the public domain and
    may be used without restriction and without warranty.
@@ -17,38 +17,119 @@
 #include <Arduino.h>
 #include <ez_SIPO8_lib.h>
 
+// Port register read-modify-writes must not be interleaved with an ISR writing
+// to the same port, nor reads of the stats counters with an ISR updating them, so
+// are bracketed by these. They restore, rather than unconditionally re-enable, the
+// interrupt state so are safe to use within an ISR - except on processors other
+// than AVR and ARM, where there is no portable way to save the state.
+#if defined(__AVR__)
+#define SIPO8_atomic_begin() uint8_t SIPO8_saved_SREG = SREG; noInterrupts()
+#define SIPO8_atomic_end()   SREG = SIPO8_saved_SREG
+#elif defined(__arm__)
+#define SIPO8_atomic_begin() uint32_t SIPO8_saved_PRIMASK = __get_PRIMASK(); __disable_irq()
+#define SIPO8_atomic_end()   __set_PRIMASK(SIPO8_saved_PRIMASK)
+#else
+#define SIPO8_atomic_begin() noInterrupts()
+#define SIPO8_atomic_end()   interrupts()
+#endif
+
+// Gives the failure code a set_/invert_/read_ function returns, counting it in the
+// given stats counter if SIPO8_STATS.
+#if SIPO8_STATS
+#define SIPO8_failed(counter, failure) (_stats.counter++, failure)
+#else
+#define SIPO8_failed(counter, failure) (failure)
+#endif
+
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // This function will be called when the class is initiated.
 // The parameter is the maximum number of SIPOs that will be configured
 // in the sketch.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-SIPO8::SIPO8(uint8_t max_SIPO_ICs, uint8_t Max_timers ) {
+SIPO8::SIPO8(SIPO8_index max_SIPO_ICs, uint8_t Max_timers ) {
   // Setup the SIPO_banks control data struture sized for the maximum number of
   // SIPO banks that could be defined
   SIPO_banks = (SIPO_control *) malloc(sizeof(SIPO_control) * max_SIPO_ICs);
   if (SIPO_banks == NULL) {
     SIPO_lib_exit(0);
   }
-  // Determine how may pin_status_bytes of 'pins_per_SIPO' bit length are
-  // needed to map the number of bank SIPOs defined
-  _max_pins = max_SIPO_ICs * pins_per_SIPO;
-  max_pins  = _max_pins;
-  _num_pin_status_bytes = max_SIPO_ICs;
-  num_pin_status_bytes  = _num_pin_status_bytes;
-  pin_status_bytes =  (uint8_t *) malloc(sizeof(pin_status_bytes) * _num_pin_status_bytes); // 1 byte per 8-bit SIPO
+  // 1 pin status byte per 8-bit SIPO
+  pin_status_bytes = (uint8_t *) malloc(sizeof(uint8_t) * max_SIPO_ICs);
   if (pin_status_bytes == NULL) {
     SIPO_lib_exit(1);
   }
-  // clear down pin_status_bytes to LOW (0)
-  for (uint8_t pin_status_byte = 0; pin_status_byte < _num_pin_status_bytes; pin_status_byte++) {
-    pin_status_bytes[pin_status_byte] = 0;
+  // snapshot of the pin status bytes as last transferred to the hardware SIPOs
+  committed_status_bytes = (uint8_t *) malloc(sizeof(uint8_t) * max_SIPO_ICs);
+  if (committed_status_bytes == NULL) {
+    SIPO_lib_exit(4);
+  }
+  // front buffer for begin_frame/end_frame, holds the last complete frame
+  // whilst a new frame is built in pin_status_bytes (the back buffer)
+  _frame_bytes = (uint8_t *) malloc(sizeof(uint8_t) * max_SIPO_ICs);
+  if (_frame_bytes == NULL) {
+    SIPO_lib_exit(5);
+  }
+  // one dirty bit per pin status byte
+  _dirty_bytes = (uint8_t *) malloc(sizeof(uint8_t) * (((SIPO8_pin)max_SIPO_ICs + 7) / 8));
+  if (_dirty_bytes == NULL) {
+    SIPO_lib_exit(3);
   }
   // create timer struct(ure) of required size
+  timers = NULL;
+  _timer_heap = NULL;
   if (Max_timers > 0){
     timers = (timer_control *) malloc(sizeof(timer_control) * Max_timers);
     if (timers == NULL) {
       SIPO_lib_exit(2);
    }
+    // scheduled timer heap, one entry per timer
+    _timer_heap = (uint8_t *) malloc(sizeof(uint8_t) * Max_timers);
+    if (_timer_heap == NULL) {
+      SIPO_lib_exit(6);
+    }
+  }
+  initialise(max_SIPO_ICs, max_SIPO_ICs, Max_timers);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Constructor used by SIPO8Static - as above, but all working storage is provided
+// by the caller, sized at compile time, so no heap is used.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8::SIPO8(SIPO8_index max_SIPO_ICs, SIPO8_index max_banks, uint8_t Max_timers,
+             const storage_control & storage) {
+  SIPO_banks             = storage.banks;
+  pin_status_bytes       = storage.status_bytes;
+  committed_status_bytes = storage.committed_bytes;
+  _frame_bytes           = storage.frame_bytes;
+  _dirty_bytes           = storage.dirty_bytes;
+  timers                 = Max_timers > 0 ? storage.timers : NULL;
+  _timer_heap            = Max_timers > 0 ? storage.timer_heap : NULL;
+  _refresh_buffers[0]    = storage.refresh_buffers[0];
+  _refresh_buffers[1]    = storage.refresh_buffers[1];
+  _bank_map              = storage.bank_map;
+  initialise(max_SIPO_ICs, max_banks, Max_timers);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Common constructor initialisation, once working storage is in place.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::initialise(SIPO8_index max_SIPO_ICs, SIPO8_index max_banks, uint8_t Max_timers) {
+  // Determine how may pin_status_bytes of 'pins_per_SIPO' bit length are
+  // needed to map the number of bank SIPOs defined
+  _max_pins = (SIPO8_pin)max_SIPO_ICs * pins_per_SIPO;
+  max_pins  = _max_pins;
+  _num_pin_status_bytes = max_SIPO_ICs;
+  num_pin_status_bytes  = _num_pin_status_bytes;
+  // clear down pin_status_bytes to LOW (0), and their last transferred copy
+  for (SIPO8_index pin_status_byte = 0; pin_status_byte < _num_pin_status_bytes; pin_status_byte++) {
+    pin_status_bytes[pin_status_byte] = 0;
+    committed_status_bytes[pin_status_byte] = 0;
+  }
+  // dirty bits are set when a byte is changed and cleared when it is transferred.
+  // All start dirty as the hardware SIPOs are unknown
+  _num_dirty_bytes = ((SIPO8_pin)max_SIPO_ICs + 7) / 8;
+  for (SIPO8_index dirty_byte = 0; dirty_byte < _num_dirty_bytes; dirty_byte++) {
+    _dirty_bytes[dirty_byte] = 0b11111111;
   }
   _max_timers = Max_timers;
   max_timers  = Max_timers;
@@ -56,11 +137,14 @@ SIPO8::SIPO8(uint8_t max_SIPO_ICs, uint8_t Max_timers ) {
   for (uint8_t timer = 0; timer < max_timers; timer++) {
     timers[timer].timer_status = not_active;
     timers[timer].start_time = 0; // elapsed time
+    timers[timer].timer_action = timer_polled;
   }
+  _num_scheduled = 0;
   _num_active_pins = 0; // no pins yet declared
   num_active_pins  = 0;
   _max_SIPOs = max_SIPO_ICs;
   max_SIPOs  = _max_SIPOs;
+  _max_banks = max_banks;
   _bank_SIPO_count = 0;
   bank_SIPO_count  = 0;
   _next_bank = 0;
@@ -82,6 +166,18 @@ void SIPO8::SIPO_lib_exit(uint8_t reason) {
     case 2:
       Serial.println(F("Exit:out of memory for setup-timers"));
       break;
+    case 3:
+      Serial.println(F("Exit:out of memory for setup-dirty bits"));
+      break;
+    case 4:
+      Serial.println(F("Exit:out of memory for setup-committed bytes"));
+      break;
+    case 5:
+      Serial.println(F("Exit:out of memory for setup-frame bytes"));
+      break;
+    case 6:
+      Serial.println(F("Exit:out of memory for setup-timer heap"));
+      break;
     default:
       Serial.println(F("Exit:unspecified"));
       break;
@@ -92,29 +188,94 @@ void SIPO8::SIPO_lib_exit(uint8_t reason) {
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // The function will try to create a bank of SIPOs if possible.  The create process
-// will fail if the more SIPOs for a bank are requested than remain unallocated.
+// will fail if the more SIPOs for a bank are requested than remain unallocated,
+// or if the maximum number of banks have already been created.
+// Banks that share both their clock and latch pins, but each have their own data
+// pin, form a bank group. The banks of a group are always transferred together,
+// their data pins driven in the same clock cycles, see xfer_banks.
+// bit_order, if LSBFIRST or MSBFIRST, fixes the order the bank's bits are shifted
+// out in whatever the msb_or_lsb of a transfer; by default, order_by_xfer, it is
+// that of each transfer. wiring, if given, is for boards whose SIPO outputs are
+// not wired in pin order - wiring[i] is the bit (0-7) of each byte shifted out to
+// the bank that carries pin i of the SIPO (MSBFIRST, bit k drives output k). It
+// must list each bit once and must remain in scope (eg be global). It is turned
+// into a 256 byte table, from the heap, so that transfers move a byte's bits with
+// a single look up - banks given the same wiring share the one table.
+// The create process also fails if bit_order or wiring is not valid, or if there
+// is insufficient memory for the wiring table.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::create_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t latch_pin,
+                                SIPO8_index num_SIPOs, uint8_t bit_order, const uint8_t * wiring) {
+  return add_bank(data_pin, clock_pin, latch_pin, num_SIPOs, shift_bank, bit_order, wiring);
+}
+
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int SIPO8::create_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t latch_pin,
-                       uint8_t num_SIPOs) {
-  if (_bank_SIPO_count + num_SIPOs <= _max_SIPOs  && num_SIPOs > 0) {
+// Creates a bank of the given type, see create_bank and create_spi_bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::add_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t latch_pin,
+                             SIPO8_index num_SIPOs, uint8_t bank_type,
+                             uint8_t bit_order, const uint8_t * wiring) {
+  if (bit_order != LSBFIRST && bit_order != MSBFIRST && bit_order != order_by_xfer) {
+    return create_bank_failure;
+  }
+  if (wiring != NULL) {
+    uint8_t outputs = 0;  // outputs listed so far, each must be listed once
+    for (uint8_t pin = 0; pin < pins_per_SIPO; pin++) {
+      if (wiring[pin] >= pins_per_SIPO || bitRead(outputs, wiring[pin])) return create_bank_failure;
+      bitSet(outputs, wiring[pin]);
+    }
+  }
+  if (num_SIPOs <= _max_SIPOs - _bank_SIPO_count && num_SIPOs > 0 && _next_bank < _max_banks) {
     // still enough free SIPOs available to assign to a new bank
-    pinMode(data_pin,  OUTPUT);
-    digitalWrite(data_pin, LOW);
-    pinMode(clock_pin, OUTPUT);
-    digitalWrite(clock_pin, LOW);
-    pinMode(latch_pin, OUTPUT);
-    digitalWrite(latch_pin, LOW);
+    const uint8_t * wiring_table = NULL;
+    if (wiring != NULL) {
+      wiring_table = build_wiring_table(wiring);
+      if (wiring_table == NULL) return create_bank_failure;
+    }
+    SIPO8_pin_mode(data_pin,  OUTPUT);
+    SIPO8_digital_write(data_pin, LOW);
+    SIPO8_pin_mode(clock_pin, OUTPUT);
+    SIPO8_digital_write(clock_pin, LOW);
+    SIPO8_pin_mode(latch_pin, OUTPUT);
+    SIPO8_digital_write(latch_pin, LOW);
     SIPO_banks[_next_bank].bank_data_pin  = data_pin;
     SIPO_banks[_next_bank].bank_clock_pin = clock_pin;
     SIPO_banks[_next_bank].bank_latch_pin = latch_pin;
     SIPO_banks[_next_bank].bank_num_SIPOs = num_SIPOs;
+    SIPO_banks[_next_bank].bank_type      = bank_type;
+    SIPO_banks[_next_bank].bank_SPI_clock = 0;
+    SIPO_banks[_next_bank].bank_bit_order = bit_order;
+    SIPO_banks[_next_bank].bank_wiring    = wiring;
+    SIPO_banks[_next_bank].bank_wiring_table = wiring_table;
+    SIPO_banks[_next_bank].bank_loopback_pin = no_loopback;
+    SIPO_banks[_next_bank].bank_committed = false;
+    SIPO_banks[_next_bank].bank_group_order = MSBFIRST;
+#if SIPO8_STATS
+    SIPO_banks[_next_bank].bank_xfers     = 0;
+#endif
+#if SIPO8_FAST_IO
+    // resolve the bank's pins to their port registers and bit masks now, so that
+    // transfers need not repeat the pin to port lookups for every bit
+    SIPO_banks[_next_bank].bank_data_port  = portOutputRegister(digitalPinToPort(data_pin));
+    SIPO_banks[_next_bank].bank_clock_port = portOutputRegister(digitalPinToPort(clock_pin));
+    SIPO_banks[_next_bank].bank_latch_port = portOutputRegister(digitalPinToPort(latch_pin));
+    SIPO_banks[_next_bank].bank_data_mask  = digitalPinToBitMask(data_pin);
+    SIPO_banks[_next_bank].bank_clock_mask = digitalPinToBitMask(clock_pin);
+    SIPO_banks[_next_bank].bank_latch_mask = digitalPinToBitMask(latch_pin);
+    SIPO_banks[_next_bank].bank_fast_io    = SIPO_banks[_next_bank].bank_data_port  != NULL &&
+                                             SIPO_banks[_next_bank].bank_clock_port != NULL &&
+                                             SIPO_banks[_next_bank].bank_latch_port != NULL;
+#endif
     SIPO_banks[_next_bank].bank_low_pin   = _num_active_pins;
-    uint16_t num_pins_this_bank = num_SIPOs * pins_per_SIPO;
+    SIPO_banks[_next_bank].bank_first_byte = _num_active_pins / pins_per_SIPO;
+    SIPO8_pin num_pins_this_bank = (SIPO8_pin)num_SIPOs * pins_per_SIPO;
     SIPO_banks[_next_bank].bank_high_pin  = _num_active_pins + num_pins_this_bank - 1;// inclusive pin numbers
     _num_active_pins = _num_active_pins + num_pins_this_bank;
     num_active_pins  = _num_active_pins;
     _bank_SIPO_count = _bank_SIPO_count + num_SIPOs;
     bank_SIPO_count  = _bank_SIPO_count;
+    join_bank_group(_next_bank);
+    if (_bank_map != NULL) map_bank(_next_bank);
     _next_bank++;             // next bank struct(ure) entry
     num_banks = _next_bank;   // user accessible number of banks defined
     return _next_bank - 1;    // return the bank number of this bank in the SIPOs struct(ure)
@@ -122,6 +283,81 @@ int SIPO8::create_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t latch_pin,
   return create_bank_failure; // cannot provide number of SIPOs asked for, for this bank request
 }
 
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the 256 byte table of the given wiring (see create_bank) - entry b being
+// byte b with its bits moved as wiring lists - that of an earlier bank with the
+// same wiring if there is one, otherwise a new table from the heap. Returns NULL
+// if there is insufficient memory.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+const uint8_t * SIPO8::build_wiring_table(const uint8_t * wiring) {
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    if (SIPO_banks[bank].bank_wiring == wiring) return SIPO_banks[bank].bank_wiring_table;
+  }
+  uint8_t * table = (uint8_t *) malloc(sizeof(uint8_t) * 256);
+  if (table == NULL) return NULL;
+  // each bit's entries are those of the lower bits with the bit's output added
+  table[0] = 0;
+  for (uint8_t pin = 0; pin < pins_per_SIPO; pin++) {
+    uint8_t num_entries = 1 << pin;
+    for (uint8_t entry = 0; entry < num_entries; entry++) {
+      table[num_entries + entry] = (uint8_t)(table[entry] | 1 << wiring[pin]);
+    }
+  }
+  return table;
+}
+
+#if SIPO8_SPI
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The function will try to create a bank of SIPOs whose data and clock lines are
+// wired to the microcontroller's hardware SPI MOSI and SCK pins. Transfers to the
+// bank are then made by the SPI peripheral at clock_hz, rather than bit by bit.
+// Several SPI banks may be created, each must have its own latch pin.
+// bit_order and wiring are as for create_bank. The create process fails for the
+// same reasons as create_bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::create_spi_bank(uint8_t latch_pin, SIPO8_index num_SIPOs, uint32_t clock_hz,
+                                    uint8_t bit_order, const uint8_t * wiring) {
+  SIPO8_result bank = add_bank(MOSI, SCK, latch_pin, num_SIPOs, SPI_bank, bit_order, wiring);
+  if (bank != create_bank_failure) {
+    SIPO_banks[bank].bank_SPI_clock = clock_hz;
+    SPI.begin();
+  }
+  return bank;
+}
+#endif
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Adds the given (newly created) bank to the group of any earlier shift bank with
+// the same clock and latch pins but a different data pin, otherwise the bank starts
+// a group of its own. Members are linked in bank order from the group's first bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::join_bank_group(SIPO8_index bank) {
+  SIPO_banks[bank].bank_group         = bank;
+  SIPO_banks[bank].bank_next_in_group = bank;
+  SIPO_banks[bank].bank_group_SIPOs   = SIPO_banks[bank].bank_num_SIPOs;
+  if (SIPO_banks[bank].bank_type != shift_bank) return;
+  for (SIPO8_index group = 0; group < bank; group++) {
+    if (SIPO_banks[group].bank_group == group &&
+        SIPO_banks[group].bank_type == shift_bank &&
+        SIPO_banks[group].bank_clock_pin == SIPO_banks[bank].bank_clock_pin &&
+        SIPO_banks[group].bank_latch_pin == SIPO_banks[bank].bank_latch_pin) {
+      // a group with shared clock and latch - check the data pin is not also shared
+      SIPO8_index last = group;
+      while (true) {
+        if (SIPO_banks[last].bank_data_pin == SIPO_banks[bank].bank_data_pin) return;
+        if (SIPO_banks[last].bank_next_in_group == last) break;
+        last = SIPO_banks[last].bank_next_in_group;
+      }
+      SIPO_banks[last].bank_next_in_group = bank;
+      SIPO_banks[bank].bank_group = group;
+      if (SIPO_banks[bank].bank_num_SIPOs > SIPO_banks[group].bank_group_SIPOs) {
+        SIPO_banks[group].bank_group_SIPOs = SIPO_banks[bank].bank_num_SIPOs;
+      }
+      return;
+    }
+  }
+}
+
 //
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Function will set the entire array of pins to the given status value.  Note that
@@ -129,10 +365,7 @@ int SIPO8::create_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t latch_pin,
 // The parameter pin_status should be HIGH or LOW
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 void SIPO8::set_all_array_pins(bool pin_status) {
-  uint8_t mask = pin_status * 255; // either 0 (all pins set low), or 255 (all pins set high)
-  for (uint8_t pin_status_byte = 0; pin_status_byte < _num_pin_status_bytes; pin_status_byte++) {
-    pin_status_bytes[pin_status_byte] = mask;
-  }
+  fill_status_bytes(0, _num_pin_status_bytes, pin_status);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -140,9 +373,7 @@ void SIPO8::set_all_array_pins(bool pin_status) {
 // this function operates on an entire array basis rather than bank by bank.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 void SIPO8::invert_all_array_pins() {
-  for (uint8_t pin_status_byte = 0; pin_status_byte < _num_pin_status_bytes; pin_status_byte++) {
-    pin_status_bytes[pin_status_byte] = ~pin_status_bytes[pin_status_byte];
-  }
+  invert_status_bytes(0, _num_pin_status_bytes);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -150,15 +381,18 @@ void SIPO8::invert_all_array_pins() {
 // The success or otherwise of the process may be tested by the calling code using
 // the return function value.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int SIPO8::set_array_pin(uint16_t pin, bool pin_status) {
+SIPO8_result SIPO8::set_array_pin(SIPO8_pin pin, bool pin_status) {
   if (pin < _num_active_pins) {
     // pin is in the defined pin range
-    uint8_t pin_status_byte = pin / pins_per_SIPO;
+    SIPO8_index pin_status_byte = pin / pins_per_SIPO;
     uint8_t pin_bit = pin % pins_per_SIPO;
-    bitWrite(pin_status_bytes[pin_status_byte], pin_bit, pin_status);
+    if (bitRead(pin_status_bytes[pin_status_byte], pin_bit) != pin_status) {
+      bitWrite(pin_status_bytes[pin_status_byte], pin_bit, pin_status);
+      mark_dirty(pin_status_byte);
+    }
     return pin;
   }
-  return pin_set_failure;
+  return SIPO8_failed(num_set_failures, pin_set_failure);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -167,18 +401,19 @@ int SIPO8::set_array_pin(uint16_t pin, bool pin_status) {
 // The success or otherwise of the process may be tested by the calling code using
 // the return function value.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int SIPO8::invert_array_pin(uint16_t pin) {
+int SIPO8::invert_array_pin(SIPO8_pin pin) {
   if (pin < _num_active_pins) {
     // pin is in the defined pin range
-    uint8_t pin_status_byte = pin / pins_per_SIPO;
+    SIPO8_index pin_status_byte = pin / pins_per_SIPO;
     uint8_t pin_bit = pin % pins_per_SIPO;
     bool inverted_status = !bitRead(pin_status_bytes[pin_status_byte], pin_bit);
     bitWrite(pin_status_bytes[pin_status_byte],
              pin_bit,
              inverted_status);
+    mark_dirty(pin_status_byte);
     return inverted_status;  // high or low status
   }
-  return pin_invert_failure;
+  return SIPO8_failed(num_invert_failures, pin_invert_failure);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -187,14 +422,132 @@ int SIPO8::invert_array_pin(uint16_t pin) {
 // The success or otherwise of the process may be tested by the calling code using
 // the return function value.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int SIPO8::read_array_pin(uint16_t pin) {
+int SIPO8::read_array_pin(SIPO8_pin pin) {
   if (pin < _num_active_pins) {
     // pin is in the defined pin range
-    uint8_t pin_status_byte = pin / pins_per_SIPO;
+    SIPO8_index pin_status_byte = pin / pins_per_SIPO;
     uint8_t pin_bit = pin % pins_per_SIPO;
     return bitRead(pin_status_bytes[pin_status_byte], pin_bit);  // high or low status
   }
-  return pin_read_failure;
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function sets every pin from from_pin to to_pin inclusive (absolute pin
+// references) to the given status value. Partial bytes at either end of the range
+// are masked, whole bytes between are filled a word at a time.
+// Returns the number of pins set, or pin_set_failure if the range is invalid.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::set_array_range(SIPO8_pin from_pin, SIPO8_pin to_pin, bool pin_status) {
+  if (from_pin <= to_pin && to_pin < _num_active_pins) {
+    uint8_t  bits = pin_status * 255; // either 0 (all pins set low), or 255 (all pins set high)
+    SIPO8_pin pin  = from_pin;
+    SIPO8_pin num_pins = to_pin - from_pin + 1;
+    if (pin % pins_per_SIPO != 0) {
+      // head - leading pins up to the first byte boundary
+      uint8_t head = pins_per_SIPO - pin % pins_per_SIPO;
+      if (head > num_pins) head = num_pins;
+      write_range_bits(pin, head, bits);
+      pin = pin + head;
+      num_pins = num_pins - head;
+    }
+    if (num_pins >= pins_per_SIPO) {
+      // middle - whole status bytes
+      fill_status_bytes(pin / pins_per_SIPO, num_pins / pins_per_SIPO, pin_status);
+      pin = pin + (num_pins & ~(pins_per_SIPO - 1));
+      num_pins = num_pins % pins_per_SIPO;
+    }
+    if (num_pins > 0) {
+      // tail - trailing pins after the last byte boundary
+      write_range_bits(pin, num_pins, bits);
+    }
+    return to_pin - from_pin + 1;
+  }
+  return SIPO8_failed(num_set_failures, pin_set_failure);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function inverts every pin from from_pin to to_pin inclusive (absolute pin
+// references), in the same manner as set_array_range.
+// Returns the number of pins inverted, or pin_invert_failure if the range is invalid.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::invert_array_range(SIPO8_pin from_pin, SIPO8_pin to_pin) {
+  if (from_pin <= to_pin && to_pin < _num_active_pins) {
+    SIPO8_pin pin = from_pin;
+    SIPO8_pin num_pins = to_pin - from_pin + 1;
+    if (pin % pins_per_SIPO != 0) {
+      uint8_t head = pins_per_SIPO - pin % pins_per_SIPO;
+      if (head > num_pins) head = num_pins;
+      write_range_bits(pin, head, ~read_range_bits(pin, head));
+      pin = pin + head;
+      num_pins = num_pins - head;
+    }
+    if (num_pins >= pins_per_SIPO) {
+      invert_status_bytes(pin / pins_per_SIPO, num_pins / pins_per_SIPO);
+      pin = pin + (num_pins & ~(pins_per_SIPO - 1));
+      num_pins = num_pins % pins_per_SIPO;
+    }
+    if (num_pins > 0) {
+      write_range_bits(pin, num_pins, ~read_range_bits(pin, num_pins));
+    }
+    return to_pin - from_pin + 1;
+  }
+  return SIPO8_failed(num_invert_failures, pin_invert_failure);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function copies the status of num_pins pins starting at src_pin to the pins
+// starting at dst_pin (absolute pin references). The ranges may overlap - the
+// copy behaves as if the source pins were read in full before any were written.
+// Where source and destination share the same bit offset within a byte the whole
+// bytes are moved at once, otherwise the pins are moved up to 8 at a time.
+// Returns the number of pins copied, or pin_set_failure if either range is invalid.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::copy_array_range(SIPO8_pin src_pin, SIPO8_pin dst_pin, SIPO8_pin num_pins) {
+  if (num_pins == 0 ||
+      (uint32_t)src_pin + num_pins > _num_active_pins ||
+      (uint32_t)dst_pin + num_pins > _num_active_pins) {
+    return SIPO8_failed(num_set_failures, pin_set_failure);
+  }
+  if (src_pin == dst_pin) return num_pins; // nothing to move
+  bool forward = dst_pin < src_pin; // copy low to high, else high to low, so overlaps are safe
+  if (src_pin % pins_per_SIPO == dst_pin % pins_per_SIPO) {
+    // same bit alignment - head and tail bits masked, whole bytes between moved
+    uint8_t  head = (pins_per_SIPO - src_pin % pins_per_SIPO) % pins_per_SIPO;
+    if (head > num_pins) head = num_pins;
+    SIPO8_pin num_bytes = (num_pins - head) / pins_per_SIPO;
+    uint8_t   tail = (num_pins - head) % pins_per_SIPO;
+    SIPO8_pin src_tail_pin = src_pin + head + num_bytes * pins_per_SIPO;
+    SIPO8_pin dst_tail_pin = dst_pin + head + num_bytes * pins_per_SIPO;
+    if (forward && head > 0) write_range_bits(dst_pin, head, read_range_bits(src_pin, head));
+    if (!forward && tail > 0) write_range_bits(dst_tail_pin, tail, read_range_bits(src_tail_pin, tail));
+    if (num_bytes > 0) {
+      SIPO8_index src_byte = (src_pin + head) / pins_per_SIPO;
+      SIPO8_index dst_byte = (dst_pin + head) / pins_per_SIPO;
+      memmove(&pin_status_bytes[dst_byte], &pin_status_bytes[src_byte], num_bytes);
+      mark_dirty(dst_byte, num_bytes);
+    }
+    if (forward && tail > 0) write_range_bits(dst_tail_pin, tail, read_range_bits(src_tail_pin, tail));
+    if (!forward && head > 0) write_range_bits(dst_pin, head, read_range_bits(src_pin, head));
+  } else {
+    // differing alignment - move chunks that each fill to the next destination byte boundary
+    SIPO8_pin done = 0;
+    while (done < num_pins) {
+      SIPO8_pin remaining = num_pins - done;
+      SIPO8_pin dst = forward ? dst_pin + done : dst_pin + remaining - 1;
+      uint8_t  chunk;
+      if (forward) {
+        chunk = pins_per_SIPO - dst % pins_per_SIPO;
+      } else {
+        chunk = dst % pins_per_SIPO + 1;
+      }
+      if (chunk > remaining) chunk = remaining;
+      SIPO8_pin offset = forward ? done : remaining - chunk;
+      write_range_bits(dst_pin + offset, chunk, read_range_bits(src_pin + offset, chunk));
+      done = done + chunk;
+    }
+  }
+  return num_pins;
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -209,9 +562,9 @@ void SIPO8::set_banks(bool pin_status) {
 // Function will set every pin in each bank, from_bank - to_bank, to the
 // specified pin status.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::set_banks(uint8_t from_bank, uint8_t to_bank, bool pin_status) {
+void SIPO8::set_banks(SIPO8_index from_bank, SIPO8_index to_bank, bool pin_status) {
   if (from_bank <= to_bank && to_bank < _next_bank) {
-    for (uint8_t bank = from_bank; bank <= to_bank; bank++) {
+    for (SIPO8_index bank = from_bank; bank <= to_bank; bank++) {
       set_bank(bank, pin_status);
     }
   }
@@ -220,18 +573,9 @@ void SIPO8::set_banks(uint8_t from_bank, uint8_t to_bank, bool pin_status) {
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Function will set every pin in given bank to the specified pin status.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::set_bank(uint8_t bank, bool pin_status) {
+void SIPO8::set_bank(SIPO8_index bank, bool pin_status) {
   if (bank < _next_bank) {
-    // start with the first pin of the first SIPO in the bank
-    uint16_t first_pin = SIPO_banks[bank].bank_low_pin; // first pin in this bank
-    uint8_t mask = pin_status * 255; // either 0 (all pins set low), or 255 (all pins set high)
-    // determine the first pin status byte for the first pin in the bank
-    uint8_t pin_status_byte = first_pin / pins_per_SIPO;
-    // now deal with each SIPO declared in the bank, setting the
-    // associated pin status bytes accordingly
-    for (uint8_t SIPO = 0; SIPO < SIPO_banks[bank].bank_num_SIPOs; SIPO++) {
-      pin_status_bytes[pin_status_byte + SIPO] = mask; // reset all pin bits
-    }
+    fill_status_bytes(SIPO_banks[bank].bank_first_byte, SIPO_banks[bank].bank_num_SIPOs, pin_status);
   }
 }
 
@@ -246,9 +590,9 @@ void SIPO8::invert_banks() {
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Function will invert the existing pin status of every pin in the specified banks.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::invert_banks(uint8_t from_bank, uint8_t to_bank) {
+void SIPO8::invert_banks(SIPO8_index from_bank, SIPO8_index to_bank) {
   if (from_bank <= to_bank && to_bank < _next_bank) {
-    for (uint8_t bank = from_bank; bank <= to_bank; bank++) {
+    for (SIPO8_index bank = from_bank; bank <= to_bank; bank++) {
       invert_bank(bank);
     }
   }
@@ -257,18 +601,9 @@ void SIPO8::invert_banks(uint8_t from_bank, uint8_t to_bank) {
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Function will invert the existing pin status of every pin in the specified bank.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::invert_bank(uint8_t bank) {
+void SIPO8::invert_bank(SIPO8_index bank) {
   if (bank < _next_bank) {
-    // start with the first pin of the first SIPO in the bank
-    uint16_t first_pin = SIPO_banks[bank].bank_low_pin; // first pin in this bank
-    // determine the first pin status byte for the first pin in the bank
-    uint8_t pin_status_byte = first_pin / pins_per_SIPO;
-    // now deal with each SIPO declared in the bank, setting the
-    // associated pin status bytes accordingly
-    for (uint8_t SIPO = 0; SIPO < SIPO_banks[bank].bank_num_SIPOs; SIPO++) {
-      pin_status_bytes[pin_status_byte + SIPO] =
-        ~pin_status_bytes[pin_status_byte + SIPO]; // invert the status byte bits
-    }
+    invert_status_bytes(SIPO_banks[bank].bank_first_byte, SIPO_banks[bank].bank_num_SIPOs);
   }
 }
 
@@ -277,12 +612,12 @@ void SIPO8::invert_bank(uint8_t bank) {
 // Note that these functions operate relative to the pins defined
 // in a bank - set_bank_pin, invert_bank_pin, read_bank_pin.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::set_bank_pin(uint8_t bank, uint8_t pin, bool pin_status) {
+SIPO8_result SIPO8::set_bank_pin(SIPO8_index bank, SIPO8_pin pin, bool pin_status) {
   if (bank < _next_bank) {
     pin = pin + SIPO_banks[bank].bank_low_pin;  // absolute pin number in the array
     return set_array_pin(pin, pin_status);      // returns failure or the absolute pin muber if successful
   }
-  return pin_set_failure;
+  return SIPO8_failed(num_set_failures, pin_set_failure);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -290,12 +625,12 @@ int  SIPO8::set_bank_pin(uint8_t bank, uint8_t pin, bool pin_status) {
 // Note that these functions operate relative to the pins defined
 // in a bank - set_bank_pin, invert_bank_pin, read_bank_pin.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::invert_bank_pin(uint8_t bank, uint8_t pin) {
+int  SIPO8::invert_bank_pin(SIPO8_index bank, SIPO8_pin pin) {
   if (bank < _next_bank) {
     pin = pin + SIPO_banks[bank].bank_low_pin;  // absolute pin number in the array
     return invert_array_pin(pin);      // returns failure or the new status of the pin if successful
   }
-  return pin_invert_failure;
+  return SIPO8_failed(num_invert_failures, pin_invert_failure);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -303,12 +638,97 @@ int  SIPO8::invert_bank_pin(uint8_t bank, uint8_t pin) {
 // Note that these functions operate relative to the pins defined
 // in a bank - set_bank_pin, invert_bank_pin, read_bank_pin.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::read_bank_pin(uint8_t bank, uint8_t pin) {
+int  SIPO8::read_bank_pin(SIPO8_index bank, SIPO8_pin pin) {
   if (bank < _next_bank) {
     pin = pin + SIPO_banks[bank].bank_low_pin;  // absolute pin number in the array
     return read_array_pin(pin);     // returns failure or the pin status if successful
   }
-  return pin_read_failure;
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Batch updates, for applying many pin/SIPO updates at once, eg as received from
+// a serial or network control protocol.
+// submit_batch applies num_commands batch_commands in order, much as the
+// equivalent set_bank_pin, set_bank_SIPO and set_bank calls would, but validating
+// the bank once for each run of commands on it, and merging consecutive commands
+// on the same SIPO into a single update of its pin status byte. Unlike those calls:
+// - a pin or SIPO is checked against its own bank, so one beyond the end of the
+//   bank is skipped, where set_bank_pin would change a pin of the next bank
+// - commands on banks, pins or SIPOs that do not exist, or with an unknown op,
+//   are skipped without being counted as failures (see SIPO8_STATS)
+// xfer_batch is as submit_batch, then transfers the banks changed (xfer_dirty).
+// Both return the number of commands applied.
+// For example:
+//   SIPO8::batch_command commands[] = {{batch_set_pin, bank, 3, 0},
+//                                      {batch_write_SIPO, bank, 1, 0b10100101}};
+//   my_SIPOs.xfer_batch(commands, 2, MSBFIRST);
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint16_t SIPO8::submit_batch(const batch_command * commands, uint16_t num_commands) {
+  uint16_t    num_applied  = 0;
+  SIPO8_index bank         = SIPO8_max_index; // bank last validated, none yet
+  bool        bank_found   = false;
+  SIPO8_index first_byte   = 0;      // of the validated bank...
+  SIPO8_pin   num_pins     = 0;      // ...and its size
+  SIPO8_index pending_byte = SIPO8_max_index; // status byte with updates not yet applied, none yet
+  uint8_t     keep_mask    = 0xFF;   // the pending updates, as status byte & keep_mask ^ invert_mask
+  uint8_t     invert_mask  = 0;
+  const batch_command * end = commands + num_commands;
+  for (; commands < end; commands++) {
+    if (commands->command_bank != bank) {
+      bank       = commands->command_bank;
+      bank_found = bank < _next_bank;
+      if (bank_found) {
+        first_byte = SIPO_banks[bank].bank_first_byte;
+        num_pins   = (SIPO8_pin)SIPO_banks[bank].bank_num_SIPOs * pins_per_SIPO;
+      }
+    }
+    if (!bank_found) continue;
+    uint8_t     op    = commands->command_op;
+    SIPO8_pin   index = commands->command_index;
+    SIPO8_index status_byte;
+    uint8_t     command_keep, command_invert;
+    if (op <= batch_invert_pin) {  // batch_set_pin, batch_clear_pin or batch_invert_pin
+      if (index >= num_pins) continue;
+      uint8_t bit_mask = 1 << (index % pins_per_SIPO);
+      status_byte    = first_byte + index / pins_per_SIPO;
+      command_keep   = op == batch_invert_pin ? 0xFF : (uint8_t)~bit_mask;
+      command_invert = op == batch_clear_pin ? 0 : bit_mask;
+    } else if (op == batch_write_SIPO) {
+      if (index >= num_pins / pins_per_SIPO) continue;
+      status_byte    = first_byte + index;
+      command_keep   = 0;
+      command_invert = commands->command_value;
+    } else if (op == batch_write_bank) {
+      if (pending_byte != SIPO8_max_index) update_status_byte(pending_byte, keep_mask, invert_mask);
+      pending_byte = SIPO8_max_index;
+      for (SIPO8_index SIPO_num = 0; SIPO_num < num_pins / pins_per_SIPO; SIPO_num++) {
+        update_status_byte(first_byte + SIPO_num, 0, commands->command_value);
+      }
+      num_applied++;
+      continue;
+    } else {
+      continue;  // not a batch op
+    }
+    if (status_byte != pending_byte) {
+      if (pending_byte != SIPO8_max_index) update_status_byte(pending_byte, keep_mask, invert_mask);
+      pending_byte = status_byte;
+      keep_mask    = 0xFF;
+      invert_mask  = 0;
+    }
+    // this command after those pending
+    invert_mask = (invert_mask & command_keep) ^ command_invert;
+    keep_mask   = keep_mask & command_keep;
+    num_applied++;
+  }
+  if (pending_byte != SIPO8_max_index) update_status_byte(pending_byte, keep_mask, invert_mask);
+  return num_applied;
+}
+
+uint16_t SIPO8::xfer_batch(const batch_command * commands, uint16_t num_commands, bool msb_or_lsb) {
+  uint16_t num_applied = submit_batch(commands, num_commands);
+  xfer_dirty(msb_or_lsb);
+  return num_applied;
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -316,21 +736,24 @@ int  SIPO8::read_bank_pin(uint8_t bank, uint8_t pin) {
 // Note that this functions operate relative to the SIPOs/pins defined
 // in a bank.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::set_bank_SIPO(uint8_t bank, uint8_t SIPO_num, uint8_t SIPO_value) {
+SIPO8_result SIPO8::set_bank_SIPO(SIPO8_index bank, SIPO8_index SIPO_num, uint8_t SIPO_value) {
   if (bank < _next_bank) {
     // bank is valid
-    uint8_t SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
+    SIPO8_index SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
     if (SIPO_num < SIPOs_this_bank) {
       // specified SIPO number is valid for this bank
       // now determine the pin_staus_byte entry for the SIPO
-      uint8_t status_byte = SIPO_banks[bank].bank_low_pin / pins_per_SIPO;// first status byte for this bank
+      SIPO8_index status_byte = SIPO_banks[bank].bank_first_byte;// first status byte for this bank
       status_byte = status_byte + SIPO_num; // actual status byte to be set
-      pin_status_bytes[status_byte] = SIPO_value;// set required status byte
+      if (pin_status_bytes[status_byte] != SIPO_value) {
+        pin_status_bytes[status_byte] = SIPO_value;// set required status byte
+        mark_dirty(status_byte);
+      }
       return status_byte;
     }
-    return SIPO_not_found;
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
   }
-  return bank_not_found;
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -339,21 +762,22 @@ int  SIPO8::set_bank_SIPO(uint8_t bank, uint8_t SIPO_num, uint8_t SIPO_value) {
 // Note that this functions operate relative to the SIPOs/pins defined
 // in a bank.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::invert_bank_SIPO(uint8_t bank, uint8_t SIPO_num) {
+SIPO8_result SIPO8::invert_bank_SIPO(SIPO8_index bank, SIPO8_index SIPO_num) {
   if (bank < _next_bank) {
     // bank is valid
-    uint8_t SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
+    SIPO8_index SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
     if (SIPO_num < SIPOs_this_bank) {
       // specified SIPO number is valid for this bank
       // now determine the pin_staus_byte entry for the SIPO
-      uint8_t status_byte = SIPO_banks[bank].bank_low_pin / pins_per_SIPO;// first status byte for this bank
+      SIPO8_index status_byte = SIPO_banks[bank].bank_first_byte;// first status byte for this bank
       status_byte = status_byte + SIPO_num; // actual status byte to be inverted
       pin_status_bytes[status_byte] = ~pin_status_bytes[status_byte]; // invert current contents
+      mark_dirty(status_byte);
       return status_byte;
     }
-    return SIPO_not_found;
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
   }
-  return bank_not_found;
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -362,32 +786,113 @@ int  SIPO8::invert_bank_SIPO(uint8_t bank, uint8_t SIPO_num) {
 // Note that this functions operate relative to the SIPOs/pins defined
 // in a bank.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::read_bank_SIPO(uint8_t bank, uint8_t SIPO_num) {
+int  SIPO8::read_bank_SIPO(SIPO8_index bank, SIPO8_index SIPO_num) {
   if (bank < _next_bank) {
     // bank is valid
-    uint8_t SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
+    SIPO8_index SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
     if (SIPO_num < SIPOs_this_bank) {
       // specified SIPO number is valid for this bank
       // now determine the pin_staus_byte entry for the SIPO
-      uint8_t status_byte = SIPO_banks[bank].bank_low_pin / pins_per_SIPO;// first status byte for this bank
+      SIPO8_index status_byte = SIPO_banks[bank].bank_first_byte;// first status byte for this bank
       status_byte = status_byte + SIPO_num; // actual status byte to be read
       return pin_status_bytes[status_byte];
     }
-    return SIPO_not_found;
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
   }
-  return bank_not_found;
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Functions will set/invert/read the given SIPO (8bits) of the array, ie the pin
+// status byte for array pins SIPO_num * 8 to SIPO_num * 8 + 7, whatever its bank.
+// invert_array_SIPO inverts the pins whose bits are set in invert_mask, leaving
+// the others as they are.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::set_array_SIPO(SIPO8_index SIPO_num, uint8_t SIPO_value) {
+  if (SIPO_num < _bank_SIPO_count) {
+    if (pin_status_bytes[SIPO_num] != SIPO_value) {
+      pin_status_bytes[SIPO_num] = SIPO_value;
+      mark_dirty(SIPO_num);
+    }
+    return SIPO_num;
+  }
+  return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+}
+
+SIPO8_result SIPO8::invert_array_SIPO(SIPO8_index SIPO_num, uint8_t invert_mask) {
+  if (SIPO_num < _bank_SIPO_count) {
+    if (invert_mask != 0) {
+      pin_status_bytes[SIPO_num] = pin_status_bytes[SIPO_num] ^ invert_mask;
+      mark_dirty(SIPO_num);
+    }
+    return SIPO_num;
+  }
+  return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+}
+
+int SIPO8::read_array_SIPO(SIPO8_index SIPO_num) {
+  if (SIPO_num < _bank_SIPO_count) {
+    return pin_status_bytes[SIPO_num];
+  }
+  return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The read_committed_ functions are equivalent to read_array_pin, read_bank_pin and
+// read_bank_SIPO but return the status last transferred to the hardware SIPOs,
+// rather than the pending status which may since have been changed.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8::read_committed_array_pin(SIPO8_pin pin) {
+  if (pin < _num_active_pins) {
+    // pin is in the defined pin range
+    SIPO8_index pin_status_byte = pin / pins_per_SIPO;
+    uint8_t pin_bit = pin % pins_per_SIPO;
+    return bitRead(committed_status_bytes[pin_status_byte], pin_bit);  // high or low status
+  }
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+int SIPO8::read_committed_bank_pin(SIPO8_index bank, SIPO8_pin pin) {
+  if (bank < _next_bank) {
+    return read_committed_array_pin(pin + SIPO_banks[bank].bank_low_pin);
+  }
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+int SIPO8::read_committed_bank_SIPO(SIPO8_index bank, SIPO8_index SIPO_num) {
+  if (bank < _next_bank) {
+    // bank is valid
+    if (SIPO_num < SIPO_banks[bank].bank_num_SIPOs) {
+      SIPO8_index status_byte = SIPO_banks[bank].bank_first_byte + SIPO_num;
+      return committed_status_bytes[status_byte];
+    }
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+  }
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Given an absolute array pin number, the function determines which
 // bank it resides within and returns the bank number.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int  SIPO8::get_bank_from_pin(uint16_t pin) {
+SIPO8_result SIPO8::get_bank_from_pin(SIPO8_pin pin) {
   if (pin < _num_active_pins) {
-    for (uint8_t bank = 0; bank < _next_bank; bank++) {
-      if (SIPO_banks[bank].bank_low_pin <= pin &&
-          pin <= SIPO_banks[bank].bank_high_pin)return bank;
+    if (_bank_map != NULL) {
+      return _bank_map[pin / pins_per_SIPO];
+    }
+    // banks are allocated contiguously in pin order, so bank_low_pin is sorted -
+    // binary search for the last bank starting at or before the pin
+    SIPO8_index low_bank  = 0;
+    SIPO8_index high_bank = _next_bank - 1;
+    while (low_bank < high_bank) {
+      SIPO8_index mid_bank = low_bank + (high_bank - low_bank + 1) / 2;
+      if (SIPO_banks[mid_bank].bank_low_pin <= pin) {
+        low_bank = mid_bank;
+      } else {
+        high_bank = mid_bank - 1;
+      }
     }
+    return low_bank;
   }
   return bank_not_found;
 }
@@ -395,7 +900,7 @@ int  SIPO8::get_bank_from_pin(uint16_t pin) {
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Determines the number of pins in the given bank
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-int SIPO8::num_pins_in_bank(uint8_t bank) {
+SIPO8_result SIPO8::num_pins_in_bank(SIPO8_index bank) {
   if (bank < _next_bank) {
     // valid bank, so return number of pins in this bank
     return SIPO_banks[bank].bank_num_SIPOs * pins_per_SIPO;
@@ -403,40 +908,47 @@ int SIPO8::num_pins_in_bank(uint8_t bank) {
   return bank_not_found;
 }
 
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the first bank of the given bank's group (see create_bank) - the bank
+// itself if it shares its clock and latch pins with no other bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::get_bank_group(SIPO8_index bank) {
+  if (bank < _next_bank) {
+    return SIPO_banks[bank].bank_group;
+  }
+  return bank_not_found;
+}
+
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Selective transfer of array pin satuses based on bank transfers,
 // rather than the entire array of banks.
 // Transfers specified banks' pin statuses to the hardware SIPOs,
 // starting with from_bank and continuing to to_bank.
+// A bank in a bank group is transferred together with the rest of its group, in
+// parallel, even if the other members lie outside from_bank - to_bank.
 // The direction of transfer is determined by the msb_or_lsb parameter
 // which must be either LSBFIRST  or MSBFIRST.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::xfer_banks(uint8_t from_bank, uint8_t to_bank, bool msb_or_lsb) {
+void SIPO8::xfer_banks(SIPO8_index from_bank, SIPO8_index to_bank, bool msb_or_lsb) {
   if (from_bank <= to_bank && to_bank < _next_bank) {
+#if SIPO8_STATS
+    uint32_t start_us = SIPO8_micros();
+#endif
     // examine each bank in turn and deal with as many SIPOs as
     // are configured in each bank
-    for (uint8_t bank = from_bank; bank <= to_bank; bank++) {
-      uint16_t low_pin  = SIPO_banks[bank].bank_low_pin;   // start pin number for this bank
-      uint16_t high_pin = SIPO_banks[bank].bank_high_pin;  // end inclusive pin number for this bank
-      uint8_t latch_pin = SIPO_banks[bank].bank_latch_pin;
-      uint8_t clock_pin = SIPO_banks[bank].bank_clock_pin;
-      uint8_t data_pin  = SIPO_banks[bank].bank_data_pin;
-      uint8_t num_SIPOs_this_bank = SIPO_banks[bank].bank_num_SIPOs;
-      uint8_t SIPO_first_status_byte = SIPO_banks[bank].bank_low_pin  / pins_per_SIPO;
-      uint8_t SIPO_last_status_byte  = SIPO_banks[bank].bank_high_pin / pins_per_SIPO;
-      uint8_t SIPO_status_byte = 0;
-      digitalWrite(latch_pin, LOW);   //  tell IC data transfer to start
-      for (uint8_t SIPO = 0; SIPO < num_SIPOs_this_bank; SIPO++) {
-        if (msb_or_lsb == LSBFIRST) {
-          SIPO_status_byte = SIPO_first_status_byte + SIPO;
-        } else {
-          SIPO_status_byte = SIPO_last_status_byte - SIPO;
-        }
-        shift_out_bank(data_pin, clock_pin, pin_status_bytes[SIPO_status_byte], msb_or_lsb);
+    const uint8_t * status_bytes = xfer_source();
+    for (SIPO8_index bank = from_bank; bank <= to_bank; bank++) {
+      // a group is transferred at its first member within the range
+      SIPO8_index member = SIPO_banks[bank].bank_group;
+      while (member < from_bank) member = SIPO_banks[member].bank_next_in_group;
+      if (member == bank) {
+        xfer_group(SIPO_banks[bank].bank_group, status_bytes, msb_or_lsb);
       }
-      digitalWrite(latch_pin, HIGH);   //  tell IC data transfer is finished
     }
+#if SIPO8_STATS
+    count_xfer_time(SIPO8_micros() - start_us);
+#endif
   }
 }
 
@@ -457,7 +969,7 @@ void SIPO8::xfer_banks(bool msb_or_lsb) {
 // hardware SIPOs. The direction of transfer is determined by the msb_or_lsb
 // parameter which must be either LSBFIRST  or MSBFIRST.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::xfer_bank(uint8_t bank, bool msb_or_lsb) {
+void SIPO8::xfer_bank(SIPO8_index bank, bool msb_or_lsb) {
   if (_next_bank > 0) {
     xfer_banks(bank, bank, msb_or_lsb);
   }
@@ -473,135 +985,1858 @@ void SIPO8::xfer_array(bool msb_or_lsb) {
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-// Based on the standard Arduino shiftout function.
-// Moves out the given set of pin statuses, status_bits, to the specified SIPO.
+// Transfers only those banks with pin statuses changed since they were last
+// transferred, banks with no changes are not clocked at all. Each bank skipped
+// is counted in num_skipped_xfers.
+// The direction of transfer is determined by the msb_or_lsb parameter
+// which must be either LSBFIRST  or MSBFIRST.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::shift_out_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t status_bits, bool msb_or_lsb)
-{ // Shuffle each bit of the val parameter (0 or 1) one bit left
-  // until all bits written out.
-  for (uint8_t  i = 0; i < pins_per_SIPO; i++)  {
-    if (msb_or_lsb == LSBFIRST) {
-      digitalWrite(data_pin, !!(status_bits & (1 << i)));
+void SIPO8::xfer_dirty(bool msb_or_lsb) {
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    if (SIPO_banks[bank].bank_group != bank) continue; // transferred with its group
+    if (group_is_dirty(bank)) {
+      xfer_banks(bank, bank, msb_or_lsb);
+    } else {
+      num_skipped_xfers++;
     }
-    else
-    {
-      digitalWrite(data_pin, !!(status_bits & (1 << (7 - i))));
-    }
-    digitalWrite(clock_pin, HIGH);
-    digitalWrite(clock_pin, LOW);
   }
 }
 
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-// Function is provided to assist end user to provide debug data during development.
-// Prints all active pin status bytes, in bit form, starting with pin 0 and
-// progressing to the last active end pin defined.
+// Commits pending pin status changes to the hardware SIPOs. As xfer_dirty, but a
+// changed bank is only transferred if its pin status bytes now differ from those
+// last transferred (committed_status_bytes) - so a bank whose pins were changed
+// and then changed back is not transferred. A bank is always transferred the first
+// time, as the state of the hardware SIPOs is then unknown. Banks not transferred
+// are counted in num_skipped_xfers.
+// The direction of transfer is determined by the msb_or_lsb parameter
+// which must be either LSBFIRST  or MSBFIRST.
 // %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::print_pin_statuses() {
-  if (_next_bank > 0) {
-    Serial.println(F("\nActive pin array, pin statuses:"));
-    // there is at least 1 bank
-    uint8_t SIPO_count = 0;
-    for (uint8_t bank = 0; bank < _next_bank; bank++) {
-      Serial.print(F("Bank "));
-      if (bank < 10)Serial.print(F(" "));
-      Serial.print(bank);
-      Serial.print(F(": MS"));
-      uint8_t start_byte = SIPO_count;
-      uint8_t last_byte = start_byte + SIPO_banks[bank].bank_num_SIPOs - 1;
-      SIPO_count = SIPO_count + SIPO_banks[bank].bank_num_SIPOs;
-      for (int16_t next_byte = last_byte; next_byte >= start_byte; next_byte--) {
-        uint8_t SIPO_status = pin_status_bytes[next_byte];
-        for (int pos = 7; pos >= 0; pos--) {
-          uint8_t pin_status = bitRead(SIPO_status, pos);
-          Serial.print(pin_status);
+void SIPO8::commit_banks(bool msb_or_lsb) {
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    if (SIPO_banks[bank].bank_group != bank) continue; // transferred with its group
+    if (group_is_dirty(bank)) {
+      // the group need only be sent if any member differs from its committed bytes
+      bool matches = true;
+      SIPO8_index member = bank;
+      while (true) {
+        SIPO8_index first_byte = SIPO_banks[member].bank_first_byte;
+        if (!SIPO_banks[member].bank_committed ||
+            !status_bytes_equal(&xfer_source()[first_byte],
+                                &committed_status_bytes[first_byte],
+                                SIPO_banks[member].bank_num_SIPOs)) {
+          matches = false;
+          break;
         }
+        if (SIPO_banks[member].bank_next_in_group == member) break;
+        member = SIPO_banks[member].bank_next_in_group;
       }
-      Serial.println(F("LS"));
+      if (matches) {
+        // nothing to send, hardware already matches
+        for (member = bank; ; member = SIPO_banks[member].bank_next_in_group) {
+          clear_dirty(SIPO_banks[member].bank_first_byte, SIPO_banks[member].bank_num_SIPOs);
+          if (SIPO_banks[member].bank_next_in_group == member) break;
+        }
+        num_skipped_xfers++;
+      } else {
+        xfer_banks(bank, bank, msb_or_lsb);
+      }
+    } else {
+      num_skipped_xfers++;
     }
-  } else {
-    Serial.println(F("\nNo banks defined"));
   }
-  Serial.flush();
 }
 
-// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-// Function is provided to assist end user to display debug data during development.
-// Prints all setup data as a confirmation that the end user has correctly configured
-// all key data.
-// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::print_SIPO_data() {
-  Serial.println(F("\nSIPO global values:"));
-  Serial.print(F("pins_per_SIPO   = "));
-  Serial.println(pins_per_SIPO);
-  Serial.print(F("max_SIPOs       = "));
-  Serial.println(_max_SIPOs);
-  Serial.print(F("bank_SIPO_count = "));
-  Serial.println(_bank_SIPO_count);
-  Serial.print(F("num_active_pins = "));
-  Serial.println(_num_active_pins);
-  Serial.print(F("num_pin_status_bytes = "));
-  Serial.println(_num_pin_status_bytes);
-  Serial.print(F("next_free bank = "));
-  if (_bank_SIPO_count < _max_SIPOs) {
-    Serial.print(_next_bank);
-    Serial.println();
-  } else {
-    Serial.println(F(" all SIPOs used"));
-  }
-  Serial.print("Number timers  =  ");
-  Serial.println(_max_timers);
-  Serial.println(F("\nBank data:"));
-  for (uint8_t bank = 0; bank < _next_bank; bank++) {
-    // still SIPOs available to assign to a new bank
-    Serial.print(F("bank = "));
-    Serial.println(bank);
-    Serial.print(F("  num SIPOs =\t"));
-    Serial.println(SIPO_banks[bank].bank_num_SIPOs);
-    Serial.print(F("  latch_pin =\t"));
-    Serial.print(SIPO_banks[bank].bank_latch_pin);
-    Serial.print(F("  clock_pin =\t"));
-    Serial.print(SIPO_banks[bank].bank_clock_pin);
-    Serial.print(F("  data_pin  =\t"));
-    Serial.println(SIPO_banks[bank].bank_data_pin);
-    Serial.print(F("  low_pin   =\t"));
-    Serial.print(SIPO_banks[bank].bank_low_pin);
-    Serial.print(F("  high_pin  =\t"));
-    Serial.println(SIPO_banks[bank].bank_high_pin);
-  }
-  Serial.flush();
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Chunked transfers.
+// xfer_begin starts a transfer of the given range of banks, as xfer_banks, which is
+// then made by calls of xfer_step, each shifting out at most max_bits bits (clock
+// pulses, shared by the members of a group) before returning - so a long transfer
+// may be interleaved with other work in loop(), the time of each step bounded by
+// max_bits. A group's latch is only set once all its bits are shifted out, so its
+// SIPO outputs change together, as for xfer_banks. SPI banks are shifted a whole
+// byte at a time, at least one byte a step.
+// Each SIPO of a group is transferred from the pin statuses as they are when its
+// first bit is shifted out, which are then recorded as committed, and clean - so a
+// change made after that is left dirty, for the next transfer. Reads of committed
+// statuses whilst a group is part shifted give those being shifted out. Changes
+// made whilst a group is part shifted may be partly shown - build changes with
+// begin_frame/end_frame to avoid this. No other transfer should be made whilst a
+// chunked transfer is in progress.
+// xfer_begin returns false, and starts nothing, if a chunked transfer is already in
+// progress, background refresh or brightness modulation is running or the banks are
+// not valid. xfer_step returns true once the transfer is complete (or if none is in
+// progress), false whilst there is more to shift out.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::xfer_begin(SIPO8_index from_bank, SIPO8_index to_bank, bool msb_or_lsb) {
+  if (_xfer_active || _refresh_active || _bcm_active ||
+      from_bank > to_bank || to_bank >= _next_bank) return false;
+  _xfer_order     = msb_or_lsb;
+  _xfer_from_bank = from_bank;
+  _xfer_to_bank   = to_bank;
+  _xfer_bank      = from_bank;
+  _xfer_SIPO      = 0;
+  _xfer_bit       = 0;
+  _xfer_active    = true;
+  return true;
 }
 
-// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-// Function sets the given timer as active and records the start time.
-// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-void SIPO8::SIPO8_start_timer(uint8_t timer) {
-  if (timer < _max_timers) {
-    timers[timer].timer_status = active;
-    timers[timer].start_time = millis();
-  }
+bool SIPO8::xfer_begin(bool msb_or_lsb) {
+  return _next_bank > 0 && xfer_begin(0, _next_bank - 1, msb_or_lsb);
 }
 
-//
-// Function cancels the given timer.
-//
-void SIPO8::SIPO8_stop_timer(uint8_t timer) {
-  if (timer < _max_timers) {
-    timers[timer].timer_status = not_active;
+bool SIPO8::xfer_step(uint16_t max_bits) {
+  while (_xfer_active && max_bits > 0) {
+    SIPO8_index group = SIPO_banks[_xfer_bank].bank_group;
+    if (_xfer_SIPO == 0 && _xfer_bit == 0) {
+      // a group is transferred at its first member within the range, as xfer_banks
+      SIPO8_index member = group;
+      while (member < _xfer_from_bank) member = SIPO_banks[member].bank_next_in_group;
+      if (member != _xfer_bank) {
+        _xfer_active = ++_xfer_bank <= _xfer_to_bank;
+        continue;
+      }
+      SIPO_banks[group].bank_group_order = _xfer_order;
+      latch_bank(group, LOW);
+    }
+#if SIPO8_SPI
+    begin_SPI_xfer(group);
+#endif
+    SIPO8_index num_SIPOs = SIPO_banks[group].bank_group_SIPOs;
+    while (_xfer_SIPO < num_SIPOs && max_bits > 0) {
+      if (_xfer_bit == 0) commit_group_SIPO(group, _xfer_SIPO, xfer_source(), _xfer_order);
+      uint8_t num_bits = pins_per_SIPO - _xfer_bit;
+      if (num_bits > max_bits && SIPO_banks[group].bank_type != SPI_bank) num_bits = max_bits;
+      // shifted from the committed bytes, unchanged however pin statuses change
+      shift_out_group_SIPO(group, _xfer_SIPO, committed_status_bytes, _xfer_order, _xfer_bit, num_bits);
+      max_bits  = num_bits < max_bits ? max_bits - num_bits : 0;
+      _xfer_bit = _xfer_bit + num_bits;
+      if (_xfer_bit == pins_per_SIPO) {
+        _xfer_bit = 0;
+        _xfer_SIPO++;
+      }
+    }
+    if (_xfer_SIPO < num_SIPOs) {
+      // out of bits part way through the group, its latch stays LOW until complete
+#if SIPO8_SPI
+      end_SPI_xfer(group);
+#endif
+      break;
+    }
+    end_bank_xfer(group);
+    for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+      SIPO_banks[member].bank_committed = true;
+      if (SIPO_banks[member].bank_next_in_group == member) break;
+    }
+    _xfer_SIPO   = 0;
+    _xfer_active = ++_xfer_bank <= _xfer_to_bank;
   }
+  return !_xfer_active;
 }
 
-//
-// Function determines if the time has elapsed for the given timer, if active.
-//
-bool SIPO8::SIPO8_timer_elapsed(uint8_t timer, uint32_t elapsed_time) {
-  if (timer < _max_timers) {
-    if (timers[timer].timer_status == active) {
-      if (millis() - timers[timer].start_time >= elapsed_time) {
-        timers[timer].timer_status = not_active; // mark this timer no longer active
-        return elapsed;
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Records the bytes of the given SIPO'th byte of a group transfer, one for each
+// member bank not being padded, as committed from status_bytes and, if they are
+// pin_status_bytes, clean - for a chunked transfer, as the SIPO starts to be
+// shifted out.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::commit_group_SIPO(SIPO8_index group, SIPO8_index SIPO, const uint8_t * status_bytes,
+                              bool msb_or_lsb) {
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    SIPO8_index padding = SIPO_banks[group].bank_group_SIPOs - SIPO_banks[member].bank_num_SIPOs;
+    if (SIPO >= padding) {
+      SIPO8_index status_byte = bank_status_byte(member, SIPO - padding,
+                                                 bank_xfer_order(member, msb_or_lsb));
+      committed_status_bytes[status_byte] = status_bytes[status_byte];
+      if (status_bytes == pin_status_bytes) {
+        // changes pending in a frame being built remain dirty
+        bitClear(_dirty_bytes[status_byte / 8], status_byte & 0b00000111);
       }
     }
+    if (SIPO_banks[member].bank_next_in_group == member) break;
   }
-  return not_elapsed;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Bulk pin status kernels - set or invert num_bytes whole status bytes from
+// first_byte, marking them dirty. Inversion works a SIPO8_word at a time.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::fill_status_bytes(SIPO8_index first_byte, SIPO8_pin num_bytes, bool pin_status) {
+  memset(&pin_status_bytes[first_byte], pin_status * 255, num_bytes);
+  mark_dirty(first_byte, num_bytes);
+}
+
+void SIPO8::invert_status_bytes(SIPO8_index first_byte, SIPO8_pin num_bytes) {
+  uint8_t * bytes = &pin_status_bytes[first_byte];
+  SIPO8_pin remaining = num_bytes;
+  while (remaining >= sizeof(SIPO8_word)) {
+    SIPO8_word word;
+    memcpy(&word, bytes, sizeof(SIPO8_word)); // memcpy, as the bytes need not be word aligned
+    word = ~word;
+    memcpy(bytes, &word, sizeof(SIPO8_word));
+    bytes     = bytes + sizeof(SIPO8_word);
+    remaining = remaining - sizeof(SIPO8_word);
+  }
+  while (remaining > 0) {
+    *bytes = ~*bytes;
+    bytes++;
+    remaining--;
+  }
+  mark_dirty(first_byte, num_bytes);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Reads num_pins (1-8) consecutive pin statuses from pin, returned with the status
+// of pin as bit 0. The pins may straddle two status bytes.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t SIPO8::read_range_bits(SIPO8_pin pin, uint8_t num_pins) {
+  SIPO8_index status_byte = pin / pins_per_SIPO;
+  uint8_t  pin_bit = pin % pins_per_SIPO;
+  uint16_t bits = pin_status_bytes[status_byte];
+  if (pin_bit + num_pins > pins_per_SIPO) {
+    bits = bits | (uint16_t)pin_status_bytes[status_byte + 1] << pins_per_SIPO;
+  }
+  return (bits >> pin_bit) & (uint8_t)(0xFF >> (pins_per_SIPO - num_pins));
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Writes num_pins consecutive pin statuses from pin, taken from bits with the
+// status of pin as bit 0. The pins must lie within a single status byte.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::write_range_bits(SIPO8_pin pin, uint8_t num_pins, uint8_t bits) {
+  SIPO8_index status_byte = pin / pins_per_SIPO;
+  uint8_t mask = (uint8_t)(0xFF >> (pins_per_SIPO - num_pins)) << (pin % pins_per_SIPO);
+  uint8_t new_byte = (pin_status_bytes[status_byte] & ~mask) | ((bits << (pin % pins_per_SIPO)) & mask);
+  if (pin_status_bytes[status_byte] != new_byte) {
+    pin_status_bytes[status_byte] = new_byte;
+    mark_dirty(status_byte);
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Updates the given status byte to (status byte & keep_mask) ^ invert_mask, marking
+// it for transfer if that changes it. Any combination of bit sets, clears and
+// inverts reduces to this form.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::update_status_byte(SIPO8_index status_byte, uint8_t keep_mask, uint8_t invert_mask) {
+  uint8_t new_byte = (pin_status_bytes[status_byte] & keep_mask) ^ invert_mask;
+  if (pin_status_bytes[status_byte] != new_byte) {
+    pin_status_bytes[status_byte] = new_byte;
+    mark_dirty(status_byte);
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Compares two runs of num_bytes status bytes, returning true if they match.
+// Compares a SIPO8_word at a time where the processor is wider than 8bits.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::status_bytes_equal(const uint8_t * bytes_a, const uint8_t * bytes_b, SIPO8_pin num_bytes) {
+  while (num_bytes >= sizeof(SIPO8_word)) {
+    SIPO8_word word_a, word_b;
+    memcpy(&word_a, bytes_a, sizeof(SIPO8_word)); // memcpy, as the bytes need not be word aligned
+    memcpy(&word_b, bytes_b, sizeof(SIPO8_word));
+    if (word_a != word_b) return false;
+    bytes_a   = bytes_a + sizeof(SIPO8_word);
+    bytes_b   = bytes_b + sizeof(SIPO8_word);
+    num_bytes = num_bytes - sizeof(SIPO8_word);
+  }
+  while (num_bytes > 0) {
+    if (*bytes_a++ != *bytes_b++) return false;
+    num_bytes--;
+  }
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns true if any pin status in the given bank has changed since the bank was
+// last transferred, false otherwise (or if the bank does not exist).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::bank_is_dirty(SIPO8_index bank) {
+  if (bank < _next_bank) {
+    SIPO8_index first_byte = SIPO_banks[bank].bank_first_byte;
+    SIPO8_index last_byte  = first_byte + SIPO_banks[bank].bank_num_SIPOs - 1;
+    SIPO8_index status_byte = first_byte;
+    while (status_byte <= last_byte) {
+      uint8_t dirty_bits = _dirty_bytes[status_byte / 8];
+      if ((status_byte & 0b00000111) == 0 && last_byte - status_byte >= 7) {
+        // whole dirty byte lies within the bank, test 8 status bytes at once
+        if (dirty_bits != 0) return true;
+        status_byte = status_byte + 8;
+      } else {
+        if (bitRead(dirty_bits, status_byte & 0b00000111)) return true;
+        status_byte++;
+      }
+    }
+  }
+  return false;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns true if any bank of the group starting with the given bank is dirty.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::group_is_dirty(SIPO8_index group) {
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    if (bank_is_dirty(member)) return true;
+    if (SIPO_banks[member].bank_next_in_group == member) return false;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Dirty bit maintenance - mark/clear num_bytes pin status bytes from first_byte.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::mark_dirty(SIPO8_index status_byte) {
+  bitSet(_dirty_bytes[status_byte / 8], status_byte & 0b00000111);
+}
+
+void SIPO8::mark_dirty(SIPO8_index first_byte, SIPO8_pin num_bytes) {
+  SIPO8_pin status_byte = first_byte;
+  SIPO8_pin end_byte    = first_byte + num_bytes;
+  while (status_byte < end_byte) {
+    if ((status_byte & 0b00000111) == 0 && end_byte - status_byte >= 8) {
+      _dirty_bytes[status_byte / 8] = 0xFF; // 8 status bytes at once
+      status_byte = status_byte + 8;
+    } else {
+      bitSet(_dirty_bytes[status_byte / 8], status_byte & 0b00000111);
+      status_byte++;
+    }
+  }
+}
+
+void SIPO8::clear_dirty(SIPO8_index first_byte, SIPO8_pin num_bytes) {
+  SIPO8_pin status_byte = first_byte;
+  SIPO8_pin end_byte    = first_byte + num_bytes;
+  while (status_byte < end_byte) {
+    if ((status_byte & 0b00000111) == 0 && end_byte - status_byte >= 8) {
+      _dirty_bytes[status_byte / 8] = 0;
+      status_byte = status_byte + 8;
+    } else {
+      bitClear(_dirty_bytes[status_byte / 8], status_byte & 0b00000111);
+      status_byte++;
+    }
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Transfers the group starting with the given bank from status_bytes, then records
+// each member as committed and, unless a frame is being built, clean.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::xfer_group(SIPO8_index group, const uint8_t * status_bytes, bool msb_or_lsb) {
+  xfer_group_bytes(group, status_bytes, msb_or_lsb);
+  record_group(group, status_bytes);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Records each member of the group starting with the given bank as committed from
+// status_bytes and, unless a frame is being built, clean.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::record_group(SIPO8_index group, const uint8_t * status_bytes) {
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    record_committed(member, status_bytes);
+    if (status_bytes == pin_status_bytes) {
+      // changes pending in a frame being built remain dirty
+      clear_dirty(SIPO_banks[member].bank_first_byte, SIPO_banks[member].bank_num_SIPOs);
+    }
+    if (SIPO_banks[member].bank_next_in_group == member) break;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Transfers the SIPOs of the group starting with the given bank from the given set
+// of status bytes, which is indexed as pin_status_bytes (ie each bank's bytes start
+// at bank_first_byte). A bank not in a group is a group of one.
+// The direction of transfer is determined by the msb_or_lsb parameter
+// which must be either LSBFIRST  or MSBFIRST.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::xfer_group_bytes(SIPO8_index group, const uint8_t * status_bytes, bool msb_or_lsb) {
+  SIPO8_index num_SIPOs_this_group = SIPO_banks[group].bank_group_SIPOs;
+  begin_bank_xfer(group, msb_or_lsb);
+  for (SIPO8_index SIPO = 0; SIPO < num_SIPOs_this_group; SIPO++) {
+    shift_out_group_SIPO(group, SIPO, status_bytes, msb_or_lsb, 0, pins_per_SIPO);
+  }
+  end_bank_xfer(group);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Moves out the given SIPO'th byte of a group transfer - one byte to every member
+// bank, each on its own data pin, in the same 8 clock cycles - or num_bits of its
+// bits from first_bit (0 being the first bit shifted out), for a chunked transfer.
+// Members shorter than the longest are sent LOW padding bytes first, which pass
+// through and out of the end of their SIPO chains by the time the latch is set.
+// Each member's byte is built once, in its own bit order and wiring (see
+// bank_out_bits), into its bank_out_byte before the bits are shifted out, most
+// significant bit first, so the bit loop only masks and shifts.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_out_group_SIPO(SIPO8_index group, SIPO8_index SIPO, const uint8_t * status_bytes,
+                                 bool msb_or_lsb, uint8_t first_bit, uint8_t num_bits) {
+  if (SIPO_banks[group].bank_next_in_group == group) {
+    // a group of one, the bank alone
+    shift_out_SIPO(group, (uint8_t)(bank_out_bits(group, SIPO, status_bytes, msb_or_lsb) << first_bit),
+                   num_bits);
+    return;
+  }
+#if SIPO8_FAST_IO
+  bool fast_io = _fast_io;
+#endif
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    SIPO8_index padding = SIPO_banks[group].bank_group_SIPOs - SIPO_banks[member].bank_num_SIPOs;
+    SIPO_banks[member].bank_out_byte = 0;
+    if (SIPO >= padding) {
+      SIPO_banks[member].bank_out_byte =
+        (uint8_t)(bank_out_bits(member, SIPO - padding, status_bytes, msb_or_lsb) << first_bit);
+    }
+#if SIPO8_FAST_IO
+    fast_io = fast_io && SIPO_banks[member].bank_fast_io;
+#endif
+    if (SIPO_banks[member].bank_next_in_group == member) break;
+  }
+#if SIPO8_FAST_IO
+  if (fast_io) {
+    shift_out_group_fast(group, num_bits);
+    return;
+  }
+#endif
+  uint8_t bit_mask = 0b10000000;
+  for (uint8_t i = 0; i < num_bits; i++) {
+    for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+      SIPO8_digital_write(SIPO_banks[member].bank_data_pin, !!(SIPO_banks[member].bank_out_byte & bit_mask));
+      if (SIPO_banks[member].bank_next_in_group == member) break;
+    }
+    SIPO8_digital_write(SIPO_banks[group].bank_clock_pin, HIGH);
+    SIPO8_digital_write(SIPO_banks[group].bank_clock_pin, LOW);
+    bit_mask >>= 1;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Records the given bank's bytes from status_bytes as those last transferred.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::record_committed(SIPO8_index bank, const uint8_t * status_bytes) {
+  SIPO8_index first_byte = SIPO_banks[bank].bank_first_byte;
+  memcpy(&committed_status_bytes[first_byte], &status_bytes[first_byte],
+         SIPO_banks[bank].bank_num_SIPOs);
+  SIPO_banks[bank].bank_committed = true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the status byte to be shifted out as the given SIPO'th of a bank
+// transfer. LSBFIRST transfers start with the bank's first status byte, MSBFIRST
+// transfers with its last.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_index SIPO8::bank_status_byte(SIPO8_index bank, SIPO8_index SIPO, bool msb_or_lsb) {
+  if (msb_or_lsb == LSBFIRST) {
+    return SIPO_banks[bank].bank_first_byte + SIPO;
+  }
+  return SIPO_banks[bank].bank_first_byte + SIPO_banks[bank].bank_num_SIPOs - 1 - SIPO;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the bit order of a transfer, msb_or_lsb, to the given bank - the bank's
+// own if it was created with one, see create_bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::bank_xfer_order(SIPO8_index bank, bool msb_or_lsb) {
+  uint8_t bit_order = SIPO_banks[bank].bank_bit_order;
+  return bit_order == order_by_xfer ? msb_or_lsb : bit_order != LSBFIRST;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the given byte with its bits in reverse order - nibbles, then bit pairs,
+// then bits swapped, with no loop or table.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+static uint8_t reverse_bits(uint8_t bits) {
+  bits = (uint8_t)((bits >> 4) | (bits << 4));
+  bits = (uint8_t)(((bits & 0b11001100) >> 2) | ((bits & 0b00110011) << 2));
+  return (uint8_t)(((bits & 0b10101010) >> 1) | ((bits & 0b01010101) << 1));
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the given SIPO'th byte of a transfer to the given bank from status_bytes,
+// built for shifting out most significant bit first - its bits moved as the bank's
+// wiring lists, if it has any, by its wiring table, then reversed for an LSBFIRST
+// transfer. So the shift loops need not test the bit order for every bit.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t SIPO8::bank_out_bits(SIPO8_index bank, SIPO8_index SIPO, const uint8_t * status_bytes,
+                             bool msb_or_lsb) {
+  bool    bit_order   = bank_xfer_order(bank, msb_or_lsb);
+  uint8_t status_bits = status_bytes[bank_status_byte(bank, SIPO, bit_order)];
+  if (SIPO_banks[bank].bank_wiring_table != NULL) {
+    status_bits = SIPO_banks[bank].bank_wiring_table[status_bits];
+  }
+  return bit_order == LSBFIRST ? reverse_bits(status_bits) : status_bits;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Start/finish a transfer to the given bank - drive the latch pin LOW/HIGH and,
+// for SPI banks, begin/end the SPI transaction. The transfer's bit order is kept
+// for restore_group.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::begin_bank_xfer(SIPO8_index bank, bool msb_or_lsb) {
+  SIPO_banks[bank].bank_group_order = msb_or_lsb;
+  latch_bank(bank, LOW);   //  tell IC data transfer to start
+#if SIPO8_SPI
+  begin_SPI_xfer(bank);
+#endif
+}
+
+void SIPO8::end_bank_xfer(SIPO8_index bank) {
+#if SIPO8_SPI
+  end_SPI_xfer(bank);
+#endif
+  latch_bank(bank, HIGH);  //  tell IC data transfer is finished
+#if SIPO8_STATS
+  count_group_xfer(bank);
+#endif
+}
+
+#if SIPO8_SPI
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Begin/end the SPI transaction for a transfer to the given bank, if an SPI_bank.
+// A chunked transfer (see xfer_step) holds the transaction only during each step,
+// leaving the SPI bus free to other devices between steps.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::begin_SPI_xfer(SIPO8_index bank) {
+  if (SIPO_banks[bank].bank_type == SPI_bank) {
+    // bytes are built for MSBFIRST whatever the transfer's order, see bank_out_bits
+    SPI.beginTransaction(SPISettings(SIPO_banks[bank].bank_SPI_clock, MSBFIRST, SPI_MODE0));
+  }
+}
+
+void SIPO8::end_SPI_xfer(SIPO8_index bank) {
+  if (SIPO_banks[bank].bank_type == SPI_bank) {
+    SPI.endTransaction();
+  }
+}
+#endif
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sets the given bank's latch pin to the given level, LOW to start a transfer and
+// HIGH to complete it. A transfer starting replaces the test bits of any spot check
+// of the bank's group, which restarts, see spot_check.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::latch_bank(SIPO8_index bank, bool level) {
+  if (level == LOW && SIPO_banks[_spot_bank].bank_group == bank) _spot_bits = 0;
+#if SIPO8_FAST_IO
+  if (_fast_io && SIPO_banks[bank].bank_fast_io) {
+    SIPO8_port_reg * latch_port = SIPO_banks[bank].bank_latch_port;
+    SIPO8_port_mask  latch_mask = SIPO_banks[bank].bank_latch_mask;
+    SIPO8_atomic_begin();
+    if (level == HIGH) {
+      *latch_port |= latch_mask;
+    } else {
+      *latch_port &= ~latch_mask;
+    }
+    SIPO8_atomic_end();
+    return;
+  }
+#endif
+  SIPO8_digital_write(SIPO_banks[bank].bank_latch_pin, level);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Moves out one SIPO's worth of pin statuses, status_bits, to the given bank by
+// whichever means the bank supports - hardware SPI, direct port register writes
+// or digitalWrite - most significant bit first, see bank_out_bits. Only the first
+// num_bits are shifted out, except by SPI banks which always shift the whole byte.
+// For SPI banks the caller must have begun the SPI transaction.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_out_SIPO(SIPO8_index bank, uint8_t status_bits, uint8_t num_bits) {
+#if SIPO8_SPI
+  if (SIPO_banks[bank].bank_type == SPI_bank) {
+    SPI.transfer(status_bits);
+    return;
+  }
+#endif
+#if SIPO8_FAST_IO
+  if (_fast_io && SIPO_banks[bank].bank_fast_io) {
+    shift_out_bank_fast(bank, status_bits, num_bits);
+    return;
+  }
+#endif
+  shift_out_bank(SIPO_banks[bank].bank_data_pin,
+                 SIPO_banks[bank].bank_clock_pin,
+                 status_bits, num_bits);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Based on the standard Arduino shiftout function.
+// Moves out the given set of pin statuses, status_bits, to the specified SIPO,
+// most significant bit first, num_bits of them.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_out_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t status_bits, uint8_t num_bits)
+{ // Shuffle each bit of the val parameter (0 or 1) one bit left
+  // until all bits written out.
+  for (uint8_t  i = 0; i < num_bits; i++)  {
+    SIPO8_digital_write(data_pin, !!(status_bits & 0b10000000));
+    status_bits <<= 1;
+    SIPO8_digital_write(clock_pin, HIGH);
+    SIPO8_digital_write(clock_pin, LOW);
+  }
+}
+
+#if SIPO8_FAST_IO
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Direct port register equivalent of shift_out_bank. Uses the bank's data and
+// clock port registers/bit masks resolved by create_bank. Interrupts are held off
+// for the duration of the byte (a few microseconds at most) as the read-modify-write
+// port updates are not otherwise atomic.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_out_bank_fast(SIPO8_index bank, uint8_t status_bits, uint8_t num_bits)
+{
+  SIPO8_port_reg * data_port  = SIPO_banks[bank].bank_data_port;
+  SIPO8_port_reg * clock_port = SIPO_banks[bank].bank_clock_port;
+  SIPO8_port_mask  data_mask  = SIPO_banks[bank].bank_data_mask;
+  SIPO8_port_mask  clock_mask = SIPO_banks[bank].bank_clock_mask;
+  // shift the byte left one place each clock and test its top bit, rather than
+  // shift by a variable amount each time, AVRs have no barrel shifter
+  SIPO8_atomic_begin();
+  for (uint8_t i = 0; i < num_bits; i++) {
+    if (status_bits & 0b10000000) {
+      *data_port |= data_mask;
+    } else {
+      *data_port &= ~data_mask;
+    }
+    *clock_port |= clock_mask;
+    *clock_port &= ~clock_mask;
+    status_bits <<= 1;
+  }
+  SIPO8_atomic_end();
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Direct port register equivalent of the group shift in shift_out_group_SIPO, of
+// the first num_bits of each member's bank_out_byte. Where every member's data pin
+// is on the same port, all the data bits for a clock cycle are set by a single
+// port write, otherwise each member's port is updated.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_out_group_fast(SIPO8_index group, uint8_t num_bits)
+{
+  SIPO8_port_reg * data_port  = SIPO_banks[group].bank_data_port;
+  SIPO8_port_reg * clock_port = SIPO_banks[group].bank_clock_port;
+  SIPO8_port_mask  clock_mask = SIPO_banks[group].bank_clock_mask;
+  SIPO8_port_mask  data_mask  = 0;  // all members' data bits, if on the one port
+  bool shared_port = true;
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    shared_port = shared_port && SIPO_banks[member].bank_data_port == data_port;
+    data_mask   = data_mask | SIPO_banks[member].bank_data_mask;
+    if (SIPO_banks[member].bank_next_in_group == member) break;
+  }
+  uint8_t bit_mask = 0b10000000;
+  SIPO8_atomic_begin();
+  for (uint8_t i = 0; i < num_bits; i++) {
+    SIPO8_port_mask data_bits = 0;
+    for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+      bool level = SIPO_banks[member].bank_out_byte & bit_mask;
+      if (shared_port) {
+        if (level) data_bits = data_bits | SIPO_banks[member].bank_data_mask;
+      } else if (level) {
+        *SIPO_banks[member].bank_data_port |= SIPO_banks[member].bank_data_mask;
+      } else {
+        *SIPO_banks[member].bank_data_port &= ~SIPO_banks[member].bank_data_mask;
+      }
+      if (SIPO_banks[member].bank_next_in_group == member) break;
+    }
+    if (shared_port) {
+      *data_port = (*data_port & ~data_mask) | data_bits;
+    }
+    *clock_port |= clock_mask;
+    *clock_port &= ~clock_mask;
+    bit_mask >>= 1;
+  }
+  SIPO8_atomic_end();
+}
+#endif
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Frame building.
+// Between begin_frame and end_frame, pin status changes are made to the back buffer
+// (pin_status_bytes) whilst every transfer - xfer_..., commit_banks and background
+// refresh - continues to see the last complete frame, held in the front buffer.
+// end_frame flips transfers back to pin_status_bytes with a single byte store, so a
+// transfer made from an ISR sees either the whole of the old frame or the whole of
+// the new one, never a part built frame.
+// begin_frame copies pin_status_bytes to the front buffer, O(number of SIPOs),
+// rather than end_frame swapping the buffers' pointers. pin_status_bytes is public,
+// read and written directly by sketches and add-ons (eg SIPO8_remote), so must stay
+// put, and changes made between frames are made to it, so a swapped out buffer
+// would need re-syncing before the next frame anyway. The copy is a single memcpy,
+// some 64us for 255 SIPOs on a 16MHz AVR - less than a digitalWrite transfer of
+// one SIPO - made once a frame and outside any ISR.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::begin_frame() {
+  if (!_in_frame) {
+    memcpy(_frame_bytes, pin_status_bytes, _num_pin_status_bytes);
+    _in_frame = true;
+  }
+}
+
+void SIPO8::end_frame() {
+  _in_frame = false;  // the flip - transfers now see the completed frame
+  if (_refresh_active) {
+    refresh_frame();
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the status bytes transfers are to be made from - the front buffer if a
+// frame is being built, otherwise pin_status_bytes.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+const uint8_t * SIPO8::xfer_source() {
+  return _in_frame ? _frame_bytes : pin_status_bytes;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Background refresh.
+// Once started, each call of refresh_tick transfers the next SIPO (refresh_by_SIPO)
+// or the next bank (refresh_by_bank) of the current refresh frame, cycling through
+// all banks continuously. refresh_tick is intended to be called at a fixed rate from
+// a timer interrupt service routine, so bounding the time spent in the ISR and
+// leaving loop() free of transfers.
+// The refresh frame is a copy of pin_status_bytes made by refresh_frame. The copy
+// is double buffered - refresh_frame fills the back buffer and refresh_tick swaps
+// it to the front only at the end of a complete pass through the banks, so a
+// partially updated frame is never shown.
+// Notes:
+// 1. do not mix synchronous transfers (xfer_...) with background refresh
+// 2. SPI banks used with background refresh should not share the SPI bus with
+//    devices accessed outside the ISR, unless SPI.usingInterrupt is used
+//
+// start_refresh returns false if there is insufficient memory for the refresh
+// buffers (allocated on first use).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::start_refresh(bool msb_or_lsb, uint8_t refresh_unit) {
+  _refresh_active = false;
+  for (uint8_t buffer = 0; buffer < 2; buffer++) {
+    if (_refresh_buffers[buffer] == NULL) {
+      _refresh_buffers[buffer] = (uint8_t *) malloc(sizeof(uint8_t) * _num_pin_status_bytes);
+      if (_refresh_buffers[buffer] == NULL) return false;
+    }
+    memcpy(_refresh_buffers[buffer], xfer_source(), _num_pin_status_bytes);
+  }
+  _refresh_front   = 0;
+  _refresh_pending = false;
+  _refresh_order   = msb_or_lsb;
+  _refresh_unit    = refresh_unit;
+  _refresh_bank    = 0;
+  _refresh_SIPO    = 0;
+  _refresh_active  = true;
+  return true;
+}
+
+void SIPO8::stop_refresh() {
+  _refresh_active = false;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Posts the current pin_status_bytes as the next background refresh frame. It is
+// shown from the start of the next complete refresh pass.
+// If a frame is being built (see begin_frame) the last complete frame is posted.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::refresh_frame() {
+  if (_refresh_active) {
+    _refresh_pending = false; // stops refresh_tick swapping buffers while back is filled
+    memcpy(_refresh_buffers[!_refresh_front], xfer_source(), _num_pin_status_bytes);
+    _refresh_pending = true;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Transfers the next SIPO or bank of the refresh frame, see start_refresh.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::refresh_tick() {
+  if (!_refresh_active || _next_bank == 0) return;
+  const uint8_t * frame = _refresh_buffers[_refresh_front];
+  SIPO8_index bank = _refresh_bank;  // always the first bank of a group
+  if (_refresh_unit == refresh_by_bank) {
+    xfer_group_bytes(bank, frame, _refresh_order);
+  } else {
+    if (_refresh_SIPO == 0) begin_bank_xfer(bank, _refresh_order);
+    shift_out_group_SIPO(bank, _refresh_SIPO, frame, _refresh_order, 0, pins_per_SIPO);
+    _refresh_SIPO++;
+    if (_refresh_SIPO < SIPO_banks[bank].bank_group_SIPOs) return; // bank not yet complete
+    end_bank_xfer(bank);
+    _refresh_SIPO = 0;
+  }
+  for (SIPO8_index member = bank; ; member = SIPO_banks[member].bank_next_in_group) {
+    record_committed(member, frame);
+    if (SIPO_banks[member].bank_next_in_group == member) break;
+  }
+  // move on to the next group
+  do {
+    _refresh_bank++;
+  } while (_refresh_bank < _next_bank && SIPO_banks[_refresh_bank].bank_group != _refresh_bank);
+  if (_refresh_bank >= _next_bank) {
+    // end of a complete pass, the frame boundary - show the next frame if posted
+    _refresh_bank = 0;
+    if (_refresh_pending) {
+      _refresh_front   = !_refresh_front;
+      _refresh_pending = false;
+    }
+    num_refresh_frames++;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Brightness by binary code modulation (BCM).
+// Each pin is given a brightness level of num_bits bits (1-8), 0 being off and
+// 2^num_bits - 1 fully on. The levels are split into num_bits bit planes - plane k
+// holding bit k of every pin's level, laid out as pin_status_bytes - and each
+// call of bcm_tick, at a fixed rate from a timer interrupt service routine,
+// continues the display of the current plane. Plane k is transferred to the
+// SIPOs and then shown for 2^k ticks, so a pin is on for level ticks out of every
+// 2^num_bits - 1, with at most num_bits transfers per cycle.
+// For example 6 bits at a tick rate of 8kHz gives 64 levels at 127 cycles a
+// second, flicker free. Each transfer must complete within a tick.
+// The planes are double buffered as for background refresh - bcm_frame builds the
+// back planes from the levels set, and bcm_tick swaps them to the front only at
+// the end of a complete cycle.
+// Notes:
+// 1. do not mix synchronous transfers (xfer_...) or background refresh with BCM
+// 2. pin statuses (set_array_pin etc) are not shown whilst BCM is active
+//
+// start_bcm returns false if num_bits is out of range or if there is insufficient
+// memory for the levels and planes (allocated on first use).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::start_bcm(uint8_t num_bits, bool msb_or_lsb) {
+  _bcm_active = false;
+  if (num_bits < 1 || num_bits > 8) return false;
+  if (_bcm_levels == NULL) {
+    _bcm_levels = (uint8_t *) malloc(sizeof(uint8_t) * _max_pins);
+    if (_bcm_levels == NULL) return false;
+    memset(_bcm_levels, 0, _max_pins);
+  }
+  if (num_bits > _bcm_planes_allocated) {
+    // (re)allocate the planes with room for num_bits planes
+    _bcm_planes_allocated = 0;
+    for (uint8_t buffer = 0; buffer < 2; buffer++) {
+      free(_bcm_planes[buffer]);
+      _bcm_planes[buffer] = (uint8_t *) malloc(sizeof(uint8_t) * num_bits * (SIPO8_pin)_max_SIPOs);
+      if (_bcm_planes[buffer] == NULL) return false;
+    }
+    _bcm_planes_allocated = num_bits;
+  }
+  _bcm_bits = num_bits;
+  for (SIPO8_pin pin = 0; pin < _max_pins; pin++) {
+    if (_bcm_levels[pin] >= (1 << num_bits)) _bcm_levels[pin] = (1 << num_bits) - 1;
+  }
+  build_bcm_planes(_bcm_planes[0]);
+  _bcm_front      = 0;
+  _bcm_pending    = false;
+  _bcm_order      = msb_or_lsb;
+  _bcm_plane      = 0;
+  _bcm_ticks_left = 0;
+  _bcm_active     = true;
+  return true;
+}
+
+void SIPO8::stop_bcm() {
+  _bcm_active = false;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sets/reads the brightness level of the given pin (absolute pin reference). Levels
+// above the maximum for the number of bits in use are shown fully on. Changes are
+// shown once posted by bcm_frame.
+// Must follow start_bcm, returns pin_set_failure/pin_read_failure otherwise.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::set_pin_brightness(SIPO8_pin pin, uint8_t level) {
+  if (_bcm_levels != NULL && pin < _num_active_pins) {
+    uint8_t max_level = (1 << _bcm_bits) - 1;
+    _bcm_levels[pin] = level > max_level ? max_level : level;
+    return pin;
+  }
+  return SIPO8_failed(num_set_failures, pin_set_failure);
+}
+
+int SIPO8::read_pin_brightness(SIPO8_pin pin) {
+  if (_bcm_levels != NULL && pin < _num_active_pins) {
+    return _bcm_levels[pin];
+  }
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+void SIPO8::set_all_brightness(uint8_t level) {
+  if (_bcm_levels != NULL) {
+    uint8_t max_level = (1 << _bcm_bits) - 1;
+    memset(_bcm_levels, level > max_level ? max_level : level, _num_active_pins);
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Posts the current brightness levels as the next BCM frame. It is shown from the
+// start of the next complete cycle.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::bcm_frame() {
+  if (_bcm_active) {
+    _bcm_pending = false; // stops bcm_tick swapping planes while back is built
+    build_bcm_planes(_bcm_planes[!_bcm_front]);
+    _bcm_pending = true;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Continues the BCM display, see start_bcm.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::bcm_tick() {
+  if (!_bcm_active || _next_bank == 0) return;
+  if (_bcm_ticks_left == 0) {
+    // current plane's time is up - transfer and show the next
+    uint8_t plane = _bcm_plane;
+    const uint8_t * plane_bytes = _bcm_planes[_bcm_front] + (SIPO8_pin)plane * _max_SIPOs;
+    for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+      if (SIPO_banks[bank].bank_group == bank) {
+        xfer_group_bytes(bank, plane_bytes, _bcm_order);
+      }
+    }
+    _bcm_ticks_left = 1 << plane;
+    _bcm_plane++;
+    if (_bcm_plane >= _bcm_bits) {
+      // end of a complete cycle, the frame boundary - show the next frame if posted
+      _bcm_plane = 0;
+      if (_bcm_pending) {
+        _bcm_front   = !_bcm_front;
+        _bcm_pending = false;
+      }
+      num_bcm_frames++;
+    }
+  }
+  _bcm_ticks_left--;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Builds the bit planes from the brightness levels. Each group of 8 pins - one pin
+// status byte - has its 8 level bytes transposed as an 8x8 bit matrix, giving the
+// pins' level bit k as a byte for plane k, 32bits at a time rather than pin by pin.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::build_bcm_planes(uint8_t * planes) {
+  SIPO8_index num_bytes = _num_active_pins / pins_per_SIPO;
+  for (SIPO8_index status_byte = 0; status_byte < num_bytes; status_byte++) {
+    const uint8_t * level = &_bcm_levels[status_byte * pins_per_SIPO];
+    // rows of the matrix are the levels of pins 7 down to 0, msb first
+    uint32_t upper = (uint32_t)level[7] << 24 | (uint32_t)level[6] << 16 |
+                     (uint32_t)level[5] << 8  | level[4];
+    uint32_t lower = (uint32_t)level[3] << 24 | (uint32_t)level[2] << 16 |
+                     (uint32_t)level[1] << 8  | level[0];
+    uint32_t swap;
+    // swap 1x1 bit blocks, then 2x2, then 4x4 (Hacker's Delight transpose8)
+    swap  = (upper ^ (upper >> 7)) & 0x00AA00AA;
+    upper = upper ^ swap ^ (swap << 7);
+    swap  = (lower ^ (lower >> 7)) & 0x00AA00AA;
+    lower = lower ^ swap ^ (swap << 7);
+    swap  = (upper ^ (upper >> 14)) & 0x0000CCCC;
+    upper = upper ^ swap ^ (swap << 14);
+    swap  = (lower ^ (lower >> 14)) & 0x0000CCCC;
+    lower = lower ^ swap ^ (swap << 14);
+    swap  = (upper & 0xF0F0F0F0) | ((lower >> 4) & 0x0F0F0F0F);
+    lower = ((upper << 4) & 0xF0F0F0F0) | (lower & 0x0F0F0F0F);
+    upper = swap;
+    // row j of the result is level bit 7 - j of each pin, pin 0 as bit 0
+    uint8_t plane_bits[pins_per_SIPO] = {(uint8_t)(lower), (uint8_t)(lower >> 8),
+                                         (uint8_t)(lower >> 16), (uint8_t)(lower >> 24),
+                                         (uint8_t)(upper), (uint8_t)(upper >> 8),
+                                         (uint8_t)(upper >> 16), (uint8_t)(upper >> 24)};
+    for (uint8_t plane = 0; plane < _bcm_bits; plane++) {
+      planes[(SIPO8_pin)plane * _max_SIPOs + status_byte] = plane_bits[plane];
+    }
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Input banks.
+// An input bank is a cascade of parallel in/serial out ICs (PISOs), eg 74HC165,
+// sharing data (serial out of the PISO nearest the microcontroller), clock and
+// shift/load pins. Input banks are numbered, and their input pins mapped, in an
+// input array of their own, separately from the (output) SIPO banks - input pin 0
+// is input A of the first PISO of the first input bank, and so on. Input storage
+// is allocated from the heap as each input bank is created, also for SIPO8Static.
+// The create process fails if the total number of PISOs would exceed
+// SIPO8_max_index (255 with 8 bit indices, see SIPO8_INDEX_BITS), or if there is
+// insufficient memory.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::create_input_bank(uint8_t data_pin, uint8_t clock_pin, uint8_t load_pin,
+                                      SIPO8_index num_PISOs) {
+  if (num_PISOs == 0 || num_PISOs > SIPO8_max_index - _num_input_bytes) return create_bank_failure;
+  SIPO8_index num_bytes = _num_input_bytes + num_PISOs;
+  PISO_control * banks = (PISO_control *) realloc(PISO_banks, sizeof(PISO_control) * (_num_input_banks + 1));
+  if (banks == NULL) return create_bank_failure;
+  PISO_banks = banks;
+  if (!grow_input_bytes(input_status_bytes, num_bytes) ||
+      !grow_input_bytes(_input_samples, num_bytes) ||
+      !grow_input_bytes(_input_count0, num_bytes) ||
+      !grow_input_bytes(_input_count1, num_bytes) ||
+      !grow_input_bytes(_input_changes, num_bytes)) {
+    return create_bank_failure;
+  }
+  SIPO8_pin_mode(data_pin,  INPUT);
+  SIPO8_pin_mode(clock_pin, OUTPUT);
+  SIPO8_digital_write(clock_pin, LOW);
+  SIPO8_pin_mode(load_pin,  OUTPUT);
+  SIPO8_digital_write(load_pin, HIGH);
+  PISO_control & bank = PISO_banks[_num_input_banks];
+  bank.bank_data_pin   = data_pin;
+  bank.bank_clock_pin  = clock_pin;
+  bank.bank_load_pin   = load_pin;
+  bank.bank_num_PISOs  = num_PISOs;
+  bank.bank_first_byte = _num_input_bytes;
+  bank.bank_low_pin    = (SIPO8_pin)_num_input_bytes * pins_per_SIPO;
+  bank.bank_high_pin   = bank.bank_low_pin + (SIPO8_pin)num_PISOs * pins_per_SIPO - 1; // inclusive pin numbers
+#if SIPO8_FAST_IO
+  bank.bank_data_port  = portInputRegister(digitalPinToPort(data_pin));
+  bank.bank_clock_port = portOutputRegister(digitalPinToPort(clock_pin));
+  bank.bank_load_port  = portOutputRegister(digitalPinToPort(load_pin));
+  bank.bank_data_mask  = digitalPinToBitMask(data_pin);
+  bank.bank_clock_mask = digitalPinToBitMask(clock_pin);
+  bank.bank_load_mask  = digitalPinToBitMask(load_pin);
+  bank.bank_fast_io    = bank.bank_data_port  != NULL &&
+                         bank.bank_clock_port != NULL &&
+                         bank.bank_load_port  != NULL;
+#endif
+  for (SIPO8_index input_byte = _num_input_bytes; input_byte < num_bytes; input_byte++) {
+    input_status_bytes[input_byte] = 0;
+    _input_count0[input_byte]      = 0;
+    _input_count1[input_byte]      = 0;
+    _input_changes[input_byte]     = 0;
+  }
+  _num_input_bytes = num_bytes;
+  num_input_pins   = (SIPO8_pin)num_bytes * pins_per_SIPO;
+  _inputs_seeded   = false;  // the next scan sets the new bank's starting statuses
+  _num_input_banks++;
+  num_input_banks = _num_input_banks;
+  return _num_input_banks - 1;
+}
+
+// resizes one of the input byte arrays, which is left unchanged if out of memory
+bool SIPO8::grow_input_bytes(uint8_t * & bytes, SIPO8_pin num_bytes) {
+  uint8_t * grown = (uint8_t *) realloc(bytes, sizeof(uint8_t) * num_bytes);
+  if (grown == NULL) return false;
+  bytes = grown;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Debounces one unit - a SIPO8_word or a byte - of input pins. Each pin has a 2bit
+// counter, held vertically as one bit in count0 and one in count1, of the number
+// of consecutive scans in which its sample has differed from its status. The
+// counter is cleared whenever the sample matches the status, and the status
+// changes on the 4th differing scan, so all the pins of the unit are debounced
+// together by a few bitwise operations.
+// Without debouncing, the status is the sample. Pins changed are recorded in
+// changes.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+template <class Unit>
+static void debounce_input_unit(uint8_t * status, uint8_t * count0, uint8_t * count1,
+                                uint8_t * changes, const uint8_t * samples,
+                                bool debounce, bool seeded) {
+  Unit status_bits, count0_bits, count1_bits, changed_bits, sample_bits;
+  // memcpy, as the bytes need not be aligned
+  memcpy(&status_bits,  status,  sizeof(Unit));
+  memcpy(&count0_bits,  count0,  sizeof(Unit));
+  memcpy(&count1_bits,  count1,  sizeof(Unit));
+  memcpy(&changed_bits, changes, sizeof(Unit));
+  memcpy(&sample_bits,  samples, sizeof(Unit));
+  Unit differ = sample_bits ^ status_bits;
+  Unit toggle;
+  if (debounce && seeded) {
+    count1_bits = (count1_bits ^ count0_bits) & differ;
+    count0_bits = ~count0_bits & differ;
+    toggle      = differ & ~(count0_bits | count1_bits);  // counters rolled over
+  } else {
+    count0_bits = 0;
+    count1_bits = 0;
+    toggle      = differ;
+  }
+  status_bits = status_bits ^ toggle;
+  if (seeded) changed_bits = changed_bits | toggle;
+  memcpy(status,  &status_bits,  sizeof(Unit));
+  memcpy(count0,  &count0_bits,  sizeof(Unit));
+  memcpy(count1,  &count1_bits,  sizeof(Unit));
+  memcpy(changes, &changed_bits, sizeof(Unit));
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Scans all input banks - shifts in every PISO of every bank, in one pass, then
+// updates input_status_bytes, debounced unless use_debounce(false), and records
+// each input pin whose status changed, see read_input_changes.
+// The first scan after an input bank is created sets the starting statuses of
+// all input pins, undebounced, and records no changes.
+// Scans are intended to be made at a regular interval - with debouncing, an
+// input must hold its new level for 4 consecutive scans before its status
+// changes, so scanning every 5ms debounces inputs over 20ms.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::scan_inputs() {
+  for (SIPO8_index bank = 0; bank < _num_input_banks; bank++) {
+    shift_in_bank(bank);
+  }
+#if SIPO8_STATS
+  _stats.num_bytes_scanned = _stats.num_bytes_scanned + _num_input_bytes;
+#endif
+  SIPO8_pin input_byte = 0;
+  SIPO8_pin remaining  = _num_input_bytes;
+  while (remaining >= sizeof(SIPO8_word)) {
+    debounce_input_unit<SIPO8_word>(&input_status_bytes[input_byte], &_input_count0[input_byte],
+                                    &_input_count1[input_byte], &_input_changes[input_byte],
+                                    &_input_samples[input_byte], _debounce, _inputs_seeded);
+    input_byte = input_byte + sizeof(SIPO8_word);
+    remaining  = remaining - sizeof(SIPO8_word);
+  }
+  while (input_byte < _num_input_bytes) {
+    debounce_input_unit<uint8_t>(&input_status_bytes[input_byte], &_input_count0[input_byte],
+                                 &_input_count1[input_byte], &_input_changes[input_byte],
+                                 &_input_samples[input_byte], _debounce, _inputs_seeded);
+    input_byte++;
+  }
+  _inputs_seeded = true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Selects whether input statuses are debounced (true, the default) by scan_inputs.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::use_debounce(bool debounce) {
+  _debounce = debounce;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Input status reads, as at the last scan_inputs. As for the SIPO bank functions,
+// read_input_bank_pin and read_input_bank_PISO operate relative to the given
+// input bank.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8::read_input_pin(SIPO8_pin pin) {
+  if (pin < (SIPO8_pin)_num_input_bytes * pins_per_SIPO) {
+    return bitRead(input_status_bytes[pin / pins_per_SIPO], pin % pins_per_SIPO);
+  }
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+int SIPO8::read_input_bank_pin(SIPO8_index bank, SIPO8_pin pin) {
+  if (bank < _num_input_banks && pin < (SIPO8_pin)PISO_banks[bank].bank_num_PISOs * pins_per_SIPO) {
+    return read_input_pin(PISO_banks[bank].bank_low_pin + pin);
+  }
+  return SIPO8_failed(num_read_failures, pin_read_failure);
+}
+
+int SIPO8::read_input_bank_PISO(SIPO8_index bank, SIPO8_index PISO_num) {
+  if (bank < _num_input_banks) {
+    if (PISO_num < PISO_banks[bank].bank_num_PISOs) {
+      return input_status_bytes[PISO_banks[bank].bank_first_byte + PISO_num];
+    }
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+  }
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns a bit mask of the input pins of the given input bank PISO whose status
+// has changed since this was last called for the PISO, bit n for PISO input n,
+// and clears it. Combined with read_input_bank_PISO this gives, for example, the
+// pins just pressed (changed & status) or released (changed & ~status).
+// inputs_changed returns true if any input pin has changed, not yet read, so a
+// sketch need examine the change masks only when there is a change.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8::read_input_changes(SIPO8_index bank, SIPO8_index PISO_num) {
+  if (bank < _num_input_banks) {
+    if (PISO_num < PISO_banks[bank].bank_num_PISOs) {
+      SIPO8_index input_byte = PISO_banks[bank].bank_first_byte + PISO_num;
+      uint8_t changed    = _input_changes[input_byte];
+      _input_changes[input_byte] = 0;
+      return changed;
+    }
+    return SIPO8_failed(num_SIPO_not_found, SIPO_not_found);
+  }
+  return SIPO8_failed(num_bank_not_found, bank_not_found);
+}
+
+bool SIPO8::inputs_changed() {
+  SIPO8_pin input_byte = 0;
+  SIPO8_pin remaining  = _num_input_bytes;
+  while (remaining >= sizeof(SIPO8_word)) {
+    SIPO8_word changed;
+    memcpy(&changed, &_input_changes[input_byte], sizeof(SIPO8_word));
+    if (changed != 0) return true;
+    input_byte = input_byte + sizeof(SIPO8_word);
+    remaining  = remaining - sizeof(SIPO8_word);
+  }
+  while (input_byte < _num_input_bytes) {
+    if (_input_changes[input_byte++] != 0) return true;
+  }
+  return false;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Shifts in the given input bank's PISOs to _input_samples. The shift/load pin is
+// pulsed LOW to load all PISOs' parallel inputs, then each PISO's inputs are read,
+// input H first, from the data pin, clocking the next on each rising clock edge.
+// The PISO nearest the microcontroller is read first, as the bank's first PISO.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::shift_in_bank(SIPO8_index bank) {
+  uint8_t * samples = &_input_samples[PISO_banks[bank].bank_first_byte];
+  SIPO8_index num_PISOs = PISO_banks[bank].bank_num_PISOs;
+#if SIPO8_FAST_IO
+  if (_fast_io && PISO_banks[bank].bank_fast_io) {
+    SIPO8_port_reg * data_port  = PISO_banks[bank].bank_data_port;
+    SIPO8_port_reg * clock_port = PISO_banks[bank].bank_clock_port;
+    SIPO8_port_reg * load_port  = PISO_banks[bank].bank_load_port;
+    SIPO8_port_mask  data_mask  = PISO_banks[bank].bank_data_mask;
+    SIPO8_port_mask  clock_mask = PISO_banks[bank].bank_clock_mask;
+    SIPO8_port_mask  load_mask  = PISO_banks[bank].bank_load_mask;
+    {
+      SIPO8_atomic_begin();
+      *load_port &= ~load_mask;
+      *load_port |= load_mask;
+      SIPO8_atomic_end();
+    }
+    for (SIPO8_index PISO = 0; PISO < num_PISOs; PISO++) {
+      uint8_t input_bits = 0;
+      SIPO8_atomic_begin();
+      for (uint8_t bit_mask = 0b10000000; bit_mask != 0; bit_mask >>= 1) {
+        if (*data_port & data_mask) input_bits |= bit_mask;
+        *clock_port |= clock_mask;
+        *clock_port &= ~clock_mask;
+      }
+      SIPO8_atomic_end();
+      samples[PISO] = input_bits;
+    }
+    return;
+  }
+#endif
+  uint8_t data_pin  = PISO_banks[bank].bank_data_pin;
+  uint8_t clock_pin = PISO_banks[bank].bank_clock_pin;
+  SIPO8_digital_write(PISO_banks[bank].bank_load_pin, LOW);
+  SIPO8_digital_write(PISO_banks[bank].bank_load_pin, HIGH);
+  for (SIPO8_index PISO = 0; PISO < num_PISOs; PISO++) {
+    uint8_t input_bits = 0;
+    for (uint8_t bit_mask = 0b10000000; bit_mask != 0; bit_mask >>= 1) {
+      if (SIPO8_digital_read(data_pin)) input_bits |= bit_mask;
+      SIPO8_digital_write(clock_pin, HIGH);
+      SIPO8_digital_write(clock_pin, LOW);
+    }
+    samples[PISO] = input_bits;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the next bit of a chain test sequence, advancing the given 16 bit linear
+// feedback shift register (taps 16, 14, 13 and 11). The sequence repeats only every
+// 65535 bits, so is not read back unchanged from a chain of the wrong length.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+static bool next_test_bit(uint16_t & test_bits) {
+  bool test_bit = test_bits & 1;
+  test_bits >>= 1;
+  if (test_bit) test_bits ^= 0xB400;
+  return test_bit;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Chain verification.
+// A bank whose last SIPO's serial output (QH' of a 74HC595) is wired back to an
+// input pin, its loopback pin, may be checked for a broken or miswired chain - a
+// broken link otherwise silently shifts every byte beyond it. Test bits are shifted
+// into the bank and read back from the loopback pin as they are clocked through,
+// without the latch being set, so the SIPO outputs are unchanged. The next transfer
+// to the bank replaces the test bits. The other banks of the bank's group are
+// clocked too, also without their latch being set, so once a check of a bank in a
+// group completes the group's committed statuses are shifted back into all of its
+// SIPOs, in the bit order of its last transfer, see restore_group.
+// set_bank_loopback sets the given bank's loopback pin, or no_loopback for none.
+// It returns false if the bank is not valid or is an SPI bank, whose data and
+// clock pins belong to the SPI peripheral.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::set_bank_loopback(SIPO8_index bank, uint8_t loopback_pin) {
+  if (bank >= _next_bank || SIPO_banks[bank].bank_type == SPI_bank) return false;
+  if (loopback_pin != no_loopback) SIPO8_pin_mode(loopback_pin, INPUT);
+  SIPO_banks[bank].bank_loopback_pin = loopback_pin;
+  _spot_bits = 0;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Makes a full check of the given bank's chain, filling report. LOW bits are
+// shifted in to clear the chain, then a single HIGH bit, the clock pulses until it
+// is read back giving the chain length detected (up to twice the bank's length),
+// then a test byte for each of the bank's SIPOs, each bit of which must be read
+// back unchanged that many clock pulses later. The first test byte shifted in is
+// that which fills the SIPO furthest from the microcontroller. A test byte read
+// back changed shows a fault on the data path, though not where along the chain.
+// Returns the report's chain_status, or verify_failure if the bank is not valid,
+// has no loopback pin or a transfer (chunked, background refresh or brightness
+// modulation) is in progress. A check takes some 40 clock pulses per SIPO of the
+// bank, plus 8 per SIPO of its group if it is in one, so suits start up, or
+// following up a fault found by spot_check.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8::verify_bank(SIPO8_index bank, chain_report & report) {
+  if (bank >= _next_bank || SIPO_banks[bank].bank_loopback_pin == no_loopback ||
+      _xfer_active || _refresh_active || _bcm_active) return verify_failure;
+  _spot_bits = 0;  // the test bits replace those of any spot check
+  report.chain_status   = chain_broken;
+  report.chain_bits     = 0;
+  report.chain_SIPOs    = 0;
+  report.first_bad_byte = SIPO8_max_index;
+  check_chain(bank, report);
+  restore_group(SIPO_banks[bank].bank_group);
+  return report.chain_status;
+}
+
+// shifts test bits through the given bank's chain, filling report, see verify_bank
+void SIPO8::check_chain(SIPO8_index bank, chain_report & report) {
+  uint8_t   loopback_pin = SIPO_banks[bank].bank_loopback_pin;
+  SIPO8_pin num_bits     = (SIPO8_pin)SIPO_banks[bank].bank_num_SIPOs * pins_per_SIPO;
+  SIPO8_pin max_bits     = num_bits * 2;
+  for (SIPO8_pin bit = 0; bit < max_bits; bit++) {
+    shift_test_bit(bank, LOW);
+  }
+  if (SIPO8_digital_read(loopback_pin)) return;  // stuck HIGH, broken
+  shift_test_bit(bank, HIGH);
+  SIPO8_pin chain_bits = 1;
+  while (!SIPO8_digital_read(loopback_pin)) {
+    if (chain_bits == max_bits) return;          // broken
+    shift_test_bit(bank, LOW);
+    chain_bits++;
+  }
+  report.chain_bits  = chain_bits;
+  report.chain_SIPOs = chain_bits / pins_per_SIPO;
+  // the HIGH bit is at the loopback pin, each test bit following it is read back
+  // as it reaches the loopback pin in turn
+  uint16_t in_bits  = _test_seed;
+  uint16_t out_bits = _test_seed;
+  for (SIPO8_pin bit = 1; bit < num_bits + chain_bits; bit++) {
+    shift_test_bit(bank, bit <= num_bits ? next_test_bit(in_bits) : LOW);
+    if (bit >= chain_bits &&
+        (bool)SIPO8_digital_read(loopback_pin) != next_test_bit(out_bits)) {
+      report.first_bad_byte = (bit - chain_bits) / pins_per_SIPO;
+      break;
+    }
+  }
+  if (chain_bits != num_bits) {
+    report.chain_status = chain_wrong_length;
+  } else if (report.first_bad_byte != SIPO8_max_index) {
+    report.chain_status = chain_bad_data;
+  } else {
+    report.chain_status = chain_ok;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Continues a rolling check of the banks with loopback pins, one bank at a time in
+// turn, shifting in at most max_bits test bits - so may be called from loop()
+// whenever it is otherwise idle, at a cost bounded by max_bits. Each test bit is
+// read back as it reaches the loopback pin, a bank's length of bits later, and a
+// bank passes, counted in num_spot_checks, once a bank's length of test bits have
+// been read back unchanged. A transfer to the bank's group replaces its test bits
+// and its check restarts, so a bank transferred more often than its check takes is
+// never checked in full. The check of a bank in a group ends by restoring the
+// group, see verify_bank, so the call ending it may also shift out 8 bits per SIPO
+// of the group.
+// Returns the bank found faulty, counted in num_chain_faults, whose check then
+// moves on to the next bank - verify_bank may then tell more of the fault. Returns
+// no_chain_fault if none was found, or spot_check_failure, when nothing is
+// checked, if no bank has a loopback pin or a transfer (chunked, background
+// refresh or brightness modulation) is in progress.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_result SIPO8::spot_check(uint16_t max_bits) {
+  if (_xfer_active || _refresh_active || _bcm_active) return spot_check_failure;
+  if (_spot_bank >= _next_bank || SIPO_banks[_spot_bank].bank_loopback_pin == no_loopback) {
+    if (!next_spot_bank()) return spot_check_failure;
+  }
+  uint8_t   loopback_pin = SIPO_banks[_spot_bank].bank_loopback_pin;
+  SIPO8_pin num_bits     = (SIPO8_pin)SIPO_banks[_spot_bank].bank_num_SIPOs * pins_per_SIPO;
+  for (; max_bits > 0; max_bits--) {
+    if (_spot_bits == 0) _spot_out = _spot_in;  // the check (re)starts
+    if (_spot_bits == num_bits * 2) {
+      num_spot_checks++;
+      restore_group(SIPO_banks[_spot_bank].bank_group);
+      next_spot_bank();
+      break;
+    }
+    if (_spot_bits >= num_bits &&
+        (bool)SIPO8_digital_read(loopback_pin) != next_test_bit(_spot_out)) {
+      SIPO8_index faulty_bank = _spot_bank;
+      num_chain_faults++;
+      restore_group(SIPO_banks[faulty_bank].bank_group);
+      next_spot_bank();
+      return faulty_bank;
+    }
+    shift_test_bit(_spot_bank, next_test_bit(_spot_in));
+    _spot_bits++;
+  }
+  return no_chain_fault;
+}
+
+// moves the spot check on to the next bank with a loopback pin, in turn, returning
+// false if there is none
+bool SIPO8::next_spot_bank() {
+  _spot_bits = 0;
+  for (SIPO8_index tried = 0; tried < _next_bank; tried++) {
+    _spot_bank = _spot_bank + 1 < _next_bank ? _spot_bank + 1 : 0;
+    if (SIPO_banks[_spot_bank].bank_loopback_pin != no_loopback) return true;
+  }
+  return false;
+}
+
+// shifts the given test bit into the given bank, clocking the bank's group, by
+// direct port register writes or digitalWrite as a transfer would
+void SIPO8::shift_test_bit(SIPO8_index bank, bool test_bit) {
+  shift_out_SIPO(bank, test_bit ? 0b10000000 : 0, 1);
+}
+
+// shifts the committed statuses of the group starting with the given bank back
+// into its SIPOs, in the bit order of its last transfer, without setting the latch,
+// so replacing the test bits a check clocked into the group's other banks. Nothing
+// is shifted if the bank is not in a group, its test bits are left to the next
+// transfer.
+void SIPO8::restore_group(SIPO8_index group) {
+  if (SIPO_banks[group].bank_next_in_group == group) return;
+  for (SIPO8_index SIPO = 0; SIPO < SIPO_banks[group].bank_group_SIPOs; SIPO++) {
+    shift_out_group_SIPO(group, SIPO, committed_status_bytes, SIPO_banks[group].bank_group_order,
+                         0, pins_per_SIPO);
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Starts use of a bank map - one SIPO8_index per pin status byte (max_SIPOs
+// entries) recording the bank of each, so that get_bank_from_pin is a single look
+// up rather than a search of the banks. Returns false if there is insufficient
+// memory for the map (allocated on first use).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::use_bank_map() {
+  if (_bank_map == NULL) {
+    _bank_map = (SIPO8_index *) malloc(sizeof(SIPO8_index) * _max_SIPOs);
+    if (_bank_map == NULL) return false;
+    for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+      map_bank(bank);
+    }
+  }
+  return true;
+}
+
+// records the given bank against each of its status bytes in the bank map
+void SIPO8::map_bank(SIPO8_index bank) {
+  SIPO8_index * entry = &_bank_map[SIPO_banks[bank].bank_first_byte];
+  for (SIPO8_index SIPO = 0; SIPO < SIPO_banks[bank].bank_num_SIPOs; SIPO++) {
+    entry[SIPO] = bank;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Selects how banks are transferred to the hardware SIPOs - by direct port register
+// writes (true, the default) or by digitalWrite (false). Only has an effect if the
+// library is compiled with SIPO8_FAST_IO, otherwise digitalWrite is always used.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::use_fast_io(bool fast_io) {
+  _fast_io = fast_io;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function is provided to assist end user to provide debug data during development.
+// Prints all active pin status bytes, in bit form, starting with pin 0 and
+// progressing to the last active end pin defined.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::print_pin_statuses() {
+  if (_next_bank > 0) {
+    Serial.println(F("\nActive pin array, pin statuses:"));
+    // there is at least 1 bank
+    SIPO8_index SIPO_count = 0;
+    for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+      Serial.print(F("Bank "));
+      if (bank < 10)Serial.print(F(" "));
+      Serial.print(bank);
+      Serial.print(F(": MS"));
+      SIPO8_index start_byte = SIPO_count;
+      SIPO8_index last_byte = start_byte + SIPO_banks[bank].bank_num_SIPOs - 1;
+      SIPO_count = SIPO_count + SIPO_banks[bank].bank_num_SIPOs;
+      for (int32_t next_byte = last_byte; next_byte >= (int32_t)start_byte; next_byte--) {
+        uint8_t SIPO_status = pin_status_bytes[next_byte];
+        for (int pos = 7; pos >= 0; pos--) {
+          uint8_t pin_status = bitRead(SIPO_status, pos);
+          Serial.print(pin_status);
+        }
+      }
+      Serial.println(F("LS"));
+    }
+  } else {
+    Serial.println(F("\nNo banks defined"));
+  }
+  Serial.flush();
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function is provided to assist end user to display debug data during development.
+// Prints all setup data as a confirmation that the end user has correctly configured
+// all key data.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::print_SIPO_data() {
+  Serial.println(F("\nSIPO global values:"));
+  Serial.print(F("pins_per_SIPO   = "));
+  Serial.println(pins_per_SIPO);
+  Serial.print(F("max_SIPOs       = "));
+  Serial.println(_max_SIPOs);
+  Serial.print(F("bank_SIPO_count = "));
+  Serial.println(_bank_SIPO_count);
+  Serial.print(F("num_active_pins = "));
+  Serial.println(_num_active_pins);
+  Serial.print(F("num_pin_status_bytes = "));
+  Serial.println(_num_pin_status_bytes);
+  Serial.print(F("next_free bank = "));
+  if (_bank_SIPO_count < _max_SIPOs) {
+    Serial.print(_next_bank);
+    Serial.println();
+  } else {
+    Serial.println(F(" all SIPOs used"));
+  }
+  Serial.print("Number timers  =  ");
+  Serial.println(_max_timers);
+  Serial.println(F("\nBank data:"));
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    // still SIPOs available to assign to a new bank
+    Serial.print(F("bank = "));
+    Serial.println(bank);
+    Serial.print(F("  num SIPOs =\t"));
+    Serial.println(SIPO_banks[bank].bank_num_SIPOs);
+    if (SIPO_banks[bank].bank_type == SPI_bank) {
+      Serial.print(F("  SPI clock =\t"));
+      Serial.println(SIPO_banks[bank].bank_SPI_clock);
+    }
+    Serial.print(F("  latch_pin =\t"));
+    Serial.print(SIPO_banks[bank].bank_latch_pin);
+    Serial.print(F("  clock_pin =\t"));
+    Serial.print(SIPO_banks[bank].bank_clock_pin);
+    Serial.print(F("  data_pin  =\t"));
+    Serial.println(SIPO_banks[bank].bank_data_pin);
+    Serial.print(F("  low_pin   =\t"));
+    Serial.print(SIPO_banks[bank].bank_low_pin);
+    Serial.print(F("  high_pin  =\t"));
+    Serial.println(SIPO_banks[bank].bank_high_pin);
+    if (SIPO_banks[bank].bank_next_in_group != bank || SIPO_banks[bank].bank_group != bank) {
+      Serial.print(F("  group     =\t"));
+      Serial.println(SIPO_banks[bank].bank_group);
+    }
+    if (SIPO_banks[bank].bank_bit_order != order_by_xfer) {
+      Serial.print(F("  bit order =\t"));
+      Serial.println(SIPO_banks[bank].bank_bit_order == LSBFIRST ? F("LSBFIRST") : F("MSBFIRST"));
+    }
+    if (SIPO_banks[bank].bank_wiring != NULL) {
+      Serial.print(F("  wiring    =\t"));
+      for (uint8_t pin = 0; pin < pins_per_SIPO; pin++) {
+        Serial.print(SIPO_banks[bank].bank_wiring[pin]);
+        Serial.print(pin < pins_per_SIPO - 1 ? F(",") : F("\n"));
+      }
+    }
+    if (SIPO_banks[bank].bank_loopback_pin != no_loopback) {
+      Serial.print(F("  loopback_pin =\t"));
+      Serial.println(SIPO_banks[bank].bank_loopback_pin);
+    }
+#if SIPO8_STATS
+    Serial.print(F("  transfers =\t"));
+    Serial.println(SIPO_banks[bank].bank_xfers);
+#endif
+  }
+  if (_num_input_banks > 0) {
+    Serial.println(F("\nInput bank data:"));
+    for (SIPO8_index bank = 0; bank < _num_input_banks; bank++) {
+      Serial.print(F("input bank = "));
+      Serial.println(bank);
+      Serial.print(F("  num PISOs =\t"));
+      Serial.println(PISO_banks[bank].bank_num_PISOs);
+      Serial.print(F("  load_pin  =\t"));
+      Serial.print(PISO_banks[bank].bank_load_pin);
+      Serial.print(F("  clock_pin =\t"));
+      Serial.print(PISO_banks[bank].bank_clock_pin);
+      Serial.print(F("  data_pin  =\t"));
+      Serial.println(PISO_banks[bank].bank_data_pin);
+      Serial.print(F("  low_pin   =\t"));
+      Serial.print(PISO_banks[bank].bank_low_pin);
+      Serial.print(F("  high_pin  =\t"));
+      Serial.println(PISO_banks[bank].bank_high_pin);
+    }
+  }
+  Serial.flush();
+}
+
+#if SIPO8_STATS
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Run time statistics, compiled with SIPO8_STATS only (see ez_SIPO8_lib.h).
+// read_stats copies the counters into the given snapshot, and clear_stats zeroes
+// them and every bank's bank_xfers. Transfers by refresh_tick and bcm_tick are
+// counted too, so both briefly disable interrupts, restoring their state after
+// (see SIPO8_atomic_begin), as does dump_stats reading bank_xfers. Times are
+// SIPO8_micros, the mean transfer time being xfer_us_total / num_xfer_calls.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::read_stats(stats_snapshot & snapshot) {
+  SIPO8_atomic_begin();
+  snapshot = _stats;
+  SIPO8_atomic_end();
+}
+
+void SIPO8::clear_stats() {
+  SIPO8_atomic_begin();
+  memset(&_stats, 0, sizeof(_stats));
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    SIPO_banks[bank].bank_xfers = 0;
+  }
+  SIPO8_atomic_end();
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Writes the counters to the given stream as a binary record, for a host to log
+// or compare, multi byte values little endian:
+//   stats_dump_version  1 byte
+//   num counters        1 byte  - the stats_snapshot counters, in order
+//   counters            4 bytes each
+//   num banks           4 bytes
+//   bank_xfers          4 bytes for each bank, in bank order
+// Returns the number of bytes written.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+static size_t write_stats_word(Stream & stream, uint32_t value) {
+  uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16),
+                      (uint8_t)(value >> 24)};
+  return stream.write(bytes, sizeof(bytes));
+}
+
+size_t SIPO8::dump_stats(Stream & stream) {
+  stats_snapshot snapshot;
+  read_stats(snapshot);
+  uint32_t counters[sizeof(stats_snapshot) / sizeof(uint32_t)];
+  memcpy(counters, &snapshot, sizeof(counters));
+  uint8_t header[2] = {stats_dump_version, sizeof(counters) / sizeof(uint32_t)};
+  size_t written = stream.write(header, sizeof(header));
+  for (uint8_t counter = 0; counter < sizeof(counters) / sizeof(uint32_t); counter++) {
+    written = written + write_stats_word(stream, counters[counter]);
+  }
+  written = written + write_stats_word(stream, _next_bank);
+  for (SIPO8_index bank = 0; bank < _next_bank; bank++) {
+    SIPO8_atomic_begin();
+    uint32_t bank_xfers = SIPO_banks[bank].bank_xfers;
+    SIPO8_atomic_end();
+    written = written + write_stats_word(stream, bank_xfers);
+  }
+  return written;
+}
+
+// counts a transfer of the group starting with the given bank - the group SIPOs'
+// clock pulses, and a byte per group SIPO on each member's data pin
+void SIPO8::count_group_xfer(SIPO8_index group) {
+  SIPO8_index group_SIPOs = SIPO_banks[group].bank_group_SIPOs;
+  _stats.num_xfers++;
+  _stats.num_bits_clocked = _stats.num_bits_clocked + (uint32_t)group_SIPOs * pins_per_SIPO;
+  for (SIPO8_index member = group; ; member = SIPO_banks[member].bank_next_in_group) {
+    SIPO_banks[member].bank_xfers++;
+    _stats.num_bytes_shifted = _stats.num_bytes_shifted + group_SIPOs;
+    if (SIPO_banks[member].bank_next_in_group == member) break;
+  }
+}
+
+// counts an xfer_banks call taking the given micros
+void SIPO8::count_xfer_time(uint32_t elapsed_us) {
+  if (_stats.num_xfer_calls == 0 || elapsed_us < _stats.xfer_us_min) _stats.xfer_us_min = elapsed_us;
+  if (elapsed_us > _stats.xfer_us_max) _stats.xfer_us_max = elapsed_us;
+  _stats.xfer_us_total = _stats.xfer_us_total + elapsed_us;
+  _stats.num_xfer_calls++;
+}
+#endif
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Function sets the given timer as active and records the start time.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::SIPO8_start_timer(uint8_t timer) {
+  if (timer < _max_timers) {
+    unschedule_timer(timer);  // a scheduled timer becomes a polled timer
+    timers[timer].timer_status = active;
+    timers[timer].start_time = SIPO8_millis();
+  }
+}
+
+//
+// Function cancels the given timer.
+//
+void SIPO8::SIPO8_stop_timer(uint8_t timer) {
+  if (timer < _max_timers) {
+    unschedule_timer(timer);
+    timers[timer].timer_status = not_active;
+  }
+}
+
+//
+// Function determines if the time has elapsed for the given timer, if active.
+// Scheduled timers are never reported as elapsed, see SIPO8_service.
+//
+bool SIPO8::SIPO8_timer_elapsed(uint8_t timer, uint32_t elapsed_time) {
+  if (timer < _max_timers) {
+    if (timers[timer].timer_status == active && timers[timer].timer_action == timer_polled) {
+      if (SIPO8_millis() - timers[timer].start_time >= elapsed_time) {
+        timers[timer].timer_status = not_active; // mark this timer no longer active
+        return elapsed;
+      }
+    }
+  }
+  return not_elapsed;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Scheduled timers.
+// Rather than being polled with SIPO8_timer_elapsed, a scheduled timer
+// expires interval millis after it is scheduled and SIPO8_service then
+// performs its action - calls the given function, or inverts an array
+// pin, a bank pin or a whole bank. A periodic timer is rescheduled from
+// its previous expiry time, not from when it was serviced, so does not
+// drift however late SIPO8_service is called. One shot timers become
+// not active once they expire.
+// Scheduled timers are held in a min-heap ordered by expiry time, so
+// SIPO8_service need only examine the timers that have expired.
+// Each function returns false if the timer, or the pin/bank, is invalid.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::SIPO8_schedule_timer(uint8_t timer, uint32_t interval, bool periodic_timer,
+                                 timer_callback callback) {
+  if (callback == NULL || !schedule_timer(timer, interval, periodic_timer, timer_call)) return false;
+  timers[timer].callback = callback;
+  return true;
+}
+
+bool SIPO8::SIPO8_schedule_invert_pin(uint8_t timer, uint32_t interval, bool periodic_timer,
+                                      SIPO8_pin pin) {
+  if (pin >= _num_active_pins ||
+      !schedule_timer(timer, interval, periodic_timer, timer_invert_pin)) return false;
+  timers[timer].action_pin = pin;
+  return true;
+}
+
+bool SIPO8::SIPO8_schedule_invert_bank_pin(uint8_t timer, uint32_t interval, bool periodic_timer,
+                                           SIPO8_index bank, SIPO8_pin pin) {
+  if (bank >= _next_bank || pin >= (SIPO8_pin)SIPO_banks[bank].bank_num_SIPOs * pins_per_SIPO ||
+      !schedule_timer(timer, interval, periodic_timer, timer_invert_bank_pin)) return false;
+  timers[timer].action_bank = bank;
+  timers[timer].action_pin  = pin;
+  return true;
+}
+
+bool SIPO8::SIPO8_schedule_invert_bank(uint8_t timer, uint32_t interval, bool periodic_timer,
+                                       SIPO8_index bank) {
+  if (bank >= _next_bank ||
+      !schedule_timer(timer, interval, periodic_timer, timer_invert_bank)) return false;
+  timers[timer].action_bank = bank;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Performs the action of every scheduled timer that has expired, in
+// order of expiry, and returns the number of actions performed. Call
+// once per loop, in place of polling each timer. A periodic timer that
+// has fallen more than a whole period behind is performed once, and its
+// missed periods skipped, keeping to its original schedule thereafter.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t SIPO8::SIPO8_service() {
+  uint8_t  num_serviced = 0;
+  uint32_t now = SIPO8_millis();
+  while (_num_scheduled > 0) {
+    uint8_t timer = _timer_heap[0];
+    uint32_t interval = timers[timer].interval;
+    if (now - timers[timer].start_time < interval) break;  // earliest timer not yet expired
+    uint8_t action = timers[timer].timer_action;
+    if (timers[timer].timer_periodic) {
+      // next expiry follows on from this one, skipping any whole periods missed
+      uint32_t behind = now - timers[timer].start_time - interval;
+      timers[timer].start_time = timers[timer].start_time + interval;
+      if (behind >= interval) {
+        timers[timer].start_time = timers[timer].start_time + (behind / interval) * interval;
+      }
+      timer_heap_down(0);
+    } else {
+      unschedule_timer(timer);
+      timers[timer].timer_status = not_active;
+    }
+    // the action comes last, as a callback may itself schedule or stop timers
+    switch (action) {
+      case timer_call:
+        timers[timer].callback(*this, timer);
+        break;
+      case timer_invert_pin:
+        invert_array_pin(timers[timer].action_pin);
+        break;
+      case timer_invert_bank_pin:
+        invert_bank_pin(timers[timer].action_bank, timers[timer].action_pin);
+        break;
+      case timer_invert_bank:
+        invert_bank(timers[timer].action_bank);
+        break;
+    }
+    num_serviced++;
+    if (num_serviced == 255) break;  // eg a callback repeatedly scheduling a zero interval
+  }
+#if SIPO8_STATS
+  _stats.num_services++;
+  _stats.num_timer_actions = _stats.num_timer_actions + num_serviced;
+#endif
+  return num_serviced;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Schedules the given timer to expire interval millis from now, with
+// the given action, replacing any earlier schedule.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::schedule_timer(uint8_t timer, uint32_t interval, bool periodic_timer, uint8_t action) {
+  if (timer >= _max_timers || (periodic_timer && interval == 0)) return false;
+  unschedule_timer(timer);
+  timers[timer].timer_status   = active;
+  timers[timer].start_time     = SIPO8_millis();
+  timers[timer].interval       = interval;
+  timers[timer].timer_periodic = periodic_timer;
+  timers[timer].timer_action   = action;
+  timer_heap_place(_num_scheduled, timer);
+  _num_scheduled++;
+  timer_heap_up(_num_scheduled - 1);
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Removes the given timer from the scheduled timer heap, if scheduled,
+// leaving it a polled timer.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8::unschedule_timer(uint8_t timer) {
+  if (timers[timer].timer_action == timer_polled) return;
+  timers[timer].timer_action = timer_polled;
+  uint8_t position = timers[timer].heap_position;
+  _num_scheduled--;
+  if (position < _num_scheduled) {
+    // fill the gap with the last timer in the heap, then restore the heap order
+    uint8_t moved = _timer_heap[_num_scheduled];
+    timer_heap_place(position, moved);
+    timer_heap_up(position);
+    timer_heap_down(timers[moved].heap_position);
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Scheduled timer heap maintenance. Expiry times are compared relative
+// to now, so are correct across the millis roll over.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8::timer_expires_before(uint8_t timer_a, uint8_t timer_b) {
+  uint32_t expiry_a = timers[timer_a].start_time + timers[timer_a].interval;
+  uint32_t expiry_b = timers[timer_b].start_time + timers[timer_b].interval;
+  return (int32_t)(expiry_a - expiry_b) < 0;
+}
+
+void SIPO8::timer_heap_place(uint8_t position, uint8_t timer) {
+  _timer_heap[position] = timer;
+  timers[timer].heap_position = position;
+}
+
+void SIPO8::timer_heap_up(uint8_t position) {
+  uint8_t timer = _timer_heap[position];
+  while (position > 0) {
+    uint8_t parent = (position - 1) / 2;
+    if (!timer_expires_before(timer, _timer_heap[parent])) break;
+    timer_heap_place(position, _timer_heap[parent]);
+    position = parent;
+  }
+  timer_heap_place(position, timer);
+}
+
+void SIPO8::timer_heap_down(uint8_t position) {
+  uint8_t timer = _timer_heap[position];
+  while (true) {
+    uint16_t child = 2 * position + 1;
+    if (child >= _num_scheduled) break;
+    if (child + 1 < _num_scheduled && timer_expires_before(_timer_heap[child + 1], _timer_heap[child])) {
+      child++;
+    }
+    if (!timer_expires_before(_timer_heap[child], timer)) break;
+    timer_heap_place(position, _timer_heap[child]);
+    position = child;
+  }
+  timer_heap_place(position, timer);
 }
\ No newline at end of file
@@ -5,8 +5,8 @@
 
    Serial/Parallel IC (SIPO) library supporting banking of multiple SIPOs
    of same/different bit sizes.
-   Supports maximum of up to 255 8bit SIPOs (2040 individual output pins)
-   and up to 255 indivual timers.
+   Supports maximum of up to 255 8bit SIPOs (2040 individual output pins),
+   or more with SIPO8_INDEX_BITS, and up to 255 indivual timers.
 
    This example and code is in the public domain and
    may be used without restriction and without warranty.
@@ -18,6 +18,126 @@
 
 #include <Arduino.h>  // always include this lib otherwise wont compile!
 
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Configuration options - edit here, or define before this header is included.
+//
+// SIPO8_CUSTOM_IO - when defined, the pin and clock functions the library uses
+// (SIPO8_pin_mode, SIPO8_digital_write, SIPO8_digital_read, SIPO8_millis and
+// SIPO8_micros) are not mapped to the Arduino core but provided elsewhere, for
+// example by the host simulation backend in extras/host. SIPO8_FAST_IO and
+// SIPO8_SPI then default to 0. SIPO8_FAST_IO may still be set to 1 if the
+// backend also provides digitalPinToPort, digitalPinToBitMask, portOutputRegister
+// and portInputRegister, and the types SIPO8_custom_port_reg, of the registers
+// they point to, and SIPO8_custom_port_mask, as extras/host does.
+//
+// SIPO8_FAST_IO - when 1, each bank's data, clock and latch pins are resolved to
+// their port registers and bit masks at create_bank time and transfers write the
+// registers directly, rather than calling digitalWrite for every bit.
+// Defaults to 1 on AVR, SAM and SAMD boards, 0 elsewhere.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#ifdef SIPO8_CUSTOM_IO
+void     SIPO8_pin_mode(uint8_t pin, uint8_t mode);
+void     SIPO8_digital_write(uint8_t pin, uint8_t level);
+int      SIPO8_digital_read(uint8_t pin);
+uint32_t SIPO8_millis();
+uint32_t SIPO8_micros();
+#ifndef SIPO8_FAST_IO
+#define SIPO8_FAST_IO 0
+#endif
+#ifndef SIPO8_SPI
+#define SIPO8_SPI 0
+#endif
+#else
+inline void     SIPO8_pin_mode(uint8_t pin, uint8_t mode)       { pinMode(pin, mode); }
+inline void     SIPO8_digital_write(uint8_t pin, uint8_t level) { digitalWrite(pin, level); }
+inline int      SIPO8_digital_read(uint8_t pin)                 { return digitalRead(pin); }
+inline uint32_t SIPO8_millis()                                  { return millis(); }
+inline uint32_t SIPO8_micros()                                  { return micros(); }
+#endif
+
+#ifndef SIPO8_FAST_IO
+#if defined(portOutputRegister) && \
+   (defined(__AVR__) || defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_SAMD))
+#define SIPO8_FAST_IO 1
+#else
+#define SIPO8_FAST_IO 0
+#endif
+#endif
+
+// SIPO8_SPI - when 1, create_spi_bank is available for banks whose data and clock
+// lines are wired to the hardware SPI MOSI and SCK pins. Requires the SPI library.
+// Defaults to 1.
+#ifndef SIPO8_SPI
+#define SIPO8_SPI 1
+#endif
+
+#if SIPO8_SPI
+#include <SPI.h>
+#endif
+
+// SIPO8_STATS - when 1, each SIPO8 object counts its transfers, the bytes and
+// bits shifted, the time spent in xfer_banks, its timer services and its failed
+// set_/invert_/read_ calls, see read_stats. Defaults to 0, when none of this is
+// compiled and the library is as it would be without it.
+#ifndef SIPO8_STATS
+#define SIPO8_STATS 0
+#endif
+
+// SIPO8_word - the widest unit the bulk pin status operations work in. AVR has
+// no wider native registers, so works byte by byte; 64bit hosts use 64bit words.
+#if defined(__AVR__)
+typedef uint8_t  SIPO8_word;
+#elif defined(UINTPTR_MAX) && UINTPTR_MAX > 0xFFFFFFFFUL
+typedef uint64_t SIPO8_word;
+#else
+typedef uint32_t SIPO8_word;
+#endif
+
+// SIPO8_INDEX_BITS - width of SIPO, pin status byte and bank numbers, 8, 16 or 32.
+// 8, the default, limits an array to 255 SIPOs (2040 pins), as ever, and suits
+// AVR boards; 16 allows up to 65535 SIPOs and 32 more, for long chains on 32bit
+// boards. SIPO8_index holds SIPO, status byte and bank numbers, SIPO8_pin array
+// and bank pin numbers and counts of status bytes, which may exceed an index.
+#ifndef SIPO8_INDEX_BITS
+#define SIPO8_INDEX_BITS 8
+#endif
+#if SIPO8_INDEX_BITS == 8
+typedef uint8_t  SIPO8_index;
+typedef uint16_t SIPO8_pin;
+#elif SIPO8_INDEX_BITS == 16
+typedef uint16_t SIPO8_index;
+typedef uint32_t SIPO8_pin;
+#elif SIPO8_INDEX_BITS == 32
+typedef uint32_t SIPO8_index;
+typedef uint32_t SIPO8_pin;
+#else
+#error "SIPO8_INDEX_BITS must be 8, 16 or 32"
+#endif
+#define SIPO8_max_index ((SIPO8_index)~(SIPO8_index)0) // largest SIPO8_index, never a valid one
+
+// SIPO8_result - returned by functions giving an array or bank pin number, a SIPO,
+// status byte or bank number, or a count of pins, else a (negative) failure. An
+// int with 8 bit indices, as ever, but 32 bits wider, as an int is only 16 bits
+// on AVR boards and would overflow beyond pin 32767.
+#if SIPO8_INDEX_BITS == 8
+typedef int     SIPO8_result;
+#else
+typedef int32_t SIPO8_result;
+#endif
+
+#if SIPO8_FAST_IO
+#if defined(SIPO8_CUSTOM_IO)
+typedef SIPO8_custom_port_reg  SIPO8_port_reg;   // the backend's port registers
+typedef SIPO8_custom_port_mask SIPO8_port_mask;
+#elif defined(__AVR__)
+typedef volatile uint8_t  SIPO8_port_reg;   // AVR ports are 8 bits wide
+typedef uint8_t           SIPO8_port_mask;
+#else
+typedef volatile uint32_t SIPO8_port_reg;   // ARM ports are 32 bits wide
+typedef uint32_t          SIPO8_port_mask;
+#endif
+#endif
+
 class SIPO8
 {
   public:
@@ -33,6 +153,17 @@ class SIPO8
 #define bank_not_found      -1
 #define SIPO_not_found      -2
 
+    // bank type macros...
+#define shift_bank           0 // bank data/clock pins are driven bit by bit
+#define SPI_bank             1 // bank data/clock pins are driven by hardware SPI
+
+    // bank bit order macro, see create_bank - otherwise LSBFIRST or MSBFIRST...
+#define order_by_xfer        2 // the bank's bit order is that given to each transfer
+
+    // background refresh macros...
+#define refresh_by_SIPO      0 // each refresh_tick transfers one SIPO
+#define refresh_by_bank      1 // each refresh_tick transfers one bank
+
     // timer macros...
 #define timer0               0
 #define timer1               1
@@ -46,88 +177,554 @@ class SIPO8
 #define not_elapsed        !elapsed
 #define active             true
 #define not_active         !active
+#define one_shot           false
+#define periodic           true
+
+    // scheduled timer actions...
+#define timer_polled         0 // not scheduled, see SIPO8_timer_elapsed
+#define timer_call           1 // call the timer's callback function
+#define timer_invert_pin     2 // invert an array pin
+#define timer_invert_bank_pin 3 // invert a bank pin
+#define timer_invert_bank    4 // invert every pin of a bank
+
+    // batch command ops, see submit_batch...
+#define batch_set_pin        0 // set a bank pin HIGH
+#define batch_clear_pin      1 // set a bank pin LOW
+#define batch_invert_pin     2 // invert a bank pin
+#define batch_write_SIPO     3 // set a bank SIPO to the command value
+#define batch_write_bank     4 // set every SIPO of a bank to the command value
 
-    uint16_t max_pins             = 0; // user accessible params
-    uint16_t num_active_pins      = 0; // ...
-    uint8_t  num_pin_status_bytes = 0; // ...
-    uint8_t  num_banks            = 0; // ...
-    uint8_t  max_SIPOs            = 0; // ...
-    uint8_t  bank_SIPO_count      = 0; // ...
+    // chain verification macros, see set_bank_loopback...
+#define no_loopback        255 // the bank has no loopback pin
+#define verify_failure      -1
+#define chain_ok             0 // test bits read back unchanged, after the bank's length
+#define chain_broken         1 // no test bit read back
+#define chain_wrong_length   2 // test bits read back, but not after the bank's length
+#define chain_bad_data       3 // test bits read back changed
+#define no_chain_fault      -1 // spot_check found no fault
+#define spot_check_failure  -2 // spot_check had nothing to check
+
+    SIPO8_pin   max_pins             = 0; // user accessible params
+    SIPO8_pin   num_active_pins      = 0; // ...
+    SIPO8_index num_pin_status_bytes = 0; // ...
+    SIPO8_index num_banks            = 0; // ...
+    SIPO8_index max_SIPOs            = 0; // ...
+    SIPO8_index bank_SIPO_count      = 0; // ...
     uint8_t  max_timers           = 0; // ...
+    uint32_t num_skipped_xfers    = 0; // banks not transferred by xfer_dirty as unchanged
+    volatile uint32_t num_refresh_frames = 0; // complete background refresh passes
+    volatile uint32_t num_bcm_frames     = 0; // complete brightness modulation cycles
+    SIPO8_index num_input_banks   = 0; // input (PISO) banks created
+    SIPO8_pin   num_input_pins    = 0; // ...and their total input pins
+    uint32_t num_spot_checks      = 0; // banks passing a spot check, see spot_check...
+    uint32_t num_chain_faults     = 0; // ...and faults found by spot checks
 
     struct SIPO_control {
       uint8_t  bank_data_pin;
       uint8_t  bank_clock_pin;
       uint8_t  bank_latch_pin;
-      uint8_t  bank_num_SIPOs;
-      uint16_t bank_low_pin;
-      uint16_t bank_high_pin;
+      SIPO8_index bank_num_SIPOs;
+      uint8_t  bank_type;         // shift_bank or SPI_bank
+      uint32_t bank_SPI_clock;    // SPI clock rate (Hz) if an SPI_bank
+      uint8_t  bank_bit_order;    // LSBFIRST, MSBFIRST or order_by_xfer
+      const uint8_t * bank_wiring;// output bit of each SIPO pin, NULL if wired as numbered
+      const uint8_t * bank_wiring_table; // ...as a 256 byte table, see create_bank
+      uint8_t  bank_out_byte;     // group transfers - the byte being shifted out
+      uint8_t  bank_loopback_pin; // input wired to the last SIPO's serial out, or no_loopback
+      bool     bank_committed;    // true once the bank has been transferred
+      bool     bank_group_order;  // bit order of the group's last transfer
+#if SIPO8_STATS
+      uint32_t bank_xfers;        // transfers of the bank, as a member of its group
+#endif
+      SIPO8_pin   bank_low_pin;
+      SIPO8_pin   bank_high_pin;
+      SIPO8_index bank_first_byte;   // pin status byte of the bank's first SIPO
+      SIPO8_index bank_group;        // first bank of the group sharing this bank's clock and latch
+      SIPO8_index bank_next_in_group;// next bank in the group, or this bank if the last
+      SIPO8_index bank_group_SIPOs;  // first bank of a group only - longest member's num SIPOs
+#if SIPO8_FAST_IO
+      bool     bank_fast_io;      // true if the pins below resolved to port registers
+      SIPO8_port_reg * bank_data_port;
+      SIPO8_port_reg * bank_clock_port;
+      SIPO8_port_reg * bank_latch_port;
+      SIPO8_port_mask  bank_data_mask;
+      SIPO8_port_mask  bank_clock_mask;
+      SIPO8_port_mask  bank_latch_mask;
+#endif
     }*SIPO_banks;
 
     uint8_t * pin_status_bytes;  // records current status of each pin
+    uint8_t * committed_status_bytes; // status of each pin as last transferred to the SIPOs
+
+    // input banks - parallel in/serial out ICs (PISOs), eg 74HC165, see create_input_bank
+    struct PISO_control {
+      uint8_t  bank_data_pin;     // serial out (QH) of the PISO nearest the microcontroller
+      uint8_t  bank_clock_pin;
+      uint8_t  bank_load_pin;     // shift/load (SH/LD), LOW loads the parallel inputs
+      SIPO8_index bank_num_PISOs;
+      SIPO8_pin   bank_low_pin;
+      SIPO8_pin   bank_high_pin;
+      SIPO8_index bank_first_byte;   // input status byte of the bank's first PISO
+#if SIPO8_FAST_IO
+      bool     bank_fast_io;      // true if the pins below resolved to port registers
+      SIPO8_port_reg * bank_data_port;  // input register
+      SIPO8_port_reg * bank_clock_port;
+      SIPO8_port_reg * bank_load_port;
+      SIPO8_port_mask  bank_data_mask;
+      SIPO8_port_mask  bank_clock_mask;
+      SIPO8_port_mask  bank_load_mask;
+#endif
+    } *PISO_banks = NULL;
+
+    uint8_t * input_status_bytes = NULL; // (debounced) status of each input pin
+
+    // scheduled timer callback, given the SIPO8 object and the timer that expired
+    typedef void (*timer_callback)(SIPO8 &, uint8_t);
 
     // timer control struct(ure)
     struct timer_control {
       bool     timer_status;    // records status of a timer - active or not active
       uint32_t start_time;      // records the millis time when a timer is started
+      // scheduled timers only - the timer expires at start_time + interval
+      uint32_t interval;        // millis from start_time to expiry, and period if periodic
+      bool     timer_periodic;  // periodic or one_shot
+      uint8_t  timer_action;    // timer_polled if not scheduled, else the action on expiry
+      uint8_t  heap_position;   // position in the scheduled timer heap
+      SIPO8_index action_bank;  // bank for bank actions
+      SIPO8_pin   action_pin;   // array pin, or bank pin, for pin actions
+      timer_callback callback;  // for timer_call actions
     } *timers;
 
+    // batch command, see submit_batch
+    struct batch_command {
+      uint8_t  command_op;      // batch_set_pin, batch_clear_pin etc
+      SIPO8_index command_bank;
+      SIPO8_pin   command_index; // bank pin for pin ops, bank SIPO for batch_write_SIPO
+      uint8_t  command_value;   // SIPO value for batch_write_SIPO and batch_write_bank
+    };
+
+    // chain verification report, see verify_bank
+    struct chain_report {
+      uint8_t     chain_status;   // chain_ok, chain_broken, chain_wrong_length or chain_bad_data
+      SIPO8_pin   chain_bits;     // bits shifted in until the first was read back, 0 if none was
+      SIPO8_index chain_SIPOs;    // ...in whole SIPOs, the chain length detected
+      SIPO8_index first_bad_byte; // first test byte read back changed, SIPO8_max_index if none
+    };
+
+#if SIPO8_STATS
+    // counters, see read_stats
+    struct stats_snapshot {
+      uint32_t num_xfers;           // group transfers, ie latch pulses
+      uint32_t num_bytes_shifted;   // bytes shifted out, one per member bank per group SIPO
+      uint32_t num_bits_clocked;    // clock pulses of the transfers, members sharing each
+      uint32_t num_bytes_scanned;   // input (PISO) bytes shifted in
+      uint32_t num_xfer_calls;      // xfer_banks calls, and their micros...
+      uint32_t xfer_us_min;         // ...shortest...
+      uint32_t xfer_us_max;         // ...longest...
+      uint32_t xfer_us_total;       // ...and total, for the mean
+      uint32_t num_services;        // SIPO8_service calls...
+      uint32_t num_timer_actions;   // ...and the scheduled timer actions they performed
+      uint32_t num_set_failures;    // set_ calls returning pin_set_failure
+      uint32_t num_invert_failures; // invert_ calls returning pin_invert_failure
+      uint32_t num_read_failures;   // read_ calls returning pin_read_failure
+      uint32_t num_bank_not_found;  // set_/invert_/read_ calls returning bank_not_found
+      uint32_t num_SIPO_not_found;  // set_/invert_/read_ calls returning SIPO_not_found
+    };
+#define stats_dump_version   1
+#endif
+
     // ******* function declarations....
 
-    SIPO8(uint8_t, uint8_t); // constructor function called when class is initiated
+    SIPO8(SIPO8_index, uint8_t); // constructor function called when class is initiated
 
-    int  create_bank(uint8_t, uint8_t, uint8_t, uint8_t);
+    SIPO8_result create_bank(uint8_t, uint8_t, uint8_t, SIPO8_index, uint8_t = order_by_xfer,
+                             const uint8_t * = NULL);
+#if SIPO8_SPI
+    SIPO8_result create_spi_bank(uint8_t, SIPO8_index, uint32_t, uint8_t = order_by_xfer,
+                                 const uint8_t * = NULL);
+#endif
     void set_all_array_pins(bool);
     void invert_all_array_pins();
-    int  set_array_pin(uint16_t, bool);
-    int  invert_array_pin(uint16_t);
-    int  read_array_pin(uint16_t);
+    SIPO8_result set_array_pin(SIPO8_pin, bool);
+    int  invert_array_pin(SIPO8_pin);
+    int  read_array_pin(SIPO8_pin);
+    SIPO8_result set_array_range(SIPO8_pin, SIPO8_pin, bool);
+    SIPO8_result invert_array_range(SIPO8_pin, SIPO8_pin);
+    SIPO8_result copy_array_range(SIPO8_pin, SIPO8_pin, SIPO8_pin);
 
-    void set_banks(uint8_t, uint8_t, bool);
+    void set_banks(SIPO8_index, SIPO8_index, bool);
     void set_banks(bool);
-    void set_bank(uint8_t, bool);
+    void set_bank(SIPO8_index, bool);
     void invert_banks();
-    void invert_banks(uint8_t, uint8_t);
-    void invert_bank(uint8_t);
+    void invert_banks(SIPO8_index, SIPO8_index);
+    void invert_bank(SIPO8_index);
+
+    SIPO8_result set_bank_SIPO(SIPO8_index, SIPO8_index, uint8_t);
+    SIPO8_result invert_bank_SIPO(SIPO8_index, SIPO8_index);
+    int  read_bank_SIPO(SIPO8_index, SIPO8_index);
+    SIPO8_result set_array_SIPO(SIPO8_index, uint8_t);
+    SIPO8_result invert_array_SIPO(SIPO8_index, uint8_t);
+    int  read_array_SIPO(SIPO8_index);
+
+    int  read_committed_array_pin(SIPO8_pin);
+    int  read_committed_bank_pin(SIPO8_index, SIPO8_pin);
+    int  read_committed_bank_SIPO(SIPO8_index, SIPO8_index);
+
+    SIPO8_result set_bank_pin(SIPO8_index, SIPO8_pin, bool);
+    int  invert_bank_pin(SIPO8_index, SIPO8_pin);
+    int  read_bank_pin(SIPO8_index, SIPO8_pin);
+
+    uint16_t submit_batch(const batch_command *, uint16_t);
+    uint16_t xfer_batch(const batch_command *, uint16_t, bool);
+
+    // Fixed layout pin functions - the pin is a SIPO8_layout<...>::pin<bank, pin>
+    // handle whose status byte and bit mask are resolved at compile time, so these
+    // reduce to a direct update of the status byte with no run time checks.
+    template <class Pin> void set_pin(Pin, bool pin_status) {
+      if (pin_status) {
+        pin_status_bytes[Pin::status_byte] |= Pin::bit_mask;
+      } else {
+        pin_status_bytes[Pin::status_byte] &= (uint8_t)~Pin::bit_mask;
+      }
+      _dirty_bytes[Pin::status_byte / 8] |= 1 << (Pin::status_byte % 8);
+    }
+    template <class Pin> bool invert_pin(Pin) {
+      pin_status_bytes[Pin::status_byte] ^= Pin::bit_mask;
+      _dirty_bytes[Pin::status_byte / 8] |= 1 << (Pin::status_byte % 8);
+      return pin_status_bytes[Pin::status_byte] & Pin::bit_mask;
+    }
+    template <class Pin> bool read_pin(Pin) {
+      return pin_status_bytes[Pin::status_byte] & Pin::bit_mask;
+    }
 
-    int  set_bank_SIPO(uint8_t, uint8_t, uint8_t);
-    int  invert_bank_SIPO(uint8_t, uint8_t);
-    int  read_bank_SIPO(uint8_t, uint8_t);
+    SIPO8_result get_bank_from_pin(SIPO8_pin);
+    SIPO8_result num_pins_in_bank(SIPO8_index);
+    SIPO8_result get_bank_group(SIPO8_index);
 
-    int  set_bank_pin(uint8_t, uint8_t, bool);
-    int  invert_bank_pin(uint8_t, uint8_t);
-    int  read_bank_pin(uint8_t, uint8_t);
+    SIPO8_result create_input_bank(uint8_t, uint8_t, uint8_t, SIPO8_index);
+    void scan_inputs();
+    void use_debounce(bool);
+    int  read_input_pin(SIPO8_pin);
+    int  read_input_bank_pin(SIPO8_index, SIPO8_pin);
+    int  read_input_bank_PISO(SIPO8_index, SIPO8_index);
+    int  read_input_changes(SIPO8_index, SIPO8_index);
+    bool inputs_changed();
 
-    int  get_bank_from_pin(uint16_t);
-    int  num_pins_in_bank(uint8_t);
+    bool set_bank_loopback(SIPO8_index, uint8_t);
+    int  verify_bank(SIPO8_index, chain_report &);
+    SIPO8_result spot_check(uint16_t);
 
-    void xfer_banks(uint8_t, uint8_t, bool);
+    void xfer_banks(SIPO8_index, SIPO8_index, bool);
     void xfer_banks(bool);
-    void xfer_bank(uint8_t, bool);
+    void xfer_bank(SIPO8_index, bool);
     void xfer_array(bool);
+    void xfer_dirty(bool);
+    bool bank_is_dirty(SIPO8_index);
+    void commit_banks(bool);
+    bool xfer_begin(SIPO8_index, SIPO8_index, bool);
+    bool xfer_begin(bool);
+    bool xfer_step(uint16_t);
+    void use_fast_io(bool);
+    bool use_bank_map();
+
+    void begin_frame();
+    void end_frame();
+
+    bool start_refresh(bool, uint8_t);
+    void stop_refresh();
+    void refresh_frame();
+    void refresh_tick();
+
+    bool start_bcm(uint8_t, bool);
+    void stop_bcm();
+    SIPO8_result set_pin_brightness(SIPO8_pin, uint8_t);
+    int  read_pin_brightness(SIPO8_pin);
+    void set_all_brightness(uint8_t);
+    void bcm_frame();
+    void bcm_tick();
 
     void print_pin_statuses();
     void print_SIPO_data();
+#if SIPO8_STATS
+    void   read_stats(stats_snapshot &);
+    void   clear_stats();
+    size_t dump_stats(Stream &);
+#endif
 
     void SIPO8_start_timer(uint8_t);
     void SIPO8_stop_timer(uint8_t);
     bool SIPO8_timer_elapsed(uint8_t, uint32_t);
 
+    bool SIPO8_schedule_timer(uint8_t, uint32_t, bool, timer_callback);
+    bool SIPO8_schedule_invert_pin(uint8_t, uint32_t, bool, SIPO8_pin);
+    bool SIPO8_schedule_invert_bank_pin(uint8_t, uint32_t, bool, SIPO8_index, SIPO8_pin);
+    bool SIPO8_schedule_invert_bank(uint8_t, uint32_t, bool, SIPO8_index);
+    uint8_t SIPO8_service();
+
+    // ****** protected declarations.....
+  protected:
+    // working storage for the SIPO8 object, used when this is provided by
+    // SIPO8Static rather than allocated from the heap
+    struct storage_control {
+      SIPO_control  * banks;
+      uint8_t       * status_bytes;
+      uint8_t       * committed_bytes;
+      uint8_t       * frame_bytes;
+      uint8_t       * dirty_bytes;
+      timer_control * timers;
+      uint8_t       * timer_heap;
+      uint8_t       * refresh_buffers[2];  // may be NULL, start_refresh then allocates
+      SIPO8_index   * bank_map;            // may be NULL, use_bank_map then allocates
+    };
+
+    SIPO8(SIPO8_index, SIPO8_index, uint8_t, const storage_control &);
+
     // ****** private declarations.....
   private:
-    uint16_t _max_pins             = 0;
-    uint16_t _num_active_pins      = 0;
-    uint8_t  _num_pin_status_bytes = 0;
-    uint8_t  _max_SIPOs            = 0;
-    uint8_t  _bank_SIPO_count      = 0;
-    uint8_t  _next_bank            = 0;
+    SIPO8_pin   _max_pins             = 0;
+    SIPO8_pin   _num_active_pins      = 0;
+    SIPO8_index _num_pin_status_bytes = 0;
+    SIPO8_index _max_SIPOs            = 0;
+    SIPO8_index _max_banks            = 0;
+    SIPO8_index _bank_SIPO_count      = 0;
+    SIPO8_index _next_bank            = 0;
     uint8_t  _max_timers           = 0;
+    bool     _fast_io              = true;
+    SIPO8_index _num_dirty_bytes      = 0;
+    uint8_t * _dirty_bytes;        // 1 bit per pin status byte, set if changed since last transfer
+    uint8_t * _frame_bytes;        // front buffer, last complete frame whilst building a frame
+    volatile bool _in_frame        = false; // true between begin_frame and end_frame
+    uint8_t * _refresh_buffers[2]  = {NULL, NULL}; // background refresh front/back frames
+    SIPO8_index * _bank_map        = NULL; // bank of each pin status byte, if in use
+    uint8_t * _timer_heap;         // scheduled timers, a min-heap ordered by expiry time
+    uint8_t  _num_scheduled        = 0;
+    volatile uint8_t _refresh_front   = 0;         // index of the front (shown) frame
+    volatile bool    _refresh_pending = false;     // true if the back frame holds a new frame
+    volatile bool    _refresh_active  = false;
+    bool     _refresh_order        = MSBFIRST;
+    uint8_t  _refresh_unit         = refresh_by_SIPO;
+    SIPO8_index _refresh_bank      = 0;  // refresh cursor - bank and SIPO within bank
+    SIPO8_index _refresh_SIPO      = 0;
+    bool     _xfer_active          = false; // chunked transfer, see xfer_begin...
+    bool     _xfer_order           = MSBFIRST;
+    SIPO8_index _xfer_from_bank    = 0;  // ...its banks...
+    SIPO8_index _xfer_to_bank      = 0;
+    SIPO8_index _xfer_bank         = 0;  // ...and cursor - bank, SIPO of its group and bit
+    SIPO8_index _xfer_SIPO         = 0;
+    uint8_t  _xfer_bit             = 0;
+    static const uint16_t _test_seed = 0xACE1; // chain test bit sequence start, see verify_bank
+    SIPO8_index _spot_bank         = 0;  // spot check, see spot_check - bank being checked...
+    SIPO8_pin   _spot_bits         = 0;  // ...test bits shifted into it since its check started...
+    uint16_t _spot_in              = _test_seed; // ...and test bit sequences, of the bits shifted in...
+    uint16_t _spot_out             = _test_seed; // ...and of those due to be read back
+    uint8_t * _bcm_levels          = NULL; // brightness level of each pin
+    uint8_t * _bcm_planes[2]       = {NULL, NULL}; // front/back bit planes, plane k at k * max_SIPOs
+    uint8_t  _bcm_bits             = 0;  // brightness bits (planes) in use
+    uint8_t  _bcm_planes_allocated = 0;  // planes the plane buffers have room for
+    volatile uint8_t _bcm_front    = 0;
+    volatile bool    _bcm_pending  = false;
+    volatile bool    _bcm_active   = false;
+    bool     _bcm_order            = MSBFIRST;
+    uint8_t  _bcm_plane            = 0;  // next plane to be shown
+    uint8_t  _bcm_ticks_left       = 0;  // ticks until the next plane is shown
+    SIPO8_index _num_input_banks   = 0;
+    SIPO8_index _num_input_bytes   = 0;  // one per PISO
+    uint8_t * _input_samples       = NULL; // each input byte as last shifted in
+    uint8_t * _input_count0        = NULL; // debounce vertical counters, bit 0...
+    uint8_t * _input_count1        = NULL; // ...and bit 1, of each input pin
+    uint8_t * _input_changes       = NULL; // input pins changed, not yet read
+    bool     _debounce             = true;
+    bool     _inputs_seeded        = false; // false until a scan after a bank is created
+#if SIPO8_STATS
+    stats_snapshot _stats          = {};
+#endif
 
+    void initialise(SIPO8_index, SIPO8_index, uint8_t);
+    SIPO8_result add_bank(uint8_t, uint8_t, uint8_t, SIPO8_index, uint8_t, uint8_t, const uint8_t *);
+    const uint8_t * build_wiring_table(const uint8_t *);
+    void join_bank_group(SIPO8_index);
+    void map_bank(SIPO8_index);
+    bool group_is_dirty(SIPO8_index);
+    void xfer_group(SIPO8_index, const uint8_t *, bool);
+    void xfer_group_bytes(SIPO8_index, const uint8_t *, bool);
+    void shift_out_group_SIPO(SIPO8_index, SIPO8_index, const uint8_t *, bool, uint8_t, uint8_t);
+    void record_group(SIPO8_index, const uint8_t *);
+    void commit_group_SIPO(SIPO8_index, SIPO8_index, const uint8_t *, bool);
     void SIPO_lib_exit(uint8_t);
-    void shift_out_bank(uint8_t, uint8_t, uint8_t, bool);
+    const uint8_t * xfer_source();
+    SIPO8_index bank_status_byte(SIPO8_index, SIPO8_index, bool);
+    bool bank_xfer_order(SIPO8_index, bool);
+    uint8_t bank_out_bits(SIPO8_index, SIPO8_index, const uint8_t *, bool);
+    void record_committed(SIPO8_index, const uint8_t *);
+    void begin_bank_xfer(SIPO8_index, bool);
+    void end_bank_xfer(SIPO8_index);
+#if SIPO8_SPI
+    void begin_SPI_xfer(SIPO8_index);
+    void end_SPI_xfer(SIPO8_index);
+#endif
+    void latch_bank(SIPO8_index, bool);
+    void shift_out_SIPO(SIPO8_index, uint8_t, uint8_t);
+    void shift_out_bank(uint8_t, uint8_t, uint8_t, uint8_t);
+    void fill_status_bytes(SIPO8_index, SIPO8_pin, bool);
+    void invert_status_bytes(SIPO8_index, SIPO8_pin);
+    void write_range_bits(SIPO8_pin, uint8_t, uint8_t);
+    void update_status_byte(SIPO8_index, uint8_t, uint8_t);
+    uint8_t read_range_bits(SIPO8_pin, uint8_t);
+    bool status_bytes_equal(const uint8_t *, const uint8_t *, SIPO8_pin);
+    void mark_dirty(SIPO8_index);
+    void mark_dirty(SIPO8_index, SIPO8_pin);
+    void clear_dirty(SIPO8_index, SIPO8_pin);
+#if SIPO8_STATS
+    void count_group_xfer(SIPO8_index);
+    void count_xfer_time(uint32_t);
+#endif
+#if SIPO8_FAST_IO
+    void shift_out_bank_fast(SIPO8_index, uint8_t, uint8_t);
+    void shift_out_group_fast(SIPO8_index, uint8_t);
+#endif
+    bool schedule_timer(uint8_t, uint32_t, bool, uint8_t);
+    void unschedule_timer(uint8_t);
+    bool timer_expires_before(uint8_t, uint8_t);
+    void timer_heap_place(uint8_t, uint8_t);
+    void timer_heap_up(uint8_t);
+    void timer_heap_down(uint8_t);
+    void build_bcm_planes(uint8_t *);
+    bool grow_input_bytes(uint8_t * &, SIPO8_pin);
+    void shift_in_bank(SIPO8_index);
+    void check_chain(SIPO8_index, chain_report &);
+    void shift_test_bit(SIPO8_index, bool);
+    void restore_group(SIPO8_index);
+    bool next_spot_bank();
+
+
+
+};
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Fixed bank layouts, declared at compile time.
+// For fixed wiring the banks may be declared as a type, for example:
+//   typedef SIPO8_layout<SIPO8_bank<8, 10, 9, 2>,   // bank 0 - data, clock, latch
+//                        SIPO8_bank<8, 10, 7, 1> >  // bank 1   pins, num SIPOs
+//           my_layout;
+//   typedef my_layout::pin<1, 5> alarm_LED;         // bank 1, pin 5
+// my_layout::create_banks(my_SIPOs) then creates the banks (they must be the first
+// banks created) after which my_SIPOs.set_pin(alarm_LED(), HIGH) etc. operate on
+// status bytes known at compile time. Out of range banks or pins fail to compile.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+template <uint8_t Data_pin, uint8_t Clock_pin, uint8_t Latch_pin, SIPO8_index Num_SIPOs>
+struct SIPO8_bank {
+  static_assert(Num_SIPOs > 0, "SIPO8_bank: a bank must have at least 1 SIPO");
+  static const uint8_t data_pin  = Data_pin;
+  static const uint8_t clock_pin = Clock_pin;
+  static const uint8_t latch_pin = Latch_pin;
+  static const SIPO8_index num_SIPOs = Num_SIPOs;
+};
+
+// finds the Bank'th bank of a layout and the first status byte it maps to
+template <uint8_t Bank, class... Banks> struct SIPO8_layout_bank;
 
+template <class First, class... Rest>
+struct SIPO8_layout_bank<0, First, Rest...> {
+  typedef First bank;
+  static const SIPO8_pin first_byte = 0;
+};
+
+template <uint8_t Bank, class First, class... Rest>
+struct SIPO8_layout_bank<Bank, First, Rest...> {
+  typedef typename SIPO8_layout_bank<Bank - 1, Rest...>::bank bank;
+  static const SIPO8_pin first_byte = First::num_SIPOs + SIPO8_layout_bank<Bank - 1, Rest...>::first_byte;
+};
+
+template <class... Banks>
+struct SIPO8_layout {
+  static_assert(sizeof...(Banks) > 0, "SIPO8_layout: at least 1 bank is required");
+  static const uint8_t num_banks = sizeof...(Banks);
 
+  template <uint8_t Bank, SIPO8_pin Pin>
+  struct pin {
+    static_assert(Bank < sizeof...(Banks), "SIPO8_layout::pin: bank not in layout");
+    typedef SIPO8_layout_bank<Bank, Banks...> layout_bank;
+    static_assert(Pin < layout_bank::bank::num_SIPOs * pins_per_SIPO,
+                  "SIPO8_layout::pin: pin not in bank");
+    static_assert(layout_bank::first_byte + Pin / pins_per_SIPO < SIPO8_max_index,
+                  "SIPO8_layout::pin: more SIPOs than SIPO8_INDEX_BITS allows");
+    static const SIPO8_index status_byte = layout_bank::first_byte + Pin / pins_per_SIPO;
+    static const uint8_t bit_mask    = 1 << (Pin % pins_per_SIPO);
+  };
 
+  // Creates the layout's banks, in order. Returns false if the SIPO8 object
+  // already has banks, or if any bank could not be created.
+  static bool create_banks(SIPO8 & SIPOs) {
+    if (SIPOs.num_banks != 0) return false;
+    // braced lists are evaluated in order, so banks are created in order
+    bool created[] = {
+      SIPOs.create_bank(Banks::data_pin, Banks::clock_pin,
+                        Banks::latch_pin, Banks::num_SIPOs) != create_bank_failure...
+    };
+    for (SIPO8_index bank = 0; bank < sizeof...(Banks); bank++) {
+      if (!created[bank]) return false;
+    }
+    return true;
+  }
+};
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// SIPO8Static - a SIPO8 whose working storage is sized at compile time and held
+// within the object itself, so no heap is used and RAM use shows in the linker
+// map. Declare as, for example:
+//   SIPO8Static<8, 2> my_SIPOs;       // 8 SIPOs, 2 timers, up to 8 banks
+//   SIPO8Static<8, 2, 3> my_SIPOs;    // 8 SIPOs, 2 timers, up to 3 banks
+// Setting With_refresh true also provides the background refresh buffers, else
+// these are allocated from the heap if start_refresh is used.
+// Likewise With_bank_map true provides the bank map (see use_bank_map), which is
+// then in use from the start.
+// All SIPO8 functions are available.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+template <SIPO8_index Max_SIPOs, uint8_t Max_timers, SIPO8_index Max_banks, bool With_refresh,
+          bool With_bank_map>
+struct SIPO8_static_storage {
+  SIPO8::SIPO_control  banks[Max_banks];
+  uint8_t              status_bytes[Max_SIPOs];
+  uint8_t              committed_bytes[Max_SIPOs];
+  uint8_t              frame_bytes[Max_SIPOs];
+  uint8_t              dirty_bytes[(Max_SIPOs + 7) / 8];
+  SIPO8::timer_control timers[Max_timers > 0 ? Max_timers : 1];
+  uint8_t              timer_heap[Max_timers > 0 ? Max_timers : 1];
+  uint8_t              refresh_bytes[With_refresh ? 2 * Max_SIPOs : 1];
+  SIPO8_index          bank_map_bytes[With_bank_map ? Max_SIPOs : 1];
+};
+
+template <SIPO8_index Max_SIPOs, uint8_t Max_timers, SIPO8_index Max_banks = Max_SIPOs,
+          bool With_refresh = false, bool With_bank_map = false>
+class SIPO8Static
+  : private SIPO8_static_storage<Max_SIPOs, Max_timers, Max_banks, With_refresh, With_bank_map>,
+    public SIPO8  // storage base is listed first so exists before SIPO8 is constructed
+{
+    static_assert(Max_SIPOs > 0, "SIPO8Static: Max_SIPOs must be at least 1");
+    static_assert(Max_banks > 0 && Max_banks <= Max_SIPOs,
+                  "SIPO8Static: Max_banks must be from 1 to Max_SIPOs");
+
+    typedef SIPO8_static_storage<Max_SIPOs, Max_timers, Max_banks, With_refresh, With_bank_map> storage;
+
+    // static, as a member function may not be called before SIPO8 is constructed
+    static storage_control storage_pointers(storage & store) {
+      storage_control pointers;
+      pointers.banks              = store.banks;
+      pointers.status_bytes       = store.status_bytes;
+      pointers.committed_bytes    = store.committed_bytes;
+      pointers.frame_bytes        = store.frame_bytes;
+      pointers.dirty_bytes        = store.dirty_bytes;
+      pointers.timers             = store.timers;
+      pointers.timer_heap         = store.timer_heap;
+      pointers.refresh_buffers[0] = With_refresh ? &store.refresh_bytes[0] : NULL;
+      pointers.refresh_buffers[1] = With_refresh ? &store.refresh_bytes[Max_SIPOs] : NULL;
+      pointers.bank_map           = With_bank_map ? store.bank_map_bytes : NULL;
+      return pointers;
+    }
+
+  public:
+    SIPO8Static()
+      : SIPO8(Max_SIPOs, Max_banks, Max_timers, storage_pointers(*static_cast<storage *>(this))) {}
 };
 
 #endif
\ No newline at end of file
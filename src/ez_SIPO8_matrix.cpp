@@ -0,0 +1,313 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Row multiplexed LED matrix and multi digit display driver for the SIPO8
+   library. One bank drives the matrix rows (or display digits) and a second
+   bank drives the columns (or segments). The rows are lit one at a time, in
+   turn, from a framebuffer.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+
+#include <Arduino.h>
+#include <ez_SIPO8_matrix.h>
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Lookup tables, held in flash.
+// Characters supported are space, '-', '.', ':', '0' - '9' and 'A' - 'Z' (lower
+// case letters are shown as upper case). Others are shown as a space.
+// The 5x7 font is glyph_height bytes per character, one per row from the top,
+// bit 0 being the leftmost column. The 7 segment codes are approximations for
+// those letters a 7 segment digit cannot show (K, M, V, W, X).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#define num_glyphs 40
+
+static const uint8_t glyph_rows[num_glyphs * glyph_height] PROGMEM = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // space
+  0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00,  // minus
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06,  // full stop
+  0x00, 0x06, 0x06, 0x00, 0x06, 0x06, 0x00,  // colon
+  0x0E, 0x11, 0x19, 0x15, 0x13, 0x11, 0x0E,  // 0
+  0x04, 0x06, 0x04, 0x04, 0x04, 0x04, 0x0E,  // 1
+  0x0E, 0x11, 0x10, 0x08, 0x04, 0x02, 0x1F,  // 2
+  0x1F, 0x08, 0x04, 0x08, 0x10, 0x11, 0x0E,  // 3
+  0x08, 0x0C, 0x0A, 0x09, 0x1F, 0x08, 0x08,  // 4
+  0x1F, 0x01, 0x0F, 0x10, 0x10, 0x11, 0x0E,  // 5
+  0x0C, 0x02, 0x01, 0x0F, 0x11, 0x11, 0x0E,  // 6
+  0x1F, 0x10, 0x08, 0x04, 0x02, 0x02, 0x02,  // 7
+  0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E,  // 8
+  0x0E, 0x11, 0x11, 0x1E, 0x10, 0x08, 0x06,  // 9
+  0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11,  // A
+  0x0F, 0x11, 0x11, 0x0F, 0x11, 0x11, 0x0F,  // B
+  0x0E, 0x11, 0x01, 0x01, 0x01, 0x11, 0x0E,  // C
+  0x07, 0x09, 0x11, 0x11, 0x11, 0x09, 0x07,  // D
+  0x1F, 0x01, 0x01, 0x0F, 0x01, 0x01, 0x1F,  // E
+  0x1F, 0x01, 0x01, 0x0F, 0x01, 0x01, 0x01,  // F
+  0x0E, 0x11, 0x01, 0x1D, 0x11, 0x11, 0x1E,  // G
+  0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11,  // H
+  0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E,  // I
+  0x1C, 0x08, 0x08, 0x08, 0x08, 0x09, 0x06,  // J
+  0x11, 0x09, 0x05, 0x03, 0x05, 0x09, 0x11,  // K
+  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x1F,  // L
+  0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11,  // M
+  0x11, 0x11, 0x13, 0x15, 0x19, 0x11, 0x11,  // N
+  0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E,  // O
+  0x0F, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x01,  // P
+  0x0E, 0x11, 0x11, 0x11, 0x15, 0x09, 0x16,  // Q
+  0x0F, 0x11, 0x11, 0x0F, 0x05, 0x09, 0x11,  // R
+  0x1E, 0x01, 0x01, 0x0E, 0x10, 0x10, 0x0F,  // S
+  0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,  // T
+  0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E,  // U
+  0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04,  // V
+  0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A,  // W
+  0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11,  // X
+  0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04,  // Y
+  0x1F, 0x10, 0x08, 0x04, 0x02, 0x01, 0x1F   // Z
+};
+
+static const uint8_t digit_segments[num_glyphs] PROGMEM = {
+  0x00, 0x40, 0x80, 0x00,                          // space - . :
+  0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,  // 0 - 7
+  0x7F, 0x6F,                                      // 8, 9
+  0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D, 0x76,  // A - H
+  0x30, 0x1E, 0x76, 0x38, 0x37, 0x54, 0x3F, 0x73,  // I - P
+  0x67, 0x50, 0x6D, 0x78, 0x3E, 0x1C, 0x2A, 0x76,  // Q - X
+  0x6E, 0x5B                                       // Y, Z
+};
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Constructor - the matrix is driven by the given SIPO8 object's row_bank and
+// column_bank, which must have been created before begin is called.
+// row_on_level is the level of a row pin selecting its row, and column_on_level
+// the level of a column pin lighting its LED in the selected row - for example
+// HIGH and LOW for common anode digits with their anodes driven directly.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SIPO8_matrix::SIPO8_matrix(SIPO8 & SIPOs, SIPO8_index row_bank, SIPO8_index column_bank,
+                           bool row_on_level, bool column_on_level) :
+  _SIPOs(SIPOs),
+  _row_bank(row_bank),
+  _column_bank(column_bank),
+  _row_on_level(row_on_level),
+  _column_on_level(column_on_level),
+  _order(MSBFIRST) {
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Multiplexed scanning.
+// Once begun, each call of scan_tick lights the next row of the matrix, cycling
+// through num_rows rows continuously. scan_tick is intended to be called at a
+// fixed rate from a timer interrupt service routine - each row is then lit for
+// the same time whatever it shows, and the cost of a call is the same for every
+// row: one transfer of the row and column banks if these are in the same bank
+// group (see create_bank), otherwise three.
+// For example 8 digits at a tick rate of 1kHz are each refreshed 125 times a
+// second, flicker free.
+// Between rows, the output is blanked to prevent ghosting - the row bank is first
+// transferred with all rows off, then the column bank with the next row's columns,
+// and then the row bank with the next row on. Banks in the same group are latched
+// together, with both the row and its columns changing at once, so need no blanking.
+// The rows are drawn in a framebuffer which is double buffered as for background
+// refresh - show copies the framebuffer to the back buffer and scan_tick swaps it
+// to the front only at the end of a complete pass through the rows.
+// Notes:
+// 1. the pins of the row and column banks belong to the matrix once begun, so
+//    should not be set or transferred otherwise
+// 2. scan_tick updates pin statuses, so if called from an ISR, xfer_dirty and
+//    commit_banks should not be used for other banks whilst scanning
+//
+// begin returns false if the banks are not valid, num_rows is 0 or more than the
+// row bank has pins, or if there is insufficient memory for the framebuffer.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_matrix::begin(uint8_t num_rows, bool msb_or_lsb) {
+  _scan_active = false;
+  SIPO8_result row_pins    = _SIPOs.num_pins_in_bank(_row_bank);
+  SIPO8_result column_pins = _SIPOs.num_pins_in_bank(_column_bank);
+  if (row_pins == bank_not_found || column_pins == bank_not_found ||
+      _row_bank == _column_bank || num_rows == 0 || num_rows > row_pins) {
+    return false;
+  }
+  uint8_t column_bytes = column_pins / pins_per_SIPO;
+  if (num_rows != _num_rows || column_bytes != _column_bytes) {
+    // (re)size the framebuffer and scan buffers
+    free(_framebuffer);
+    free(_scan_buffers[0]);
+    free(_scan_buffers[1]);
+    uint16_t num_bytes = num_rows * column_bytes;
+    _framebuffer     = (uint8_t *) malloc(sizeof(uint8_t) * num_bytes);
+    _scan_buffers[0] = (uint8_t *) malloc(sizeof(uint8_t) * num_bytes);
+    _scan_buffers[1] = (uint8_t *) malloc(sizeof(uint8_t) * num_bytes);
+    if (_framebuffer == NULL || _scan_buffers[0] == NULL || _scan_buffers[1] == NULL) {
+      _num_rows = 0;
+      return false;
+    }
+    _num_rows     = num_rows;
+    _column_bytes = column_bytes;
+  }
+  _grouped = _SIPOs.get_bank_group(_row_bank) == _SIPOs.get_bank_group(_column_bank);
+  _order   = msb_or_lsb;
+  clear();
+  memset(_scan_buffers[0], 0, _num_rows * _column_bytes);
+  _scan_front   = 0;
+  _scan_pending = false;
+  _scan_row     = 0;
+  _scan_active  = true;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Stops scanning and turns all rows off.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_matrix::end() {
+  if (_scan_active) {
+    _scan_active = false;
+    _SIPOs.set_bank(_row_bank, !_row_on_level);
+    _SIPOs.xfer_bank(_row_bank, _order);
+  }
+}
+
+uint8_t SIPO8_matrix::num_rows() {
+  return _num_rows;
+}
+
+uint16_t SIPO8_matrix::num_columns() {
+  return _column_bytes * pins_per_SIPO;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Framebuffer drawing functions. These change the framebuffer only, which is
+// shown from the next call of show.
+// Columns are numbered as the column bank's pins - column c of a row is bit c % 8
+// of the row's (c / 8)th column byte.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_matrix::clear() {
+  if (_num_rows > 0) {
+    memset(_framebuffer, 0, _num_rows * _column_bytes);
+  }
+}
+
+int SIPO8_matrix::set_pixel(uint8_t row, uint16_t column, bool pixel_on) {
+  if (row < _num_rows && column < num_columns()) {
+    uint8_t * column_byte = &_framebuffer[row * _column_bytes + column / pins_per_SIPO];
+    uint8_t   bit_mask    = 1 << (column % pins_per_SIPO);
+    if (pixel_on) {
+      *column_byte |= bit_mask;
+    } else {
+      *column_byte &= (uint8_t)~bit_mask;
+    }
+    return pixel_on;
+  }
+  return pin_set_failure;
+}
+
+int SIPO8_matrix::read_pixel(uint8_t row, uint16_t column) {
+  if (row < _num_rows && column < num_columns()) {
+    return (_framebuffer[row * _column_bytes + column / pins_per_SIPO] >> (column % pins_per_SIPO)) & 1;
+  }
+  return pin_read_failure;
+}
+
+// sets all 8 columns of the given column byte (SIPO of the column bank) of a row
+int SIPO8_matrix::set_row_byte(uint8_t row, uint8_t SIPO_num, uint8_t columns) {
+  if (row < _num_rows && SIPO_num < _column_bytes) {
+    _framebuffer[row * _column_bytes + SIPO_num] = columns;
+    return columns;
+  }
+  return pin_set_failure;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Multi digit 7 segment displays - each row is a digit, and the first column byte
+// of the row its segments, segment_a to segment_g and segment_dp being bits 0 to 7.
+// print_digit shows the given character, and a decimal point if dp is true.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8_matrix::set_digit(uint8_t digit, uint8_t segments) {
+  return set_row_byte(digit, 0, segments);
+}
+
+int SIPO8_matrix::print_digit(uint8_t digit, char character, bool dp) {
+  return set_digit(digit, segments_for(character) | (dp ? segment_dp : 0));
+}
+
+// returns the 7 segment code for the given character
+uint8_t SIPO8_matrix::segments_for(char character) {
+  return pgm_read_byte(&digit_segments[glyph_index(character)]);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Draws the given character in the 5x7 font with its leftmost column at the given
+// column, from the top row down. Parts of the glyph beyond the matrix are clipped.
+// Returns the column for the next character, glyph_spacing columns on, so text may
+// be drawn with repeated calls.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+int SIPO8_matrix::draw_glyph(uint16_t column, char character) {
+  if (column >= num_columns()) return pin_set_failure;
+  const uint8_t * glyph = &glyph_rows[glyph_index(character) * glyph_height];
+  uint8_t rows = _num_rows < glyph_height ? _num_rows : glyph_height;
+  for (uint8_t row = 0; row < rows; row++) {
+    uint8_t glyph_row = pgm_read_byte(&glyph[row]);
+    for (uint8_t bit = 0; bit < glyph_width; bit++) {
+      set_pixel(row, column + bit, (glyph_row >> bit) & 1);  // clipped by set_pixel
+    }
+  }
+  return column + glyph_spacing;
+}
+
+// index of the given character in the lookup tables
+int8_t SIPO8_matrix::glyph_index(char character) {
+  if (character >= 'a' && character <= 'z') character = character - 'a' + 'A';
+  if (character >= 'A' && character <= 'Z') return character - 'A' + 14;
+  if (character >= '0' && character <= '9') return character - '0' + 4;
+  if (character == '-') return 1;
+  if (character == '.') return 2;
+  if (character == ':') return 3;
+  return 0;  // space, and characters not supported
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Posts the framebuffer as the next frame to be scanned. It is shown from the start
+// of the next complete pass through the rows.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_matrix::show() {
+  if (_scan_active) {
+    _scan_pending = false; // stops scan_tick swapping buffers while back is filled
+    memcpy(_scan_buffers[!_scan_front], _framebuffer, _num_rows * _column_bytes);
+    _scan_pending = true;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Lights the next row of the scanned frame, see begin.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_matrix::scan_tick() {
+  if (!_scan_active) return;
+  if (!_grouped) {
+    // blank - all rows off before the columns change
+    _SIPOs.set_bank(_row_bank, !_row_on_level);
+    _SIPOs.xfer_bank(_row_bank, _order);
+  }
+  const uint8_t * columns = &_scan_buffers[_scan_front][_scan_row * _column_bytes];
+  for (uint8_t SIPO = 0; SIPO < _column_bytes; SIPO++) {
+    _SIPOs.set_bank_SIPO(_column_bank, SIPO, _column_on_level ? columns[SIPO] : ~columns[SIPO]);
+  }
+  _SIPOs.set_bank(_row_bank, !_row_on_level);
+  _SIPOs.set_bank_pin(_row_bank, _scan_row, _row_on_level);
+  if (!_grouped) {
+    _SIPOs.xfer_bank(_column_bank, _order);
+  }
+  _SIPOs.xfer_bank(_row_bank, _order); // and the column bank, if grouped
+  _scan_row++;
+  if (_scan_row >= _num_rows) {
+    // end of a complete pass, the frame boundary - show the next frame if posted
+    _scan_row = 0;
+    if (_scan_pending) {
+      _scan_front   = !_scan_front;
+      _scan_pending = false;
+    }
+    num_scan_frames++;
+  }
+}
@@ -0,0 +1,87 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Row multiplexed LED matrix and multi digit display driver for the SIPO8
+   library. One bank drives the matrix rows (or display digits) and a second
+   bank drives the columns (or segments). The rows are lit one at a time, in
+   turn, from a framebuffer.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_matrix_h
+#define SIPO8_matrix_h
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+
+class SIPO8_matrix
+{
+  public:
+
+    // font macros...
+#define glyph_width          5 // columns of a glyph, bit 0 leftmost
+#define glyph_height         7 // rows of a glyph, row 0 top
+#define glyph_spacing        6 // columns from one draw_glyph character to the next
+
+    // 7 segment macros - segment bit of a digit's column byte...
+#define segment_a   0b00000001
+#define segment_b   0b00000010
+#define segment_c   0b00000100
+#define segment_d   0b00001000
+#define segment_e   0b00010000
+#define segment_f   0b00100000
+#define segment_g   0b01000000
+#define segment_dp  0b10000000
+
+    volatile uint32_t num_scan_frames = 0; // complete passes through the rows
+
+    // ******* function declarations....
+
+    SIPO8_matrix(SIPO8 &, SIPO8_index, SIPO8_index, bool = HIGH, bool = HIGH);
+
+    bool begin(uint8_t, bool);
+    void end();
+
+    uint8_t  num_rows();
+    uint16_t num_columns();
+
+    void clear();
+    int  set_pixel(uint8_t, uint16_t, bool);
+    int  read_pixel(uint8_t, uint16_t);
+    int  set_row_byte(uint8_t, uint8_t, uint8_t);
+    int  set_digit(uint8_t, uint8_t);
+    int  print_digit(uint8_t, char, bool);
+    int  draw_glyph(uint16_t, char);
+
+    void show();
+    void scan_tick();
+
+    static uint8_t segments_for(char);
+
+    // ****** private declarations.....
+  private:
+    SIPO8 & _SIPOs;
+    SIPO8_index _row_bank;
+    SIPO8_index _column_bank;
+    bool     _row_on_level;
+    bool     _column_on_level;
+    uint8_t  _num_rows            = 0;
+    uint8_t  _column_bytes        = 0; // column bank SIPOs, bytes per framebuffer row
+    bool     _grouped             = false; // row and column banks transfer together
+    bool     _order;
+    uint8_t * _framebuffer        = NULL; // drawn by the set_/draw_ functions
+    uint8_t * _scan_buffers[2]    = {NULL, NULL}; // front scanned, back filled by show
+    volatile uint8_t _scan_front   = 0;
+    volatile bool    _scan_pending = false;
+    volatile bool    _scan_active  = false;
+    uint8_t  _scan_row            = 0;
+
+    static int8_t glyph_index(char);
+};
+
+#endif
@@ -0,0 +1,278 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Pattern player for the SIPO8 library. Plays a sequence of pin status frames,
+   each shown for its own duration, streamed from flash (PROGMEM) or RAM straight
+   into the SIPO8 pin status bytes, one frame at a time.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+
+#include <Arduino.h>
+#include <ez_SIPO8_pattern.h>
+
+SIPO8_player::SIPO8_player(SIPO8 & SIPOs) :
+  _SIPOs(SIPOs) {
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Pattern playback.
+// Starts playing the given pattern (see ez_SIPO8_pattern.h for the format) into
+// the pin status bytes from first_byte, shown by update. The pattern is read in
+// place, a frame at a time as it is due, so only the frame being decoded is ever
+// read and no RAM is needed for the pattern itself.
+// in_flash is pattern_in_flash for a PROGMEM pattern, else pattern_in_RAM.
+// repeat is play_repeat to play the pattern continuously, else play_once.
+// msb_or_lsb is the direction of the transfers made by update.
+// Notes:
+// 1. on AVR boards a PROGMEM pattern must lie within the first 64K bytes of flash
+// 2. the pattern's status bytes belong to the player whilst playing, so should
+//    not be set otherwise
+//
+// play returns false if the pattern's version is not supported, if its first
+// frame is not a full frame, or if its frames extend beyond the active pins of the
+// SIPO8 object.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_player::play(const uint8_t * pattern, bool in_flash, bool repeat, bool msb_or_lsb,
+                        SIPO8_index first_byte) {
+  _playing = false;
+  uint8_t  version    = read_pattern_byte(&pattern[0], in_flash);
+  uint8_t  num_bytes  = read_pattern_byte(&pattern[1], in_flash);
+  uint16_t num_frames = read_pattern_byte(&pattern[2], in_flash) |
+                        read_pattern_byte(&pattern[3], in_flash) << 8;
+  if (version != pattern_version || num_bytes == 0 || num_frames == 0 ||
+      read_pattern_byte(&pattern[pattern_header_size], in_flash) != pattern_full_frame ||
+      first_byte >= _SIPOs.bank_SIPO_count || num_bytes > _SIPOs.bank_SIPO_count - first_byte) {
+    return false;
+  }
+  _pattern    = pattern;
+  _next       = &pattern[pattern_header_size];
+  _in_flash   = in_flash;
+  _repeat     = repeat;
+  _order      = msb_or_lsb;
+  _first_byte = first_byte;
+  _num_bytes  = num_bytes;
+  _num_frames = num_frames;
+  _frame      = 0;
+  _shown      = false;
+  _playing    = true;
+  return true;
+}
+
+void SIPO8_player::stop() {
+  _playing = false;
+}
+
+// returns true until a play_once pattern has shown its last frame for its duration
+bool SIPO8_player::playing() {
+  return _playing;
+}
+
+// number of the frame being shown, 0 being the first frame of the pattern
+uint16_t SIPO8_player::frame_number() {
+  return _frame > 0 ? _frame - 1 : 0;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// To be called regularly from loop(). When the frame being shown has been shown
+// for its duration, decodes the next frame into the pin status bytes and transfers
+// the banks changed (xfer_dirty), returning true, otherwise returns false.
+// Frames are timed from when each was due, not when update was called, so the
+// pattern does not drift however often update is called.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_player::update() {
+  if (!_playing) return false;
+  uint32_t now = SIPO8_millis();
+  if (_shown && now - _frame_start < _duration) return false;
+  uint32_t due = _shown ? _frame_start + _duration : now;
+  if (!next_frame()) return false;
+  _frame_start = due;
+  _shown = true;
+  _SIPOs.xfer_dirty(_order);
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Decodes the next frame of the pattern into the pin status bytes, without regard
+// to its timing and without a transfer - for use where the pin statuses are shown
+// by other means, eg background refresh. Returns false if there is no next frame,
+// when a play_once pattern has ended.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_player::next_frame() {
+  if (!_playing) return false;
+  if (_frame == _num_frames) {
+    if (!_repeat) {
+      _playing = false;
+      return false;
+    }
+    _next  = &_pattern[pattern_header_size];
+    _frame = 0;
+  }
+  decode_frame();
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Moves playback to the given frame, 0 being the first frame of the pattern, which
+// update then shows at once. The frames before it are decoded from the last key
+// (full) frame at or before it, the frames from the start of the pattern to there
+// being stepped over without being decoded.
+// Returns false if not playing or if the pattern has no such frame.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_player::seek_frame(uint16_t frame) {
+  if (!_playing || frame >= _num_frames) return false;
+  const uint8_t * next      = &_pattern[pattern_header_size];
+  const uint8_t * key_frame = next;
+  uint16_t key_frame_number = 0;
+  for (uint16_t frame_number = 1; frame_number <= frame; frame_number++) {
+    next = next + frame_length(next, _in_flash, _num_bytes, 0xFFFFFFFF);
+    if (read_byte(next) == pattern_full_frame) {
+      key_frame        = next;
+      key_frame_number = frame_number;
+    }
+  }
+  _next  = key_frame;
+  _frame = key_frame_number;
+  while (_frame < frame) {
+    decode_frame();
+  }
+  _shown = false;
+  return true;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Decodes the frame at _next into the pin status bytes. Delta and XOR frames are
+// applied in place, so only the status bytes they change are written, and only
+// their banks marked for transfer by xfer_dirty.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_player::decode_frame() {
+  uint8_t frame_type = read_byte(_next);
+  _duration = read_uint16(_next + 1);
+  _next     = _next + 3;
+  if (frame_type == pattern_full_frame) {
+    for (uint8_t status_byte = 0; status_byte < _num_bytes; status_byte++) {
+      _SIPOs.set_array_SIPO(_first_byte + status_byte, read_byte(_next++));
+    }
+  } else if (frame_type == pattern_delta_frame) {
+    uint8_t count = read_byte(_next++);
+    while (count > 0) {
+      uint8_t status_byte = read_byte(_next++);
+      uint8_t value       = read_byte(_next++);
+      if (status_byte < _num_bytes) {
+        _SIPOs.set_array_SIPO(_first_byte + status_byte, value);
+      }
+      count--;
+    }
+  } else {
+    uint16_t status_byte = 0;
+    while (status_byte < _num_bytes) {
+      uint8_t run = read_byte(_next++);
+      uint8_t run_type = run & pattern_run_type_mask;
+      if (run_type == pattern_run_end) break;
+      uint8_t run_length = (run & ~pattern_run_type_mask) + 1;
+      if (status_byte + run_length > _num_bytes) {
+        run_length = _num_bytes - status_byte;  // not a valid pattern, keep to its bytes
+      }
+      if (run_type == pattern_run_repeat) {
+        uint8_t invert_mask = read_byte(_next++);
+        for (uint8_t run_byte = 0; run_byte < run_length; run_byte++) {
+          _SIPOs.invert_array_SIPO(_first_byte + status_byte + run_byte, invert_mask);
+        }
+      } else if (run_type == pattern_run_literal) {
+        for (uint8_t run_byte = 0; run_byte < run_length; run_byte++) {
+          _SIPOs.invert_array_SIPO(_first_byte + status_byte + run_byte, read_byte(_next++));
+        }
+      }
+      status_byte = status_byte + run_length;
+    }
+  }
+  _frame++;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the length in bytes of the given pattern, header included, or 0 if it is
+// not a valid pattern or is longer than max_length - for checking a pattern loaded
+// from a file, for example, before it is played.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint32_t SIPO8_player::pattern_length(const uint8_t * pattern, bool in_flash, uint32_t max_length) {
+  if (max_length < pattern_header_size ||
+      read_pattern_byte(&pattern[0], in_flash) != pattern_version) {
+    return 0;
+  }
+  uint8_t  num_bytes  = read_pattern_byte(&pattern[1], in_flash);
+  uint16_t num_frames = read_pattern_byte(&pattern[2], in_flash) |
+                        read_pattern_byte(&pattern[3], in_flash) << 8;
+  if (num_bytes == 0 || num_frames == 0) return 0;
+  uint32_t length = pattern_header_size;
+  for (uint16_t frame = 0; frame < num_frames; frame++) {
+    if (length >= max_length ||
+        (frame == 0 && read_pattern_byte(&pattern[length], in_flash) != pattern_full_frame)) {
+      return 0;
+    }
+    uint32_t frame_bytes = frame_length(&pattern[length], in_flash, num_bytes, max_length - length);
+    if (frame_bytes == 0) return 0;
+    length = length + frame_bytes;
+  }
+  return length;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the length in bytes of the given frame of a pattern of num_bytes status
+// bytes per frame, or 0 if it is not a valid frame or is longer than max_length.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint32_t SIPO8_player::frame_length(const uint8_t * frame, bool in_flash, uint8_t num_bytes,
+                                    uint32_t max_length) {
+  if (max_length < 4) return 0;  // frame type, duration and at least 1 byte
+  uint8_t  frame_type = read_pattern_byte(&frame[0], in_flash);
+  uint32_t length = 3;
+  if (frame_type == pattern_full_frame) {
+    length = length + num_bytes;
+  } else if (frame_type == pattern_delta_frame) {
+    uint8_t count = read_pattern_byte(&frame[length], in_flash);
+    if (length + 1 + count * 2 > max_length) return 0;
+    for (uint8_t pair = 0; pair < count; pair++) {
+      if (read_pattern_byte(&frame[length + 1 + pair * 2], in_flash) >= num_bytes) return 0;
+    }
+    length = length + 1 + count * 2;
+  } else if (frame_type == pattern_xor_frame) {
+    uint16_t status_byte = 0;
+    while (status_byte < num_bytes) {
+      if (length >= max_length) return 0;
+      uint8_t run = read_pattern_byte(&frame[length++], in_flash);
+      uint8_t run_type = run & pattern_run_type_mask;
+      if (run_type == pattern_run_end) break;
+      uint8_t run_length = (run & ~pattern_run_type_mask) + 1;
+      if (status_byte + run_length > num_bytes) return 0;
+      if (run_type == pattern_run_repeat) {
+        length = length + 1;
+      } else if (run_type == pattern_run_literal) {
+        length = length + run_length;
+      }
+      status_byte = status_byte + run_length;
+    }
+  } else {
+    return 0;
+  }
+  if (length > max_length) return 0;
+  return length;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Pattern reads, from flash or RAM.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t SIPO8_player::read_pattern_byte(const uint8_t * address, bool in_flash) {
+  return in_flash ? pgm_read_byte(address) : *address;
+}
+
+uint8_t SIPO8_player::read_byte(const uint8_t * address) {
+  return read_pattern_byte(address, _in_flash);
+}
+
+uint16_t SIPO8_player::read_uint16(const uint8_t * address) {
+  return read_byte(address) | read_byte(address + 1) << 8;
+}
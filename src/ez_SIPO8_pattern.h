@@ -0,0 +1,117 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Pattern player for the SIPO8 library. Plays a sequence of pin status frames,
+   each shown for its own duration, streamed from flash (PROGMEM) or RAM straight
+   into the SIPO8 pin status bytes, one frame at a time.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_pattern_h
+#define SIPO8_pattern_h
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Pattern format. All multi byte values are little endian.
+// Header, pattern_header_size bytes:
+//   version     1 byte  - pattern_version
+//   num_bytes   1 byte  - pin status bytes per frame (1-255), from the first_byte
+//                         given to play
+//   num_frames  2 bytes - number of frames (1-65535)
+// then num_frames frames, each:
+//   type        1 byte  - pattern_full_frame, pattern_delta_frame or pattern_xor_frame
+//   duration    2 bytes - milli seconds the frame is shown for
+//   full frame:  num_bytes pin status bytes
+//   delta frame: count 1 byte, then count pairs of (status byte, new value), the
+//                status byte relative to first_byte - the bytes that differ from
+//                the previous frame
+//   XOR frame:   the frame's status bytes XORed with the previous frame's, run
+//                length encoded as a sequence of runs from the first status byte,
+//                each a run byte, pattern_run(type, length) for a length of 1 to
+//                pattern_run_max, followed by:
+//                  pattern_run_skip    - nothing, the length bytes are unchanged
+//                  pattern_run_repeat  - 1 byte, XORed with each of the length bytes
+//                  pattern_run_literal - length bytes, XORed with the length bytes
+//                The frame ends when its runs reach num_bytes, or at a run byte of
+//                pattern_run_end, the remaining bytes being unchanged.
+// The first frame must be a full frame, as playback starts, and repeats, from it.
+// Full frames are also the key frames that seek_frame decodes from, so a pattern
+// for a large pin array will usually have one every so many frames, with XOR
+// frames between (see extras/host/SIPO8_pattern_codec.h for an encoder).
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#define pattern_version      1
+#define pattern_header_size  4
+#define pattern_full_frame   0
+#define pattern_delta_frame  1
+#define pattern_xor_frame    2
+
+// XOR frame runs...
+#define pattern_run_skip      0x00
+#define pattern_run_repeat    0x40
+#define pattern_run_literal   0x80
+#define pattern_run_end       0xC0
+#define pattern_run_type_mask 0xC0
+#define pattern_run_max       64
+
+// places an XOR frame run byte in a pattern array, eg pattern_run(pattern_run_skip, 10)
+#define pattern_run(type, length) (uint8_t)((type) | ((length) - 1))
+
+// play options...
+#define pattern_in_flash  true  // the pattern is a PROGMEM array
+#define pattern_in_RAM    false // the pattern is in RAM, eg a memory mapped file on a host
+#define play_once         false
+#define play_repeat       true
+
+// places a 16bit value in a pattern array, eg pattern_uint16(500)
+#define pattern_uint16(value) (uint8_t)((value) & 0xFF), (uint8_t)(((value) >> 8) & 0xFF)
+
+class SIPO8_player
+{
+  public:
+
+    // ******* function declarations....
+
+    SIPO8_player(SIPO8 &);
+
+    bool play(const uint8_t *, bool, bool, bool, SIPO8_index = 0);
+    void stop();
+    bool playing();
+    bool update();
+    bool next_frame();
+    bool seek_frame(uint16_t);
+    uint16_t frame_number();
+
+    static uint32_t pattern_length(const uint8_t *, bool, uint32_t = 0xFFFFFFFF);
+
+    // ****** private declarations.....
+  private:
+    SIPO8 & _SIPOs;
+    const uint8_t * _pattern   = NULL;
+    const uint8_t * _next      = NULL; // next frame to be decoded
+    bool     _in_flash         = true;
+    bool     _repeat           = true;
+    bool     _order            = MSBFIRST;
+    bool     _playing          = false;
+    bool     _shown            = false; // true once the first frame is shown
+    SIPO8_index _first_byte    = 0;
+    uint8_t  _num_bytes        = 0;
+    uint16_t _num_frames       = 0;
+    uint16_t _frame            = 0;     // frames decoded since the start of the pattern
+    uint32_t _frame_start      = 0;     // millis time the current frame was due
+    uint16_t _duration         = 0;     // of the current frame
+
+    void     decode_frame();
+    uint8_t  read_byte(const uint8_t *);
+    uint16_t read_uint16(const uint8_t *);
+    static uint32_t frame_length(const uint8_t *, bool, uint8_t, uint32_t);
+    static uint8_t  read_pattern_byte(const uint8_t *, bool);
+};
+
+#endif
@@ -0,0 +1,343 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Remote control of a SIPO8 object over a serial (or any Stream) link, by a
+   compact binary framed protocol - for driving SIPO arrays from a host PC. The
+   received bytes are kept in a ring buffer and parsed as they arrive, without
+   blocking, each frame being checked by CRC before it is acted on.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+
+#include <Arduino.h>
+#include <ez_SIPO8_remote.h>
+
+// a count as reported by remote_read_info, which has 2 bytes for each
+static uint16_t info_count(SIPO8_pin count) {
+  return count < 0xFFFF ? count : 0xFFFF;
+}
+
+// CRC-16/CCITT-FALSE, a byte at a time
+static const uint16_t crc_table[256] PROGMEM = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+  0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+  0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+  0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+  0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+  0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+  0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+  0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+  0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+  0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+  0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+  0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+  0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+  0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+  0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+  0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+  0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+  0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+  0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+  0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+  0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+  0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+  0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+  0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+  0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+  0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+  0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+  0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+  0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+  0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+SIPO8_remote::SIPO8_remote(SIPO8 & SIPOs, Stream & stream) :
+  _SIPOs(SIPOs),
+  _stream(stream) {
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Allocates a receive buffer of buffer_size bytes, which limits the longest frame
+// accepted - remote_frame_overhead + 255 bytes (261) allows every request. The
+// stream, eg Serial, must be begun separately.
+// Returns false if buffer_size is less than 16 bytes or cannot be allocated.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote::begin(uint16_t buffer_size) {
+  end();
+  if (buffer_size < 16) return false;
+  _buffer = (uint8_t *) malloc(buffer_size);
+  if (_buffer == NULL) return false;
+  _buffer_size = buffer_size;
+  return true;
+}
+
+void SIPO8_remote::end() {
+  free(_buffer);
+  _buffer      = NULL;
+  _buffer_size = 0;
+  _head        = 0;
+  _count       = 0;
+  _in_sequence = false;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// To be called regularly from loop(). Takes the bytes that have arrived, as far
+// as the receive buffer has room, then handles each complete frame received,
+// answering it. A frame only partly received is left for a later call, so update
+// never waits for input.
+// Returns the number of frames handled.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint16_t SIPO8_remote::update() {
+  if (_buffer == NULL) return 0;
+  uint16_t tail = _head + _count;
+  if (tail >= _buffer_size) tail = tail - _buffer_size;
+  while (_count < _buffer_size && _stream.available() > 0) {
+    _buffer[tail] = _stream.read();
+    _count++;
+    tail++;
+    if (tail == _buffer_size) tail = 0;
+  }
+  uint16_t frames = 0;
+  while (_count > 0) {
+    if (peek(0) != remote_sync) {
+      discard(1);
+      num_discarded++;
+      continue;
+    }
+    if (_count < remote_frame_overhead) break;
+    uint8_t length = peek(3);
+    if (length + remote_frame_overhead > _buffer_size) {
+      discard(1);  // longer than could ever be received, so not a frame
+      num_discarded++;
+      continue;
+    }
+    if (_count < length + remote_frame_overhead) break;  // the rest yet to arrive
+    if (!frame_valid(length)) {
+      discard(1);  // look for a frame from the next byte
+      num_crc_errors++;
+      continue;
+    }
+    handle_frame(peek(1), peek(2), length);
+    discard(length + remote_frame_overhead);
+    num_frames++;
+    frames++;
+  }
+  return frames;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Acts on the request frame at the head of the receive buffer and answers it.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_remote::handle_frame(uint8_t sequence, uint8_t command, uint8_t length) {
+  bool resent = false;
+  if (_in_sequence && sequence != _next_sequence && command != remote_read_info) {
+    uint8_t behind = _next_sequence - sequence;  // 1 for the request applied last
+    if (behind > remote_max_outstanding) return;  // ahead, a request before it was lost
+    if (command != remote_read_bytes) {
+      uint8_t entry = sequence % remote_max_outstanding;
+      respond(sequence, command, _sent_statuses[entry], &_sent_results[entry],
+              command == remote_batch && _sent_statuses[entry] == remote_ok ? 1 : 0);
+      return;
+    }
+    resent = true;  // read again, there is nothing to apply
+  }
+  uint8_t status = remote_ok;
+  uint8_t result = 0;           // remote_batch's commands applied
+  uint8_t info[12];             // remote_read_info's response
+  const uint8_t * data = NULL;  // response data, after the status
+  uint8_t data_length  = 0;
+  switch (command) {
+    case remote_write_bytes: {
+        SIPO8_pin first_byte = peek_offset(4);
+        if (length <= remote_offset_size) {
+          status = remote_bad_length;
+        } else if (first_byte + (SIPO8_pin)(length - remote_offset_size) >
+                   _SIPOs.bank_SIPO_count) {
+          status = remote_out_of_range;
+        } else {
+          for (uint8_t status_byte = 0; status_byte < length - remote_offset_size;
+               status_byte++) {
+            _SIPOs.set_array_SIPO(first_byte + status_byte,
+                                  peek(4 + remote_offset_size + status_byte));
+          }
+        }
+        break;
+      }
+    case remote_fill_banks:
+    case remote_invert_banks: {
+        SIPO8_pin from_bank = peek_offset(4);
+        SIPO8_pin to_bank   = peek_offset(4 + remote_offset_size);
+        if (length != 2 * remote_offset_size + (command == remote_fill_banks ? 1 : 0)) {
+          status = remote_bad_length;
+        } else if (from_bank > to_bank || to_bank >= _SIPOs.num_banks) {
+          status = remote_out_of_range;
+        } else if (command == remote_fill_banks) {
+          _SIPOs.set_banks(from_bank, to_bank, peek(4 + 2 * remote_offset_size) != LOW);
+        } else {
+          _SIPOs.invert_banks(from_bank, to_bank);
+        }
+        break;
+      }
+    case remote_xfer:
+      if (length != 2) {
+        status = remote_bad_length;
+      } else if (peek(5) == remote_xfer_dirty) {
+        _SIPOs.xfer_dirty(peek(4));
+      } else if (peek(5) == remote_xfer_array) {
+        _SIPOs.xfer_array(peek(4));
+      } else {
+        status = remote_out_of_range;
+      }
+      break;
+    case remote_read_bytes: {
+        uint8_t   source     = peek(4);
+        SIPO8_pin first_byte = peek_offset(5);
+        uint8_t   num_bytes  = peek(5 + remote_offset_size);
+        const uint8_t * bytes = NULL;
+        SIPO8_pin source_bytes = 0;
+        if (source == remote_pin_statuses) {
+          bytes        = _SIPOs.pin_status_bytes;
+          source_bytes = _SIPOs.bank_SIPO_count;
+        } else if (source == remote_committed_statuses) {
+          bytes        = _SIPOs.committed_status_bytes;
+          source_bytes = _SIPOs.bank_SIPO_count;
+        } else if (source == remote_input_statuses) {
+          bytes        = _SIPOs.input_status_bytes;
+          source_bytes = _SIPOs.num_input_pins / pins_per_SIPO;
+        }
+        if (length != 2 + remote_offset_size) {
+          status = remote_bad_length;
+        } else if (bytes == NULL || num_bytes == 0 || num_bytes > 254 ||
+                   first_byte + num_bytes > source_bytes) {
+          status = remote_out_of_range;
+        } else {
+          data        = &bytes[first_byte];
+          data_length = num_bytes;
+        }
+        break;
+      }
+    case remote_read_info:
+      if (length != 0) {
+        status = remote_bad_length;
+      } else {
+        const uint16_t counts[5] = {info_count(_SIPOs.num_banks),
+                                    info_count(_SIPOs.bank_SIPO_count),
+                                    info_count(_SIPOs.num_input_banks),
+                                    info_count(_SIPOs.num_input_pins / pins_per_SIPO),
+                                    _buffer_size};
+        info[0] = remote_protocol_version;
+        info[1] = remote_offset_size;
+        for (uint8_t count = 0; count < 5; count++) {
+          info[2 + 2 * count] = counts[count] & 0xFF;
+          info[3 + 2 * count] = counts[count] >> 8;
+        }
+        data        = info;
+        data_length = sizeof(info);
+      }
+      break;
+    case remote_batch: {
+        if (length % remote_batch_command_size != 0) {
+          status = remote_bad_length;
+          break;
+        }
+        // submitted a few commands at a time, to keep the stack small
+        SIPO8::batch_command commands[8];
+        uint8_t num_commands = length / remote_batch_command_size;
+        uint8_t offset = 4;
+        while (num_commands > 0) {
+          uint8_t chunk = num_commands < 8 ? num_commands : 8;
+          for (uint8_t command_num = 0; command_num < chunk; command_num++) {
+            commands[command_num].command_op    = peek(offset);
+            commands[command_num].command_bank  = peek_offset(offset + 1);
+            commands[command_num].command_index = peek(offset + 1 + remote_offset_size) |
+                                                  peek(offset + 2 + remote_offset_size) << 8;
+            commands[command_num].command_value = peek(offset + 3 + remote_offset_size);
+            offset = offset + remote_batch_command_size;
+          }
+          result = result + _SIPOs.submit_batch(commands, chunk);
+          num_commands = num_commands - chunk;
+        }
+        data        = &result;
+        data_length = 1;
+        break;
+      }
+    default:
+      status = remote_unknown_command;
+      break;
+  }
+  respond(sequence, command, status, data, data_length);
+  if (!resent) {
+    _in_sequence   = true;
+    _next_sequence = sequence + 1;
+    _sent_statuses[sequence % remote_max_outstanding] = status;
+    _sent_results[sequence % remote_max_outstanding]  = result;
+  }
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sends a response frame of the given status followed by num_bytes bytes.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+void SIPO8_remote::respond(uint8_t sequence, uint8_t command, uint8_t status,
+                           const uint8_t * bytes, uint8_t num_bytes) {
+  uint8_t header[5] = {remote_sync, sequence, (uint8_t)(command | remote_response),
+                       (uint8_t)(num_bytes + 1), status
+                      };
+  uint16_t crc = 0xFFFF;
+  for (uint8_t header_byte = 1; header_byte < sizeof(header); header_byte++) {
+    crc = crc16(crc, header[header_byte]);
+  }
+  for (uint8_t data_byte = 0; data_byte < num_bytes; data_byte++) {
+    crc = crc16(crc, bytes[data_byte]);
+  }
+  uint8_t crc_bytes[2] = {(uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8)};
+  _stream.write(header, sizeof(header));
+  if (num_bytes > 0) _stream.write(bytes, num_bytes);
+  _stream.write(crc_bytes, sizeof(crc_bytes));
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Checks the CRC of the frame of the given payload length at the head of the
+// receive buffer.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+bool SIPO8_remote::frame_valid(uint8_t length) {
+  uint16_t crc = 0xFFFF;
+  for (uint16_t offset = 1; offset < 4 + length; offset++) {
+    crc = crc16(crc, peek(offset));
+  }
+  return crc == (peek(4 + length) | peek(5 + length) << 8);
+}
+
+uint16_t SIPO8_remote::crc16(uint16_t crc, uint8_t next_byte) {
+  return (crc << 8) ^ pgm_read_word(&crc_table[(crc >> 8) ^ next_byte]);
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Receive buffer access, by offset from the oldest byte held.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+uint8_t SIPO8_remote::peek(uint16_t offset) {
+  uint16_t position = _head + offset;
+  if (position >= _buffer_size) position = position - _buffer_size;
+  return _buffer[position];
+}
+
+// a status byte or bank number, of remote_offset_size bytes, little endian
+SIPO8_pin SIPO8_remote::peek_offset(uint16_t offset) {
+#if remote_offset_size == 2
+  return peek(offset) | (SIPO8_pin)peek(offset + 1) << 8;
+#else
+  return peek(offset);
+#endif
+}
+
+void SIPO8_remote::discard(uint16_t num_bytes) {
+  _head = _head + num_bytes;
+  if (_head >= _buffer_size) _head = _head - _buffer_size;
+  _count = _count - num_bytes;
+}
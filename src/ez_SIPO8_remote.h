@@ -0,0 +1,149 @@
+/*
+   Ron D Bentley, Stafford, UK
+   April 2021
+   SIPO8 v1-00
+
+   Remote control of a SIPO8 object over a serial (or any Stream) link, by a
+   compact binary framed protocol - for driving SIPO arrays from a host PC. The
+   received bytes are kept in a ring buffer and parsed as they arrive, without
+   blocking, each frame being checked by CRC before it is acted on.
+
+   extras/host/SIPO8_remote_client.h is a reference client for the host.
+
+   This example and code is in the public domain and
+   may be used without restriction and without warranty.
+
+*/
+
+#ifndef SIPO8_remote_h
+#define SIPO8_remote_h
+
+#include <Arduino.h>
+#include <ez_SIPO8_lib.h>
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Frame format, the same for requests (host to SIPO8_remote) and responses:
+//   sync      1 byte  - remote_sync
+//   sequence  1 byte  - chosen by the host, returned in the response
+//   command   1 byte  - a request command, or the command | remote_response
+//   length    1 byte  - payload bytes, 0-255
+//   payload   length bytes
+//   CRC       2 bytes - CRC-16/CCITT-FALSE (polynomial 0x1021, initial value
+//                       0xFFFF) of the sequence, command, length and payload
+//                       bytes, little endian
+// Requests are applied strictly in sequence, each answered by a response whose
+// first payload byte is a status, remote_ok etc, followed by any data read:
+// - a request whose sequence follows that of the request applied last is applied
+// - a request with one of the last remote_max_outstanding sequences applied has
+//   been resent, as its response was lost, and is answered again, as it was first
+//   answered, without being applied again (reads are read again)
+// - any other request is ignored, as a request before it has been lost
+// - remote_read_info is always applied, and the sequence continues from its own
+// Requests failing their CRC are ignored. So a host may send up to
+// remote_max_outstanding requests ahead of their responses, as far as the
+// receive buffer holds them, and if a response does not arrive in time resend,
+// in order, every request not yet answered - after 255 + remote_frame_overhead
+// bytes other than remote_sync, to complete any request whose length byte was
+// corrupted, for which the remote would otherwise wait.
+//
+// Request payloads, multi byte values little endian:
+//   remote_write_bytes   first status byte (remote_offset_size bytes), then the
+//                        status bytes (1 to 255 - remote_offset_size) to write
+//                        to pin_status_bytes from it
+//   remote_fill_banks    from bank, to bank (remote_offset_size bytes each), pin
+//                        status (LOW/HIGH) - set_banks
+//   remote_invert_banks  from bank, to bank (remote_offset_size bytes each) -
+//                        invert_banks
+//   remote_xfer          msb_or_lsb, then remote_xfer_dirty or remote_xfer_array
+//   remote_read_bytes    source (remote_pin_statuses, remote_committed_statuses or
+//                        remote_input_statuses), first byte (remote_offset_size
+//                        bytes), number of bytes (1-254) - the response carries
+//                        the bytes after its status
+//   remote_read_info     none - the response carries remote_protocol_version,
+//                        remote_offset_size, then num_banks, bank_SIPO_count,
+//                        num_input_banks, input status bytes and the receive
+//                        buffer size, which is the longest request frame
+//                        accepted, of 2 bytes each
+//   remote_batch         batch commands (see SIPO8::submit_batch) of
+//                        remote_batch_command_size bytes each - op, bank
+//                        (remote_offset_size bytes), index (2 bytes), value - the
+//                        response carries the number of commands applied
+// Status bytes and banks are addressed by remote_offset_size bytes, 1, or 2 with
+// SIPO8_INDEX_BITS above 8, so that with wider indices every status byte and bank
+// is remote up to 65535 of them. remote_read_info reports counts of at most 65535.
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#define remote_protocol_version  2
+#if SIPO8_INDEX_BITS > 8
+#define remote_offset_size       2   // bytes addressing a status byte or bank
+#else
+#define remote_offset_size       1
+#endif
+#define remote_sync              0xA5
+#define remote_frame_overhead    6   // frame bytes other than the payload
+#define remote_response          0x80
+#define remote_max_outstanding   16  // requests a host may send ahead of their responses
+
+// request commands...
+#define remote_write_bytes       0x01
+#define remote_fill_banks        0x02
+#define remote_invert_banks      0x03
+#define remote_xfer              0x04
+#define remote_read_bytes        0x05
+#define remote_read_info         0x06
+#define remote_batch             0x07
+
+// response statuses...
+#define remote_ok                0
+#define remote_unknown_command   1
+#define remote_bad_length        2
+#define remote_out_of_range      3
+
+// remote_xfer and remote_read_bytes options...
+#define remote_xfer_dirty        0
+#define remote_xfer_array        1
+#define remote_pin_statuses      0
+#define remote_committed_statuses 1
+#define remote_input_statuses    2
+
+#define remote_batch_command_size (4 + remote_offset_size)
+
+class SIPO8_remote
+{
+  public:
+
+    uint32_t num_frames     = 0; // requests handled
+    uint32_t num_crc_errors = 0; // frames failing their CRC
+    uint32_t num_discarded  = 0; // bytes discarded looking for a frame
+
+    // ******* function declarations....
+
+    SIPO8_remote(SIPO8 &, Stream &);
+
+    bool begin(uint16_t);
+    void end();
+    uint16_t update();
+
+    static uint16_t crc16(uint16_t, uint8_t);
+
+    // ****** private declarations.....
+  private:
+    SIPO8 &  _SIPOs;
+    Stream & _stream;
+    uint8_t * _buffer        = NULL; // receive ring buffer...
+    uint16_t _buffer_size    = 0;
+    uint16_t _head           = 0;    // ...oldest byte
+    uint16_t _count          = 0;    // ...bytes held
+    bool     _in_sequence    = false; // true once a request has been applied...
+    uint8_t  _next_sequence  = 0;     // ...and the sequence of the next to be applied
+    uint8_t  _sent_statuses[remote_max_outstanding]; // responses to the requests applied
+    uint8_t  _sent_results[remote_max_outstanding];  // last, by sequence, for resends
+
+    uint8_t  peek(uint16_t);
+    SIPO8_pin peek_offset(uint16_t);
+    void     discard(uint16_t);
+    bool     frame_valid(uint8_t);
+    void     handle_frame(uint8_t, uint8_t, uint8_t);
+    void     respond(uint8_t, uint8_t, uint8_t, const uint8_t *, uint8_t);
+};
+
+#endif